@@ -0,0 +1,161 @@
+#ifndef BAKE_SCENE_H
+#define BAKE_SCENE_H
+
+#include <glm/glm.hpp>
+
+#include "learnopengl/bvh.h"
+#include "learnopengl/uniform_blocks.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <vector>
+
+// Static geometry and lights for the CPU bakers (LightmapBaker, IrradianceProbes). Meshes are triangle lists
+// in model space; instances place them with a model matrix and give them a flat diffuse albedo for bounced
+// light. Lights come straight from the chapter's Lights block, so the bake sees what the shaders see.
+//
+// Lighting follows the chapters' Phong conventions (no 1/pi): a surface facing a light gets light.diffuse *
+// N.L * attenuation, and a surface of albedo a lit with irradiance E sends a * E back out.
+class BakeScene {
+public:
+    struct Instance {
+        int mesh;
+        glm::mat4 model;
+        glm::vec3 albedo;
+        unsigned int firstTriangle; // into the world-space triangle list
+    };
+
+    // small xorshift generator, one per worker so results don't depend on scheduling
+    struct Random {
+        std::uint32_t state;
+
+        explicit Random(std::uint32_t seed) : state(seed * 2654435761u + 1u) {}
+
+        float next() {
+            state ^= state << 13;
+            state ^= state >> 17;
+            state ^= state << 5;
+            return (state >> 8) * (1.0f / 16777216.0f);
+        }
+    };
+
+    float rayBias = 1e-3f; // start offset of secondary rays, against self-intersection
+
+    // returns the mesh's index; positions are a triangle list
+    int addMesh(const std::vector<glm::vec3>& positions) {
+        meshes.push_back(positions);
+        return (int)meshes.size() - 1;
+    }
+
+    int addInstance(int mesh, const glm::mat4& model, const glm::vec3& albedo) {
+        Instance instance = { mesh, model, albedo, (unsigned int)(worldVertices.size() / 3) };
+        for (const glm::vec3& p : meshes[mesh])
+            worldVertices.push_back(glm::vec3(model * glm::vec4(p, 1.0f)));
+        for (unsigned int t = instance.firstTriangle; t < worldVertices.size() / 3; t++)
+            triangleInstance.push_back((int)sceneInstances.size());
+        sceneInstances.push_back(instance);
+        return (int)sceneInstances.size() - 1;
+    }
+
+    // the directional light and the first nrPointLights point lights; the flashlight is left dynamic
+    void setLights(const LightsBlock& lights) {
+        dirLight = lights.dirLight;
+        staticPointLights.assign(lights.pointLights, lights.pointLights + lights.nrPointLights);
+    }
+
+    // call after the last addInstance
+    void build() {
+        bvh.build(worldVertices);
+    }
+
+    const std::vector<glm::vec3>& mesh(int index) const { return meshes[index]; }
+    const std::vector<Instance>& instances() const { return sceneInstances; }
+    const std::vector<glm::vec3>& vertices() const { return worldVertices; }
+    const DirectionalLightStd140& directionalLight() const { return dirLight; }
+    const std::vector<PointLightStd140>& pointLights() const { return staticPointLights; }
+
+    // world-space unit normal of a triangle
+    glm::vec3 triangleNormal(unsigned int triangle) const {
+        const glm::vec3* v = &worldVertices[3 * triangle];
+        return glm::normalize(glm::cross(v[1] - v[0], v[2] - v[0]));
+    }
+
+    // the lights' ambient terms, which reach every point regardless of visibility
+    glm::vec3 ambient(const glm::vec3& position) const {
+        glm::vec3 result = dirLight.ambient;
+        for (const PointLightStd140& light : staticPointLights)
+            result += light.ambient * attenuation(light, glm::length(light.position - position));
+        return result;
+    }
+
+    // diffuse irradiance from the lights at a point with the given normal, with shadow rays
+    glm::vec3 directIrradiance(const glm::vec3& position, const glm::vec3& normal) const {
+        glm::vec3 origin = position + normal * rayBias;
+        glm::vec3 result(0.0f);
+
+        glm::vec3 toSun = -glm::normalize(dirLight.direction);
+        float sunCos = glm::dot(normal, toSun);
+        if (sunCos > 0.0f && !bvh.occluded(origin, toSun, INFINITY))
+            result += dirLight.diffuse * sunCos;
+
+        for (const PointLightStd140& light : staticPointLights) {
+            glm::vec3 toLight = light.position - origin;
+            float distance = glm::length(toLight);
+            glm::vec3 lightDir = toLight / distance;
+            float cosine = glm::dot(normal, lightDir);
+            if (cosine > 0.0f && !bvh.occluded(origin, lightDir, distance))
+                result += light.diffuse * cosine * attenuation(light, distance);
+        }
+        return result;
+    }
+
+    // light arriving along a ray after one bounce: the direct light the hit surface reflects. misses see black,
+    // the ambient terms stand in for the sky. distance, if given, receives the hit distance (INFINITY on a miss).
+    glm::vec3 bouncedRadiance(const glm::vec3& origin, const glm::vec3& direction, float* distance = nullptr) const {
+        Bvh::Hit hit;
+        bool found = bvh.intersect(origin, direction, INFINITY, hit);
+        if (distance)
+            *distance = found ? hit.t : INFINITY;
+        if (!found)
+            return glm::vec3(0.0f);
+
+        glm::vec3 normal = triangleNormal(hit.triangle);
+        if (glm::dot(normal, direction) > 0.0f)
+            normal = -normal; // back side, e.g. inside of a mesh
+        glm::vec3 position = origin + direction * hit.t;
+        return sceneInstances[triangleInstance[hit.triangle]].albedo * directIrradiance(position, normal);
+    }
+
+    // cosine-weighted direction around normal
+    static glm::vec3 sampleHemisphere(const glm::vec3& normal, Random& random) {
+        float r = std::sqrt(random.next());
+        float phi = 6.28318531f * random.next();
+        glm::vec3 tangent = glm::normalize(glm::cross(std::abs(normal.x) > 0.5f ? glm::vec3(0.0f, 1.0f, 0.0f) : glm::vec3(1.0f, 0.0f, 0.0f), normal));
+        glm::vec3 bitangent = glm::cross(normal, tangent);
+        return tangent * (r * std::cos(phi)) + bitangent * (r * std::sin(phi)) + normal * std::sqrt(std::max(0.0f, 1.0f - r * r));
+    }
+
+    // uniform direction on the sphere
+    static glm::vec3 sampleSphere(Random& random) {
+        float z = 1.0f - 2.0f * random.next();
+        float r = std::sqrt(std::max(0.0f, 1.0f - z * z));
+        float phi = 6.28318531f * random.next();
+        return glm::vec3(r * std::cos(phi), r * std::sin(phi), z);
+    }
+
+private:
+    std::vector<std::vector<glm::vec3>> meshes;
+    std::vector<Instance> sceneInstances;
+    std::vector<glm::vec3> worldVertices;
+    std::vector<int> triangleInstance;
+    DirectionalLightStd140 dirLight = {};
+    std::vector<PointLightStd140> staticPointLights;
+    Bvh bvh;
+
+    static float attenuation(const PointLightStd140& light, float distance) {
+        return 1.0f / (light.constant + light.linear * distance + light.quadratic * distance * distance);
+    }
+};
+
+#endif
@@ -0,0 +1,278 @@
+#ifndef BVH_H
+#define BVH_H
+
+#include <glm/glm.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <vector>
+
+// Bounding volume hierarchy over a triangle soup, for CPU ray tracing (the bakers in lightmap_baker.h and
+// irradiance_probes.h). Built once with binned SAH splits into a flat node array; queries are const and
+// thread-safe, so one Bvh serves every worker of a ThreadPool.
+//
+//     Bvh bvh;
+//     bvh.build(vertices);                                // three world-space vertices per triangle
+//     Bvh::Hit hit;
+//     if (bvh.intersect(origin, direction, tMax, hit))    // closest hit
+//         ... hit.triangle, hit.t, hit.u, hit.v ...
+//     bool shadowed = bvh.occluded(origin, direction, tMax); // any hit, for shadow rays
+class Bvh {
+public:
+    struct Hit {
+        float t;
+        unsigned int triangle; // index into the build() vertices / 3
+        float u, v;            // barycentrics of the second and third vertex
+    };
+
+    void build(const std::vector<glm::vec3>& vertices) {
+        unsigned int nrTriangles = (unsigned int)(vertices.size() / 3);
+        triangles.resize(nrTriangles);
+        order.resize(nrTriangles);
+        std::vector<glm::vec3> centroids(nrTriangles);
+        for (unsigned int i = 0; i < nrTriangles; i++) {
+            Triangle& tri = triangles[i];
+            tri.v0 = vertices[3 * i];
+            tri.edge1 = vertices[3 * i + 1] - tri.v0;
+            tri.edge2 = vertices[3 * i + 2] - tri.v0;
+            centroids[i] = tri.v0 + (tri.edge1 + tri.edge2) / 3.0f;
+            order[i] = i;
+        }
+
+        nodes.clear();
+        nodes.reserve(2 * std::max(1u, nrTriangles));
+        nodes.push_back(Node());
+        if (nrTriangles > 0)
+            split(0, 0, nrTriangles, 0, centroids);
+
+        // reorder the triangles so every leaf is a contiguous run
+        std::vector<Triangle> sorted(nrTriangles);
+        for (unsigned int i = 0; i < nrTriangles; i++)
+            sorted[i] = triangles[order[i]];
+        triangles.swap(sorted);
+    }
+
+    bool intersect(const glm::vec3& origin, const glm::vec3& direction, float tMax, Hit& hit) const {
+        hit.t = tMax;
+        return traverse(origin, direction, hit, false);
+    }
+
+    bool occluded(const glm::vec3& origin, const glm::vec3& direction, float tMax) const {
+        Hit hit;
+        hit.t = tMax;
+        return traverse(origin, direction, hit, true);
+    }
+
+    std::size_t size() const {
+        return triangles.size();
+    }
+
+private:
+    static const int BINS = 12;
+    static const int MAX_LEAF_TRIANGLES = 4;
+    // deepest a leaf can be; traversal's fixed stack holds at most one node per level above it
+    static const int MAX_DEPTH = 64;
+
+    struct Triangle {
+        glm::vec3 v0, edge1, edge2;
+    };
+
+    // leaves have count > 0 and index their first triangle; inner nodes have their left child at first and
+    // the right one right after it
+    struct Node {
+        glm::vec3 boundsMin = glm::vec3(INFINITY);
+        glm::vec3 boundsMax = glm::vec3(-INFINITY);
+        unsigned int first = 0;
+        unsigned int count = 0;
+    };
+
+    struct Bounds {
+        glm::vec3 min = glm::vec3(INFINITY);
+        glm::vec3 max = glm::vec3(-INFINITY);
+
+        void grow(const glm::vec3& p) {
+            min = glm::min(min, p);
+            max = glm::max(max, p);
+        }
+        void grow(const Bounds& b) {
+            min = glm::min(min, b.min);
+            max = glm::max(max, b.max);
+        }
+        float area() const {
+            glm::vec3 e = max - min;
+            return e.x < 0.0f ? 0.0f : 2.0f * (e.x * e.y + e.y * e.z + e.z * e.x);
+        }
+    };
+
+    std::vector<Triangle> triangles;
+    std::vector<unsigned int> order;
+    std::vector<Node> nodes;
+
+    Bounds triangleBounds(unsigned int index) const {
+        const Triangle& tri = triangles[index];
+        Bounds b;
+        b.grow(tri.v0);
+        b.grow(tri.v0 + tri.edge1);
+        b.grow(tri.v0 + tri.edge2);
+        return b;
+    }
+
+    void split(unsigned int nodeIndex, unsigned int first, unsigned int count, int depth, const std::vector<glm::vec3>& centroids) {
+        Bounds bounds, centroidBounds;
+        for (unsigned int i = first; i < first + count; i++) {
+            bounds.grow(triangleBounds(order[i]));
+            centroidBounds.grow(centroids[order[i]]);
+        }
+        nodes[nodeIndex].boundsMin = bounds.min;
+        nodes[nodeIndex].boundsMax = bounds.max;
+
+        // cheapest binned split over the three axes; stay a leaf if nothing beats intersecting everything
+        int bestAxis = -1, bestBin = 0;
+        float bestCost = count <= (unsigned int)MAX_LEAF_TRIANGLES ? bounds.area() * count : INFINITY;
+        for (int axis = 0; axis < 3; axis++) {
+            float extent = centroidBounds.max[axis] - centroidBounds.min[axis];
+            if (extent <= 0.0f)
+                continue;
+
+            Bounds binBounds[BINS];
+            unsigned int binCounts[BINS] = {};
+            float scale = BINS / extent;
+            for (unsigned int i = first; i < first + count; i++) {
+                int bin = std::min(BINS - 1, (int)((centroids[order[i]][axis] - centroidBounds.min[axis]) * scale));
+                binCounts[bin]++;
+                binBounds[bin].grow(triangleBounds(order[i]));
+            }
+
+            // sweep from the right, then from the left, to price every boundary
+            float rightArea[BINS];
+            unsigned int rightCount[BINS];
+            Bounds right;
+            unsigned int rightSum = 0;
+            for (int bin = BINS - 1; bin > 0; bin--) {
+                right.grow(binBounds[bin]);
+                rightSum += binCounts[bin];
+                rightArea[bin] = right.area();
+                rightCount[bin] = rightSum;
+            }
+            Bounds left;
+            unsigned int leftSum = 0;
+            for (int bin = 0; bin < BINS - 1; bin++) {
+                left.grow(binBounds[bin]);
+                leftSum += binCounts[bin];
+                if (leftSum == 0 || rightCount[bin + 1] == 0)
+                    continue;
+                float cost = left.area() * leftSum + rightArea[bin + 1] * rightCount[bin + 1];
+                if (cost < bestCost) {
+                    bestCost = cost;
+                    bestAxis = axis;
+                    bestBin = bin;
+                }
+            }
+        }
+
+        if (bestAxis < 0 || depth >= MAX_DEPTH) {
+            // no useful split (only happens for piles of identical centroids) or as deep as traversal goes: a
+            // leaf, however big
+            nodes[nodeIndex].first = first;
+            nodes[nodeIndex].count = count;
+            return;
+        }
+
+        float scale = BINS / (centroidBounds.max[bestAxis] - centroidBounds.min[bestAxis]);
+        unsigned int* middle = std::partition(order.data() + first, order.data() + first + count, [&](unsigned int tri) {
+            return std::min(BINS - 1, (int)((centroids[tri][bestAxis] - centroidBounds.min[bestAxis]) * scale)) <= bestBin;
+        });
+        unsigned int leftCount = (unsigned int)(middle - (order.data() + first));
+
+        unsigned int leftChild = (unsigned int)nodes.size();
+        nodes.push_back(Node());
+        nodes.push_back(Node());
+        nodes[nodeIndex].first = leftChild;
+        nodes[nodeIndex].count = 0;
+        split(leftChild, first, leftCount, depth + 1, centroids);
+        split(leftChild + 1, first + leftCount, count - leftCount, depth + 1, centroids);
+    }
+
+    // slab test; returns the entry distance, or INFINITY on a miss
+    static float hitBounds(const Node& node, const glm::vec3& origin, const glm::vec3& invDirection, float tMax) {
+        glm::vec3 t0 = (node.boundsMin - origin) * invDirection;
+        glm::vec3 t1 = (node.boundsMax - origin) * invDirection;
+        glm::vec3 tNear = glm::min(t0, t1);
+        glm::vec3 tFar = glm::max(t0, t1);
+        float enter = std::max(std::max(tNear.x, tNear.y), std::max(tNear.z, 0.0f));
+        float exit = std::min(std::min(tFar.x, tFar.y), std::min(tFar.z, tMax));
+        return enter <= exit ? enter : INFINITY;
+    }
+
+    // Moller-Trumbore, double sided
+    static bool hitTriangle(const Triangle& tri, const glm::vec3& origin, const glm::vec3& direction, float& t, float& u, float& v) {
+        glm::vec3 p = glm::cross(direction, tri.edge2);
+        float det = glm::dot(tri.edge1, p);
+        if (std::abs(det) < 1e-12f)
+            return false;
+        float invDet = 1.0f / det;
+        glm::vec3 s = origin - tri.v0;
+        u = glm::dot(s, p) * invDet;
+        if (u < 0.0f || u > 1.0f)
+            return false;
+        glm::vec3 q = glm::cross(s, tri.edge1);
+        v = glm::dot(direction, q) * invDet;
+        if (v < 0.0f || u + v > 1.0f)
+            return false;
+        t = glm::dot(tri.edge2, q) * invDet;
+        return t > 0.0f;
+    }
+
+    bool traverse(const glm::vec3& origin, const glm::vec3& direction, Hit& hit, bool anyHit) const {
+        if (triangles.empty())
+            return false;
+
+        glm::vec3 invDirection = 1.0f / direction; // +-inf for axis-parallel rays works with the slab test
+        unsigned int stack[MAX_DEPTH];
+        int stackSize = 0;
+        unsigned int nodeIndex = 0;
+        bool found = false;
+        if (hitBounds(nodes[0], origin, invDirection, hit.t) == INFINITY)
+            return false;
+
+        while (true) {
+            const Node& node = nodes[nodeIndex];
+            if (node.count > 0) {
+                for (unsigned int i = node.first; i < node.first + node.count; i++) {
+                    float t, u, v;
+                    if (hitTriangle(triangles[i], origin, direction, t, u, v) && t < hit.t) {
+                        hit.t = t;
+                        hit.u = u;
+                        hit.v = v;
+                        hit.triangle = order[i];
+                        found = true;
+                        if (anyHit)
+                            return true;
+                    }
+                }
+            } else {
+                // visit the nearer child first, keep the other for later
+                unsigned int near = node.first, far = node.first + 1;
+                float tNear = hitBounds(nodes[near], origin, invDirection, hit.t);
+                float tFar = hitBounds(nodes[far], origin, invDirection, hit.t);
+                if (tFar < tNear) {
+                    std::swap(near, far);
+                    std::swap(tNear, tFar);
+                }
+                if (tNear != INFINITY) {
+                    if (tFar != INFINITY) // never overflows: split() stops at MAX_DEPTH
+                        stack[stackSize++] = far;
+                    nodeIndex = near;
+                    continue;
+                }
+            }
+            if (stackSize == 0)
+                break;
+            nodeIndex = stack[--stackSize];
+        }
+        return found;
+    }
+};
+
+#endif
@@ -0,0 +1,292 @@
+#ifndef CASCADED_SHADOWS_H
+#define CASCADED_SHADOWS_H
+
+#include <glad/glad.h>
+
+#include <glm/glm.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+
+#include "learnopengl/gl_state.h"
+#include "learnopengl/shader.h"
+
+#include <algorithm>
+#include <cmath>
+#include <functional>
+#include <iostream>
+#include <string>
+#include <vector>
+
+// something that casts a shadow: its model matrix and its bounding box in model space
+struct ShadowCaster {
+    glm::mat4 model;
+    glm::vec3 boundsMin;
+    glm::vec3 boundsMax;
+};
+
+// Cascaded shadow maps for one directional light, sampled by src/shaders/shadows.glsl.
+//
+// update() splits the view frustum (up to shadowDistance) into NR_CASCADES slices on the CPU, blending
+// logarithmic and uniform splits, and fits an orthographic light projection around each slice's bounding
+// sphere. The sphere doesn't change as the camera turns, and the projection is snapped to whole steps of
+// 1/SNAP_DIVISIONS of its width (each a whole number of texels), so a cascade only changes when the camera
+// moves a step: edges don't shimmer, and static casters rendered into it stay valid until then.
+//
+// render() draws each cascade into one layer of a depth texture array. Static casters go into a cache layer
+// that is redrawn only when that cascade's projection changed (or invalidate() was called); otherwise it's
+// copied over and only the dynamic casters are drawn on top. Every caster is culled against the cascade's
+// light frustum first.
+//
+//     CascadedShadowMaps shadows(2048);
+//     shadows.setLight(direction, sceneMin, sceneMax);   // sceneMin/Max enclose every caster
+//     shadows.update(view, projection, 30.0f);           // once per frame
+//     shadows.render(depthShader, staticCasters, dynamicCasters, drawMesh);
+//     shadows.bind(shader, unit);                        // per program that includes shadows.glsl
+//
+// render() leaves its framebuffer bound and the viewport at the shadow map size; restore both afterwards.
+// deleteBuffers() frees both depth arrays (per frame and the static caster cache) and their framebuffers.
+class CascadedShadowMaps {
+public:
+    static const int NR_CASCADES = 4;    // must match shadows.glsl
+    static const int SNAP_DIVISIONS = 16;
+
+    // per cascade, for the last render()
+    struct Stats {
+        int staticDrawn = 0;   // 0 when the cached static layer was reused
+        int dynamicDrawn = 0;
+        int culled = 0;        // static (only counted when redrawn) and dynamic casters outside the cascade
+        bool staticCached = false;
+    };
+
+    unsigned int depthMaps; // GL_TEXTURE_2D_ARRAY, one layer per cascade, compare mode on
+    int resolution;
+    float splitLambda = 0.75f; // 0 = uniform splits, 1 = logarithmic
+
+    // depth bias while rendering casters (glPolygonOffset factor, units)
+    float slopeBias = 2.0f;
+    float constantBias = 4.0f;
+
+    explicit CascadedShadowMaps(int resolution) : resolution(resolution) {
+        depthMaps = makeDepthArray(true);
+        staticMaps = makeDepthArray(false);
+
+        glGenFramebuffers(1, &FBO);
+        glGenFramebuffers(1, &copyFBO);
+        GLState::bindFramebuffer(GL_FRAMEBUFFER, FBO);
+        glFramebufferTextureLayer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, depthMaps, 0, 0);
+        glDrawBuffer(GL_NONE);
+        glReadBuffer(GL_NONE);
+        if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE)
+            std::cout << "\033[1;31m" << "ERROR::CASCADED_SHADOWS::FRAMEBUFFER_INCOMPLETE" << "\033[0m" << std::endl;
+        GLState::bindFramebuffer(GL_FRAMEBUFFER, copyFBO);
+        glDrawBuffer(GL_NONE);
+        glReadBuffer(GL_NONE);
+        GLState::bindFramebuffer(GL_FRAMEBUFFER, 0);
+    }
+
+    CascadedShadowMaps(const CascadedShadowMaps&) = delete;
+    CascadedShadowMaps& operator=(const CascadedShadowMaps&) = delete;
+
+    // direction the light travels in (DirectionalLight::direction); sceneMin/sceneMax is a world-space box
+    // around every caster, which sets how far towards the light each cascade reaches
+    void setLight(const glm::vec3& direction, const glm::vec3& sceneMin, const glm::vec3& sceneMax) {
+        glm::vec3 dir = glm::normalize(direction);
+        glm::vec3 up = std::abs(dir.y) > 0.99f ? glm::vec3(0.0f, 0.0f, 1.0f) : glm::vec3(0.0f, 1.0f, 0.0f);
+        lightView = glm::lookAt(glm::vec3(0.0f), dir, up);
+
+        // scene depth range along the light; the ortho near/far planes of every cascade
+        lightMinZ = INFINITY;
+        lightMaxZ = -INFINITY;
+        for (int corner = 0; corner < 8; corner++) {
+            glm::vec3 p((corner & 1) ? sceneMax.x : sceneMin.x, (corner & 2) ? sceneMax.y : sceneMin.y, (corner & 4) ? sceneMax.z : sceneMin.z);
+            float z = (lightView * glm::vec4(p, 1.0f)).z;
+            lightMinZ = std::min(lightMinZ, z);
+            lightMaxZ = std::max(lightMaxZ, z);
+        }
+        invalidate();
+    }
+
+    // splits and light projections for this frame's camera; shadows end at shadowDistance (or the far plane)
+    void update(const glm::mat4& view, const glm::mat4& projection, float shadowDistance) {
+        float nearPlane = projection[3][2] / (projection[2][2] - 1.0f);
+        float farPlane = std::min(projection[3][2] / (projection[2][2] + 1.0f), shadowDistance);
+        float tanHalfX = 1.0f / projection[0][0];
+        float tanHalfY = 1.0f / projection[1][1];
+        glm::mat4 inverseView = glm::inverse(view);
+
+        float sliceNear = nearPlane;
+        for (int i = 0; i < NR_CASCADES; i++) {
+            float t = (float)(i + 1) / NR_CASCADES;
+            float logSplit = nearPlane * std::pow(farPlane / nearPlane, t);
+            float uniformSplit = nearPlane + (farPlane - nearPlane) * t;
+            float sliceFar = splitLambda * logSplit + (1.0f - splitLambda) * uniformSplit;
+            splits[i] = sliceFar;
+
+            // smallest sphere around the slice: centered on the view axis, through the far corners and, if
+            // it's closer to them, the near corners too
+            float k = tanHalfX * tanHalfX + tanHalfY * tanHalfY;
+            float centerDepth = std::min(0.5f * (sliceNear + sliceFar) * (1.0f + k), sliceFar);
+            float farOffset = sliceFar - centerDepth;
+            float nearOffset = centerDepth - sliceNear;
+            float radius = std::sqrt(std::max(farOffset * farOffset + sliceFar * sliceFar * k, nearOffset * nearOffset + sliceNear * sliceNear * k));
+            radius = std::ceil(radius * 16.0f) / 16.0f; // keep float noise out of the extent
+            glm::vec3 center = glm::vec3(inverseView * glm::vec4(0.0f, 0.0f, -centerDepth, 1.0f));
+
+            // grow the box so the sphere still fits after snapping the center by up to half a step
+            float halfExtent = radius * SNAP_DIVISIONS / (SNAP_DIVISIONS - 1);
+            float step = 2.0f * halfExtent / SNAP_DIVISIONS;
+            glm::vec3 lightCenter = glm::vec3(lightView * glm::vec4(center, 1.0f));
+            float x = std::round(lightCenter.x / step) * step;
+            float y = std::round(lightCenter.y / step) * step;
+
+            cascades[i].boundsMin = glm::vec3(x - halfExtent, y - halfExtent, lightMinZ);
+            cascades[i].boundsMax = glm::vec3(x + halfExtent, y + halfExtent, lightMaxZ);
+            glm::mat4 lightProjection = glm::ortho(x - halfExtent, x + halfExtent, y - halfExtent, y + halfExtent, -lightMaxZ, -lightMinZ);
+            cascades[i].lightSpaceMatrix = lightProjection * lightView;
+
+            sliceNear = sliceFar;
+        }
+    }
+
+    // forgets the cached static layers, e.g. after a static caster moved
+    void invalidate() {
+        for (Cascade& cascade : cascades)
+            cascade.staticValid = false;
+    }
+
+    // draws every cascade. drawMesh issues the draw call for one caster; the depth shader is current and has
+    // its "lightSpaceMatrix" and "model" uniforms set by then
+    void render(Shader& depthShader, const std::vector<ShadowCaster>& staticCasters, const std::vector<ShadowCaster>& dynamicCasters,
+                const std::function<void(const ShadowCaster&)>& drawMesh) {
+        glViewport(0, 0, resolution, resolution);
+        GLState::enable(GL_DEPTH_TEST);
+        GLState::enable(GL_POLYGON_OFFSET_FILL);
+        glPolygonOffset(slopeBias, constantBias);
+        depthShader.use();
+
+        for (int i = 0; i < NR_CASCADES; i++) {
+            Cascade& cascade = cascades[i];
+            Stats& stats = cascade.stats;
+            stats = Stats();
+            depthShader.setMat4("lightSpaceMatrix", cascade.lightSpaceMatrix);
+
+            bool cached = cascade.staticValid && cascade.staticMatrix == cascade.lightSpaceMatrix;
+            if (!cached) {
+                GLState::bindFramebuffer(GL_FRAMEBUFFER, FBO);
+                glFramebufferTextureLayer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, staticMaps, 0, i);
+                glClear(GL_DEPTH_BUFFER_BIT);
+                drawCasters(depthShader, cascade, staticCasters, drawMesh, stats.staticDrawn, stats.culled);
+                cascade.staticMatrix = cascade.lightSpaceMatrix;
+                cascade.staticValid = true;
+            }
+            stats.staticCached = cached;
+
+            // start from the static layer, then add what moves
+            GLState::bindFramebuffer(GL_READ_FRAMEBUFFER, copyFBO);
+            glFramebufferTextureLayer(GL_READ_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, staticMaps, 0, i);
+            GLState::bindFramebuffer(GL_DRAW_FRAMEBUFFER, FBO);
+            glFramebufferTextureLayer(GL_DRAW_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, depthMaps, 0, i);
+            glBlitFramebuffer(0, 0, resolution, resolution, 0, 0, resolution, resolution, GL_DEPTH_BUFFER_BIT, GL_NEAREST);
+            GLState::bindFramebuffer(GL_FRAMEBUFFER, FBO);
+            drawCasters(depthShader, cascade, dynamicCasters, drawMesh, stats.dynamicDrawn, stats.culled);
+        }
+
+        GLState::disable(GL_POLYGON_OFFSET_FILL);
+    }
+
+    // binds the depth array to unit and sets shadows.glsl's uniforms
+    void bind(Shader& shader, unsigned int unit) {
+        GLState::bindTexture(unit, GL_TEXTURE_2D_ARRAY, depthMaps);
+        shader.setInt("cascadeShadowMaps", unit);
+        for (int i = 0; i < NR_CASCADES; i++)
+            shader.setMat4(cascadeMatrixNames[i], cascades[i].lightSpaceMatrix);
+        shader.setVec4("cascadeSplits", splits[0], splits[1], splits[2], splits[3]);
+    }
+
+    const Stats& stats(int cascade) const {
+        return cascades[cascade].stats;
+    }
+
+    // view-space distance at which cascade i ends
+    float splitDepth(int cascade) const {
+        return splits[cascade];
+    }
+
+    const glm::mat4& lightSpaceMatrix(int cascade) const {
+        return cascades[cascade].lightSpaceMatrix;
+    }
+
+    void deleteBuffers() {
+        GLState::forgetTexture(depthMaps);
+        GLState::forgetTexture(staticMaps);
+        glDeleteTextures(1, &depthMaps);
+        glDeleteTextures(1, &staticMaps);
+        glDeleteFramebuffers(1, &FBO);
+        glDeleteFramebuffers(1, &copyFBO);
+    }
+
+private:
+    static_assert(NR_CASCADES == 4, "cascadeSplits is a vec4");
+
+    struct Cascade {
+        glm::mat4 lightSpaceMatrix = glm::mat4(1.0f);
+        glm::vec3 boundsMin, boundsMax; // light view space
+        glm::mat4 staticMatrix = glm::mat4(1.0f);
+        bool staticValid = false;
+        Stats stats;
+    };
+
+    unsigned int staticMaps;
+    unsigned int FBO, copyFBO;
+    glm::mat4 lightView = glm::mat4(1.0f);
+    float lightMinZ = -1.0f, lightMaxZ = 1.0f;
+    Cascade cascades[NR_CASCADES];
+    float splits[NR_CASCADES] = {};
+    const std::string cascadeMatrixNames[NR_CASCADES] = { "cascadeMatrices[0]", "cascadeMatrices[1]", "cascadeMatrices[2]", "cascadeMatrices[3]" };
+
+    void drawCasters(Shader& depthShader, const Cascade& cascade, const std::vector<ShadowCaster>& casters,
+                     const std::function<void(const ShadowCaster&)>& drawMesh, int& drawn, int& culled) {
+        for (const ShadowCaster& caster : casters) {
+            if (!overlaps(cascade, caster)) {
+                culled++;
+                continue;
+            }
+            depthShader.setMat4("model", caster.model);
+            drawMesh(caster);
+            drawn++;
+        }
+    }
+
+    // the caster's box in light view space against the cascade's; the z range spans the whole scene, so only
+    // x and y can cull
+    bool overlaps(const Cascade& cascade, const ShadowCaster& caster) const {
+        glm::mat4 toLight = lightView * caster.model;
+        glm::vec3 center = 0.5f * (caster.boundsMin + caster.boundsMax);
+        glm::vec3 extent = 0.5f * (caster.boundsMax - caster.boundsMin);
+        glm::vec3 lightCenter = glm::vec3(toLight * glm::vec4(center, 1.0f));
+        glm::vec3 lightExtent(0.0f);
+        for (int axis = 0; axis < 3; axis++)
+            lightExtent += glm::abs(glm::vec3(toLight[axis])) * extent[axis];
+
+        return lightCenter.x + lightExtent.x >= cascade.boundsMin.x && lightCenter.x - lightExtent.x <= cascade.boundsMax.x
+            && lightCenter.y + lightExtent.y >= cascade.boundsMin.y && lightCenter.y - lightExtent.y <= cascade.boundsMax.y;
+    }
+
+    // the sampled array compares in hardware (sampler2DArrayShadow); the static cache is only ever blitted
+    unsigned int makeDepthArray(bool compare) const {
+        unsigned int texture;
+        glGenTextures(1, &texture);
+        GLState::bindTexture(GL_TEXTURE_2D_ARRAY, texture);
+        glTexImage3D(GL_TEXTURE_2D_ARRAY, 0, GL_DEPTH_COMPONENT24, resolution, resolution, NR_CASCADES, 0, GL_DEPTH_COMPONENT, GL_FLOAT, NULL);
+        glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MIN_FILTER, compare ? GL_LINEAR : GL_NEAREST);
+        glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAG_FILTER, compare ? GL_LINEAR : GL_NEAREST);
+        glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+        glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+        if (compare) {
+            glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_COMPARE_MODE, GL_COMPARE_REF_TO_TEXTURE);
+            glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_COMPARE_FUNC, GL_LEQUAL);
+        }
+        return texture;
+    }
+};
+
+#endif
@@ -0,0 +1,139 @@
+#ifndef CLUSTERED_LIGHTING_H
+#define CLUSTERED_LIGHTING_H
+
+#include <glad/glad.h>
+
+#include <glm/glm.hpp>
+
+#include "learnopengl/gl_state.h"
+#include "learnopengl/light_clusters.h"
+#include "learnopengl/light_culling.h"
+#include "learnopengl/shader.h"
+#include "learnopengl/uniform_blocks.h"
+
+#include <cstddef>
+#include <iostream>
+#include <vector>
+
+// one light in the clustered light buffer: PointLightStd140's layout with the cutoff radius in the last slot,
+// so the shader rebuilds a PointLight from four texels and shades it exactly like the Lights block ones
+struct ClusteredPointLight {
+    glm::vec3 position; float constant;
+    glm::vec3 ambient;  float linear;
+    glm::vec3 diffuse;  float quadratic;
+    glm::vec3 specular; float radius;
+};
+
+static_assert(sizeof(ClusteredPointLight) == 64, "ClusteredPointLight is four RGBA32F texels");
+// chapter 16 copies these straight into the Lights block's pointLights[]
+static_assert(sizeof(ClusteredPointLight) == sizeof(PointLightStd140), "ClusteredPointLight must be PointLightStd140-sized");
+static_assert(offsetof(ClusteredPointLight, position) == offsetof(PointLightStd140, position) &&
+              offsetof(ClusteredPointLight, constant) == offsetof(PointLightStd140, constant) &&
+              offsetof(ClusteredPointLight, ambient) == offsetof(PointLightStd140, ambient) &&
+              offsetof(ClusteredPointLight, linear) == offsetof(PointLightStd140, linear) &&
+              offsetof(ClusteredPointLight, diffuse) == offsetof(PointLightStd140, diffuse) &&
+              offsetof(ClusteredPointLight, quadratic) == offsetof(PointLightStd140, quadratic) &&
+              offsetof(ClusteredPointLight, specular) == offsetof(PointLightStd140, specular) &&
+              offsetof(ClusteredPointLight, radius) == offsetof(PointLightStd140, padding0),
+              "ClusteredPointLight must share PointLightStd140's layout, radius in its padding");
+
+// GPU side of clustered forward shading: assigns the frame's lights with LightClusters and uploads the result
+// for src/shaders/clustered.glsl. GL 3.3 has no storage buffers, so the three lists are texture buffers:
+//
+//     clusterLights   RGBA32F  4 texels per light (ClusteredPointLight)
+//     clusterRanges   RG32UI   (offset, count) per cluster
+//     clusterIndices  R32UI    light indices, each cluster's run starting at its offset
+//
+//     ClusteredLighting clustered(2);               // texture units 2, 3 and 4
+//     clustered.update(lights, view, projection);   // once per frame
+//     clustered.bind(shader, width, height);        // per program that includes clustered.glsl
+//
+// deleteBuffers() frees the light, range and index buffers and their buffer textures (see UniformBuffer).
+class ClusteredLighting {
+public:
+    LightClusters clusters;
+
+    explicit ClusteredLighting(unsigned int firstTextureUnit) : firstUnit(firstTextureUnit) {
+        glGenBuffers(NR_BUFFERS, buffers);
+        glGenTextures(NR_BUFFERS, textures);
+        const GLenum formats[NR_BUFFERS] = { GL_RGBA32F, GL_RG32UI, GL_R32UI };
+        for (int i = 0; i < NR_BUFFERS; i++) {
+            glBindBuffer(GL_TEXTURE_BUFFER, buffers[i]);
+            glBufferData(GL_TEXTURE_BUFFER, 16, NULL, GL_STREAM_DRAW);
+            GLState::bindTexture(firstUnit + i, GL_TEXTURE_BUFFER, textures[i]);
+            glTexBuffer(GL_TEXTURE_BUFFER, formats[i], buffers[i]);
+        }
+        glBindBuffer(GL_TEXTURE_BUFFER, 0);
+
+        int maxTexels = 0;
+        glGetIntegerv(GL_MAX_TEXTURE_BUFFER_SIZE, &maxTexels);
+        maxTextureBufferSize = (unsigned int)maxTexels;
+    }
+
+    ClusteredLighting(const ClusteredLighting&) = delete;
+    ClusteredLighting& operator=(const ClusteredLighting&) = delete;
+
+    // lights are in world space; they're culled and assigned in view space and uploaded as given
+    void update(const std::vector<ClusteredPointLight>& lights, const glm::mat4& view, const glm::mat4& projection) {
+        clusters.setProjection(projection);
+
+        spheres.resize(lights.size());
+        for (std::size_t i = 0; i < lights.size(); i++)
+            spheres[i] = glm::vec4(glm::vec3(view * glm::vec4(lights[i].position, 1.0f)), lights[i].radius);
+        clusters.assign(spheres);
+
+        const std::vector<unsigned int>& indices = clusters.indices();
+        if (indices.size() > maxTextureBufferSize && !warnedTooLarge) {
+            std::cout << "\033[1;31m" << "ERROR::CLUSTERED_LIGHTING::INDEX_LIST_EXCEEDS_MAX_TEXTURE_BUFFER_SIZE" << "\033[0m" << std::endl;
+            warnedTooLarge = true;
+        }
+
+        upload(LIGHTS, lights.data(), lights.size() * sizeof(ClusteredPointLight));
+        upload(RANGES, clusters.ranges().data(), clusters.ranges().size() * sizeof(LightClusters::Range));
+        upload(INDICES, indices.data(), std::min<std::size_t>(indices.size(), maxTextureBufferSize) * sizeof(unsigned int));
+    }
+
+    // binds the buffers and sets clustered.glsl's uniforms; width/height is the framebuffer being drawn to
+    void bind(Shader& shader, int width, int height) {
+        for (int i = 0; i < NR_BUFFERS; i++)
+            GLState::bindTexture(firstUnit + i, GL_TEXTURE_BUFFER, textures[i]);
+        shader.setInt("clusterLights", firstUnit + LIGHTS);
+        shader.setInt("clusterRanges", firstUnit + RANGES);
+        shader.setInt("clusterIndices", firstUnit + INDICES);
+        shader.setVec4("clusterParams", (float)LightClusters::TILES_X / width, (float)LightClusters::TILES_Y / height,
+                       clusters.depthScale, clusters.depthBias);
+    }
+
+    void deleteBuffers() {
+        for (int i = 0; i < NR_BUFFERS; i++)
+            GLState::forgetTexture(textures[i]);
+        glDeleteTextures(NR_BUFFERS, textures);
+        glDeleteBuffers(NR_BUFFERS, buffers);
+    }
+
+    // distance at which constant/linear/quadratic attenuation has dimmed the brightest channel to 5/256, the
+    // usual cutoff for lights defined the Phong way
+    static float attenuationRadius(float constant, float linear, float quadratic, const glm::vec3& color) {
+        float brightest = std::max(std::max(color.r, color.g), color.b);
+        return ::attenuationRadius(constant, linear, quadratic, brightest);
+    }
+
+private:
+    enum Buffer { LIGHTS, RANGES, INDICES, NR_BUFFERS };
+
+    unsigned int firstUnit;
+    unsigned int buffers[NR_BUFFERS];
+    unsigned int textures[NR_BUFFERS];
+    unsigned int maxTextureBufferSize = 0;
+    bool warnedTooLarge = false;
+    std::vector<glm::vec4> spheres;
+
+    // orphans the old storage, so the driver doesn't wait for draws still reading last frame's lists
+    void upload(Buffer buffer, const void* data, std::size_t size) {
+        glBindBuffer(GL_TEXTURE_BUFFER, buffers[buffer]);
+        glBufferData(GL_TEXTURE_BUFFER, size > 0 ? size : 16, size > 0 ? data : NULL, GL_STREAM_DRAW);
+        glBindBuffer(GL_TEXTURE_BUFFER, 0);
+    }
+};
+
+#endif
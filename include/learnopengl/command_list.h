@@ -0,0 +1,269 @@
+#ifndef COMMAND_LIST_H
+#define COMMAND_LIST_H
+
+#include <glad/glad.h>
+
+#include <glm/glm.hpp>
+#include <glm/gtc/type_ptr.hpp>
+
+#include "learnopengl/gl_state.h"
+#include "learnopengl/shader.h"
+#include "learnopengl/thread_pool.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <functional>
+#include <vector>
+
+// Draws recorded as plain data (program, bindings, uniforms, draw parameters) and replayed against GL later.
+// Recording makes no GL calls, so any thread can fill a list and tests can read commands() back without a
+// context; execute() runs on the thread that owns the context, through GLState and the program's uniform shadow,
+// so repeated bindings and unchanged values still cost nothing.
+//
+//     list.clear();
+//     list.useProgram(&shader);
+//     list.bindVertexArray(VAO);
+//     list.setMat4("model", model);
+//     list.drawArrays(GL_TRIANGLES, 0, 36);
+//     ...
+//     list.execute();
+//
+// Commands sit in one flat array and uniform values in another, both kept across clear(), so a list that is
+// reused every frame stops allocating once it has grown.
+class CommandList {
+public:
+    enum Type : std::uint8_t {
+        USE_PROGRAM,
+        BIND_VERTEX_ARRAY,
+        BIND_TEXTURE,
+        SET_INT,
+        SET_FLOAT,
+        SET_VEC4,
+        SET_MAT4,
+        DRAW_ARRAYS,
+        DRAW_ELEMENTS
+    };
+
+    struct Command {
+        Type type;
+        union {
+            Shader* shader;                                                                              // USE_PROGRAM
+            unsigned int vertexArray;                                                                    // BIND_VERTEX_ARRAY
+            struct { unsigned int unit; GLenum target; unsigned int texture; } texture;                  // BIND_TEXTURE
+            struct { std::uint32_t name, check; std::int32_t value; } intUniform;                        // SET_INT (name, check: UniformName's hashes)
+            struct { std::uint32_t name, check; std::uint32_t offset; } uniform;                         // SET_FLOAT, SET_VEC4, SET_MAT4: value at values()[offset]
+            struct { GLenum mode; GLint first; GLsizei count; GLsizei instances; } draw;                  // DRAW_ARRAYS
+            struct { GLenum mode; GLsizei count; GLenum indexType; GLuint first; GLsizei instances; } elements; // DRAW_ELEMENTS, first index in the bound element buffer
+        };
+    };
+
+    void clear() {
+        list.clear();
+        floats.clear();
+    }
+
+    void useProgram(Shader* shader) {
+        Command command = make(USE_PROGRAM);
+        command.shader = shader;
+        list.push_back(command);
+    }
+
+    void bindVertexArray(unsigned int vertexArray) {
+        Command command = make(BIND_VERTEX_ARRAY);
+        command.vertexArray = vertexArray;
+        list.push_back(command);
+    }
+
+    void bindTexture(unsigned int unit, GLenum target, unsigned int texture) {
+        Command command = make(BIND_TEXTURE);
+        command.texture = { unit, target, texture };
+        list.push_back(command);
+    }
+
+    // uniforms go to the program of the last useProgram() before them
+    void setInt(UniformName name, int value) {
+        Command command = make(SET_INT);
+        command.intUniform = { name.hash, name.check, value };
+        list.push_back(command);
+    }
+
+    void setFloat(UniformName name, float value) {
+        pushUniform(SET_FLOAT, name, &value, 1);
+    }
+
+    void setVec4(UniformName name, const glm::vec4& value) {
+        pushUniform(SET_VEC4, name, glm::value_ptr(value), 4);
+    }
+
+    void setMat4(UniformName name, const glm::mat4& value) {
+        pushUniform(SET_MAT4, name, glm::value_ptr(value), 16);
+    }
+
+    void drawArrays(GLenum mode, GLint first, GLsizei count, GLsizei instances = 1) {
+        Command command = make(DRAW_ARRAYS);
+        command.draw = { mode, first, count, instances };
+        list.push_back(command);
+    }
+
+    void drawElements(GLenum mode, GLsizei count, GLenum indexType, GLuint first = 0, GLsizei instances = 1) {
+        Command command = make(DRAW_ELEMENTS);
+        command.elements = { mode, count, indexType, first, instances };
+        list.push_back(command);
+    }
+
+    // appends other's commands (its uniform offsets moved past this list's values)
+    void append(const CommandList& other) {
+        std::uint32_t base = (std::uint32_t)floats.size();
+        floats.insert(floats.end(), other.floats.begin(), other.floats.end());
+        std::size_t first = list.size();
+        list.insert(list.end(), other.list.begin(), other.list.end());
+        for (std::size_t i = first; i < list.size(); i++)
+            if (list[i].type == SET_FLOAT || list[i].type == SET_VEC4 || list[i].type == SET_MAT4)
+                list[i].uniform.offset += base;
+    }
+
+    const std::vector<Command>& commands() const {
+        return list;
+    }
+
+    // a SET_FLOAT / SET_VEC4 / SET_MAT4 command's value (1, 4 or 16 floats, a matrix column-major)
+    const float* values(const Command& command) const {
+        return floats.data() + command.uniform.offset;
+    }
+
+    std::size_t size() const {
+        return list.size();
+    }
+
+    // replays the commands on the calling thread, which must own the GL context. uniforms are committed right
+    // before each draw, so they work with batched programs too
+    void execute() const {
+        Shader* shader = nullptr;
+        for (const Command& command : list) {
+            switch (command.type) {
+                case USE_PROGRAM:
+                    shader = command.shader;
+                    shader->use();
+                    break;
+                case BIND_VERTEX_ARRAY:
+                    GLState::bindVertexArray(command.vertexArray);
+                    break;
+                case BIND_TEXTURE:
+                    GLState::bindTexture(command.texture.unit, command.texture.target, command.texture.texture);
+                    break;
+                case SET_INT:
+                    shader->setInt(UniformName(command.intUniform.name, command.intUniform.check), command.intUniform.value);
+                    break;
+                case SET_FLOAT:
+                    shader->setFloat(UniformName(command.uniform.name, command.uniform.check), *values(command));
+                    break;
+                case SET_VEC4: {
+                    const float* v = values(command);
+                    shader->setVec4(UniformName(command.uniform.name, command.uniform.check), v[0], v[1], v[2], v[3]);
+                    break;
+                }
+                case SET_MAT4:
+                    shader->setMat4(UniformName(command.uniform.name, command.uniform.check), glm::make_mat4(values(command)));
+                    break;
+                case DRAW_ARRAYS:
+                    shader->commit();
+                    if (command.draw.instances == 1)
+                        glDrawArrays(command.draw.mode, command.draw.first, command.draw.count);
+                    else
+                        glDrawArraysInstanced(command.draw.mode, command.draw.first, command.draw.count, command.draw.instances);
+                    break;
+                case DRAW_ELEMENTS: {
+                    shader->commit();
+                    std::size_t indexSize = command.elements.indexType == GL_UNSIGNED_BYTE ? 1 : command.elements.indexType == GL_UNSIGNED_SHORT ? 2 : 4;
+                    const void* offset = (const void*)(std::uintptr_t)(command.elements.first * indexSize);
+                    if (command.elements.instances == 1)
+                        glDrawElements(command.elements.mode, command.elements.count, command.elements.indexType, offset);
+                    else
+                        glDrawElementsInstanced(command.elements.mode, command.elements.count, command.elements.indexType, offset, command.elements.instances);
+                    break;
+                }
+            }
+        }
+    }
+
+private:
+    std::vector<Command> list;
+    std::vector<float> floats;
+
+    static Command make(Type type) {
+        Command command;
+        std::memset(&command, 0, sizeof(command));
+        command.type = type;
+        return command;
+    }
+
+    void pushUniform(Type type, UniformName name, const float* value, int count) {
+        Command command = make(type);
+        command.uniform = { name.hash, name.check, (std::uint32_t)floats.size() };
+        floats.insert(floats.end(), value, value + count);
+        list.push_back(command);
+    }
+};
+
+// Records a frame's draws on a ThreadPool. The items are split into fixed chunks and each chunk is recorded into
+// a list of its own by whichever thread picks it up, so no two threads ever write the same buffer; the lists are
+// then replayed in chunk order, which makes the result the same however the chunks were scheduled.
+//
+//     recorder.record(pool, cubes.size(), 4096, [&](CommandList& list, std::size_t first, std::size_t last) {
+//         list.useProgram(&shader);                  // each chunk's list stands on its own
+//         for (std::size_t i = first; i < last; i++)
+//             if (visible(cubes[i])) { list.setMat4("model", cubes[i]); list.drawArrays(GL_TRIANGLES, 0, 36); }
+//     });
+//     recorder.execute();                            // render thread
+class CommandRecorder {
+public:
+    // recordChunk(list, first, last) records items [first, last) into list, which starts out empty
+    void record(ThreadPool& pool, std::size_t count, std::size_t chunkSize,
+                const std::function<void(CommandList&, std::size_t, std::size_t)>& recordChunk) {
+        std::size_t nrChunks = (count + chunkSize - 1) / chunkSize;
+        if (chunks.size() < nrChunks)
+            chunks.resize(nrChunks);
+        nrUsed = nrChunks;
+        pool.parallelFor(nrChunks, [&](std::size_t chunk) {
+            CommandList& list = chunks[chunk];
+            list.clear();
+            recordChunk(list, chunk * chunkSize, std::min(count, (chunk + 1) * chunkSize));
+        });
+    }
+
+    // the lists of the last record(), in chunk order
+    const CommandList& list(std::size_t chunk) const {
+        return chunks[chunk];
+    }
+
+    std::size_t nrLists() const {
+        return nrUsed;
+    }
+
+    // total commands over all lists
+    std::size_t size() const {
+        std::size_t total = 0;
+        for (std::size_t chunk = 0; chunk < nrUsed; chunk++)
+            total += chunks[chunk].size();
+        return total;
+    }
+
+    // all lists merged into one, in chunk order
+    void merge(CommandList& merged) const {
+        merged.clear();
+        for (std::size_t chunk = 0; chunk < nrUsed; chunk++)
+            merged.append(chunks[chunk]);
+    }
+
+    void execute() const {
+        for (std::size_t chunk = 0; chunk < nrUsed; chunk++)
+            chunks[chunk].execute();
+    }
+
+private:
+    std::vector<CommandList> chunks;
+    std::size_t nrUsed = 0;
+};
+
+#endif
@@ -0,0 +1,132 @@
+#ifndef FILE_WATCHER_H
+#define FILE_WATCHER_H
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <filesystem>
+#include <functional>
+#include <string>
+#include <thread>
+#include <vector>
+
+#ifdef __linux__
+#include <poll.h>
+#include <sys/inotify.h>
+#include <unistd.h>
+#endif
+
+// Watches a set of files on a background thread and calls onChange (on that thread) after any of them is
+// written. Editors often save through a temporary file + rename, so the parent directories are watched rather
+// than the files themselves. Uses inotify on Linux and falls back to polling modification times elsewhere.
+class FileWatcher {
+public:
+    FileWatcher(const std::vector<std::string>& paths, std::function<void()> onChange)
+        : onChange(std::move(onChange)) {
+        for (const std::string& path : paths)
+            files.push_back(std::filesystem::absolute(path).lexically_normal());
+        thread = std::thread(&FileWatcher::run, this);
+    }
+
+    ~FileWatcher() {
+        stop = true;
+        if (thread.joinable())
+            thread.join();
+    }
+
+    FileWatcher(const FileWatcher&) = delete;
+    FileWatcher& operator=(const FileWatcher&) = delete;
+
+private:
+    // how long the watcher sleeps between checks for stop, and how long it waits for a burst of writes to settle
+    static constexpr int POLL_INTERVAL_MS = 100;
+    static constexpr int SETTLE_MS = 50;
+
+    std::vector<std::filesystem::path> files;
+    std::function<void()> onChange;
+    std::atomic<bool> stop { false };
+    std::thread thread;
+
+#ifdef __linux__
+    void run() {
+        int fd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+        if (fd < 0) {
+            runPolling();
+            return;
+        }
+
+        std::vector<std::filesystem::path> directories;
+        for (const std::filesystem::path& file : files) {
+            std::filesystem::path directory = file.parent_path();
+            if (std::find(directories.begin(), directories.end(), directory) != directories.end())
+                continue;
+            directories.push_back(directory);
+            inotify_add_watch(fd, directory.c_str(), IN_CLOSE_WRITE | IN_MOVED_TO | IN_CREATE);
+        }
+
+        alignas(inotify_event) char buffer[4096];
+        bool pending = false;
+        while (!stop) {
+            pollfd pfd = { fd, POLLIN, 0 };
+            int ready = poll(&pfd, 1, pending ? SETTLE_MS : POLL_INTERVAL_MS);
+            if (ready == 0 && pending) { // quiet for SETTLE_MS after the last write
+                pending = false;
+                onChange();
+                continue;
+            }
+            if (ready <= 0)
+                continue;
+
+            ssize_t length;
+            while ((length = read(fd, buffer, sizeof(buffer))) > 0) {
+                for (char* ptr = buffer; ptr < buffer + length; ) {
+                    const inotify_event* event = reinterpret_cast<const inotify_event*>(ptr);
+                    if (event->len > 0 && isWatched(event->name))
+                        pending = true;
+                    ptr += sizeof(inotify_event) + event->len;
+                }
+            }
+        }
+        close(fd);
+    }
+
+    bool isWatched(const char* name) const {
+        for (const std::filesystem::path& file : files)
+            if (file.filename() == name)
+                return true;
+        return false;
+    }
+#else
+    void run() {
+        runPolling();
+    }
+#endif
+
+    // portable fallback: compare modification times a few times per second
+    void runPolling() {
+        std::vector<std::filesystem::file_time_type> lastWrite(files.size());
+        for (std::size_t i = 0; i < files.size(); i++)
+            lastWrite[i] = writeTime(files[i]);
+
+        while (!stop) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(POLL_INTERVAL_MS * 2));
+            bool changed = false;
+            for (std::size_t i = 0; i < files.size(); i++) {
+                std::filesystem::file_time_type current = writeTime(files[i]);
+                if (current != lastWrite[i]) {
+                    lastWrite[i] = current;
+                    changed = true;
+                }
+            }
+            if (changed)
+                onChange();
+        }
+    }
+
+    static std::filesystem::file_time_type writeTime(const std::filesystem::path& path) {
+        std::error_code ec;
+        return std::filesystem::last_write_time(path, ec);
+    }
+};
+
+#endif
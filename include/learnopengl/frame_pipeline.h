@@ -0,0 +1,171 @@
+#ifndef FRAME_PIPELINE_H
+#define FRAME_PIPELINE_H
+
+#include <chrono>
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <utility>
+
+// Runs a chapter's scene simulation one frame ahead on a worker thread. Frame N is submitted from one snapshot
+// of the scene while frame N+1's is being simulated into the other, so the render thread only waits when the
+// simulation takes longer than submitting a frame.
+//
+//     FramePipeline<Scene> pipeline([&](Scene& scene, double time) { ... scene at time ... });
+//     while (...) {
+//         const Scene& scene = pipeline.beginFrame(now, now + lastFrameTime);  // waits for this frame's snapshot
+//         glfwPollEvents(); ... camera ...
+//         pipeline.latch();                                                  // input sampled, camera fixed
+//         ... submit from scene ...
+//         glfwSwapBuffers(window);
+//         pipeline.endFrame();
+//     }
+//
+// The camera is not part of the snapshot: reading input and building the view right before submission (the
+// "latch") keeps it as fresh as with no pipelining at all. Simulated time is one frame ahead of when the
+// snapshot is taken, so nextTime should predict when the next frame starts.
+//
+// With setPipelined(false) every snapshot is simulated on the render thread in beginFrame(), for comparison.
+template <typename Snapshot>
+class FramePipeline {
+public:
+    // averages over the frames since the last averages() call, in milliseconds
+    struct Timings {
+        double frame = 0.0;    // endFrame() to endFrame(): throughput
+        double simulate = 0.0; // one snapshot's simulation, on whichever thread ran it
+        double wait = 0.0;     // render thread blocked on the worker in beginFrame()
+        double latency = 0.0;  // latch() to endFrame(): input to presented frame
+    };
+
+    explicit FramePipeline(std::function<void(Snapshot&, double)> simulate)
+        : simulate(std::move(simulate)), worker(&FramePipeline::run, this) {}
+
+    ~FramePipeline() {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            stop = true;
+        }
+        wake.notify_one();
+        worker.join();
+    }
+
+    FramePipeline(const FramePipeline&) = delete;
+    FramePipeline& operator=(const FramePipeline&) = delete;
+
+    void setPipelined(bool pipelined) {
+        this->pipelined = pipelined;
+    }
+
+    bool isPipelined() const {
+        return pipelined;
+    }
+
+    // the snapshot to submit this frame, valid until the next beginFrame(); time is now, nextTime the predicted
+    // start of the next frame, which the worker simulates meanwhile
+    const Snapshot& beginFrame(double time, double nextTime) {
+        Clock::time_point start = Clock::now();
+        if (inFlight) {
+            std::unique_lock<std::mutex> lock(mutex);
+            done.wait(lock, [this]() { return !jobPending; });
+            inFlight = false;
+            front = 1 - front;
+            totals.simulate += workerMilliseconds;
+            totals.wait += milliseconds(start, Clock::now());
+        } else {
+            this->simulate(snapshots[front], time);
+            totals.simulate += milliseconds(start, Clock::now());
+        }
+
+        if (pipelined) {
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                jobTime = nextTime;
+                jobPending = true;
+            }
+            inFlight = true;
+            wake.notify_one();
+        }
+        return snapshots[front];
+    }
+
+    // input has been read and the camera built from it; what the frame shows is from this moment on
+    void latch() {
+        latchTime = Clock::now();
+    }
+
+    // after the buffer swap
+    void endFrame() {
+        Clock::time_point now = Clock::now();
+        if (hasPreviousEnd)
+            totals.frame += milliseconds(previousEnd, now);
+        totals.latency += milliseconds(latchTime, now);
+        previousEnd = now;
+        hasPreviousEnd = true;
+        nrFrames++;
+    }
+
+    // returns the previous averages if no frame finished since the last call
+    Timings averages() {
+        if (nrFrames > 0) {
+            average.frame = totals.frame / nrFrames;
+            average.simulate = totals.simulate / nrFrames;
+            average.wait = totals.wait / nrFrames;
+            average.latency = totals.latency / nrFrames;
+            totals = Timings();
+            nrFrames = 0;
+        }
+        return average;
+    }
+
+private:
+    typedef std::chrono::steady_clock Clock;
+
+    std::function<void(Snapshot&, double)> simulate;
+    Snapshot snapshots[2];
+    int front = 0;        // the render thread's; the worker writes the other one
+    bool pipelined = true;
+    bool inFlight = false;
+
+    std::mutex mutex;
+    std::condition_variable wake, done;
+    double jobTime = 0.0;
+    bool jobPending = false;
+    bool stop = false;
+    double workerMilliseconds = 0.0;
+
+    Clock::time_point latchTime, previousEnd;
+    bool hasPreviousEnd = false;
+    int nrFrames = 0;
+    Timings totals, average;
+
+    // declared last: starts running once everything above is initialized
+    std::thread worker;
+
+    static double milliseconds(Clock::time_point from, Clock::time_point to) {
+        return std::chrono::duration<double, std::milli>(to - from).count();
+    }
+
+    void run() {
+        std::unique_lock<std::mutex> lock(mutex);
+        while (true) {
+            wake.wait(lock, [this]() { return jobPending || stop; });
+            if (stop)
+                return;
+
+            // front only changes in beginFrame() after this job is done, so the back snapshot is ours
+            double time = jobTime;
+            lock.unlock();
+            Clock::time_point start = Clock::now();
+            simulate(snapshots[1 - front], time);
+            double elapsed = milliseconds(start, Clock::now());
+            lock.lock();
+
+            workerMilliseconds = elapsed;
+            jobPending = false;
+            done.notify_one();
+        }
+    }
+};
+
+#endif
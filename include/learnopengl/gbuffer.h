@@ -0,0 +1,89 @@
+#ifndef GBUFFER_H
+#define GBUFFER_H
+
+#include <glad/glad.h>
+
+#include "learnopengl/gl_state.h"
+
+#include <iostream>
+
+// Compact G-buffer for deferred shading, 12 bytes per pixel:
+//
+//     attachment 0  RGBA8             albedo rgb, specular intensity in alpha
+//     attachment 1  RG16              view-space normal, octahedral encoded (see src/shaders/gbuffer.glsl)
+//     depth         DEPTH24_STENCIL8  sampled to reconstruct the view-space position, no position target
+//
+// The depth format matches the chapters' depth/stencil renderbuffers, so blitDepthTo() can copy it into the
+// framebuffer the lighting pass draws to; light volumes and forward passes after it then depth test against the
+// opaque scene.
+//
+// deleteBuffers() frees the framebuffer and its three attachments.
+class GBuffer {
+public:
+    unsigned int FBO;
+    unsigned int albedoSpecular, normal, depthStencil;
+    int width, height;
+
+    GBuffer(int width, int height) : width(width), height(height) {
+        glGenFramebuffers(1, &FBO);
+        GLState::bindFramebuffer(GL_FRAMEBUFFER, FBO);
+
+        albedoSpecular = makeTarget(GL_RGBA8, GL_RGBA, GL_UNSIGNED_BYTE);
+        normal = makeTarget(GL_RG16, GL_RG, GL_UNSIGNED_SHORT);
+        depthStencil = makeTarget(GL_DEPTH24_STENCIL8, GL_DEPTH_STENCIL, GL_UNSIGNED_INT_24_8);
+        glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, albedoSpecular, 0);
+        glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT1, GL_TEXTURE_2D, normal, 0);
+        glFramebufferTexture2D(GL_FRAMEBUFFER, GL_DEPTH_STENCIL_ATTACHMENT, GL_TEXTURE_2D, depthStencil, 0);
+
+        const GLenum drawBuffers[] = { GL_COLOR_ATTACHMENT0, GL_COLOR_ATTACHMENT1 };
+        glDrawBuffers(2, drawBuffers);
+
+        if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE)
+            std::cout << "\033[1;31m" << "ERROR::GBUFFER::FRAMEBUFFER_INCOMPLETE" << "\033[0m" << std::endl;
+        GLState::bindFramebuffer(GL_FRAMEBUFFER, 0);
+    }
+
+    GBuffer(const GBuffer&) = delete;
+    GBuffer& operator=(const GBuffer&) = delete;
+
+    // albedoSpecular, normal and depth on three consecutive texture units
+    void bindTextures(unsigned int firstUnit) const {
+        GLState::bindTexture(firstUnit, GL_TEXTURE_2D, albedoSpecular);
+        GLState::bindTexture(firstUnit + 1, GL_TEXTURE_2D, normal);
+        GLState::bindTexture(firstUnit + 2, GL_TEXTURE_2D, depthStencil);
+    }
+
+    // copies depth and stencil into framebuffer (same size, GL_DEPTH24_STENCIL8) and leaves it bound
+    void blitDepthTo(unsigned int framebuffer) const {
+        GLState::bindFramebuffer(GL_READ_FRAMEBUFFER, FBO);
+        GLState::bindFramebuffer(GL_DRAW_FRAMEBUFFER, framebuffer);
+        glBlitFramebuffer(0, 0, width, height, 0, 0, width, height, GL_DEPTH_BUFFER_BIT | GL_STENCIL_BUFFER_BIT, GL_NEAREST);
+        GLState::bindFramebuffer(GL_FRAMEBUFFER, framebuffer);
+    }
+
+    void deleteBuffers() {
+        GLState::forgetTexture(albedoSpecular);
+        GLState::forgetTexture(normal);
+        GLState::forgetTexture(depthStencil);
+        glDeleteTextures(1, &albedoSpecular);
+        glDeleteTextures(1, &normal);
+        glDeleteTextures(1, &depthStencil);
+        glDeleteFramebuffers(1, &FBO);
+    }
+
+private:
+    // read with texelFetch at the pixel being lit, so no filtering or mipmaps
+    unsigned int makeTarget(GLenum internalFormat, GLenum format, GLenum type) const {
+        unsigned int texture;
+        glGenTextures(1, &texture);
+        GLState::bindTexture(GL_TEXTURE_2D, texture);
+        glTexImage2D(GL_TEXTURE_2D, 0, internalFormat, width, height, 0, format, type, NULL);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+        return texture;
+    }
+};
+
+#endif
@@ -0,0 +1,134 @@
+#ifndef GL_EXTENSIONS_H
+#define GL_EXTENSIONS_H
+
+#include <glad/glad.h>
+
+#include <cstring>
+
+// The bundled glad loader only covers core 3.3. Entry points from newer core versions / extensions that the
+// renderer can use opportunistically are loaded here, after gladLoadGLLoader, with the same loader:
+//
+//     GLExtensions::load((GLADloadproc)glfwGetProcAddress);
+//
+// Every feature has a flag in GLExtensions::support(); callers must check it and fall back when it's false.
+
+#ifndef GL_PROGRAM_BINARY_RETRIEVABLE_HINT
+#define GL_PROGRAM_BINARY_RETRIEVABLE_HINT 0x8257
+#endif
+#ifndef GL_PROGRAM_BINARY_LENGTH
+#define GL_PROGRAM_BINARY_LENGTH 0x8741
+#endif
+#ifndef GL_NUM_PROGRAM_BINARY_FORMATS
+#define GL_NUM_PROGRAM_BINARY_FORMATS 0x87FE
+#endif
+#ifndef GL_MAX_SHADER_COMPILER_THREADS_KHR
+#define GL_MAX_SHADER_COMPILER_THREADS_KHR 0x91B0
+#endif
+#ifndef GL_COMPLETION_STATUS_KHR
+#define GL_COMPLETION_STATUS_KHR 0x91B1
+#endif
+#ifndef GL_DRAW_INDIRECT_BUFFER
+#define GL_DRAW_INDIRECT_BUFFER 0x8F3F
+#endif
+#ifndef GL_MAP_PERSISTENT_BIT
+#define GL_MAP_PERSISTENT_BIT 0x0040
+#endif
+#ifndef GL_MAP_COHERENT_BIT
+#define GL_MAP_COHERENT_BIT 0x0080
+#endif
+
+namespace GLExtensions {
+    typedef void (APIENTRYP PFNGLGETPROGRAMBINARYPROC)(GLuint program, GLsizei bufSize, GLsizei* length, GLenum* binaryFormat, void* binary);
+    typedef void (APIENTRYP PFNGLPROGRAMBINARYPROC)(GLuint program, GLenum binaryFormat, const void* binary, GLsizei length);
+    typedef void (APIENTRYP PFNGLPROGRAMPARAMETERIPROC)(GLuint program, GLenum pname, GLint value);
+    typedef void (APIENTRYP PFNGLMAXSHADERCOMPILERTHREADSKHRPROC)(GLuint count);
+    typedef void (APIENTRYP PFNGLBUFFERSTORAGEPROC)(GLenum target, GLsizeiptr size, const void* data, GLbitfield flags);
+    typedef void (APIENTRYP PFNGLMULTIDRAWELEMENTSINDIRECTPROC)(GLenum mode, GLenum type, const void* indirect, GLsizei drawcount, GLsizei stride);
+
+    struct Support {
+        bool loaded = false;
+        bool programBinary = false;     // GL 4.1 / ARB_get_program_binary, with at least one binary format
+        bool parallelShaderCompile = false; // KHR/ARB_parallel_shader_compile: GL_COMPLETION_STATUS_KHR can be polled
+        bool bufferStorage = false;     // GL 4.4 / ARB_buffer_storage: immutable buffers that can stay mapped while drawn from
+        bool multiDrawIndirect = false; // GL 4.3 / ARB_multi_draw_indirect, plus ARB_shader_draw_parameters for gl_DrawIDARB
+    };
+
+    inline Support& support() {
+        static Support s;
+        return s;
+    }
+
+    // ARB_get_program_binary
+    inline PFNGLGETPROGRAMBINARYPROC GetProgramBinary = nullptr;
+    inline PFNGLPROGRAMBINARYPROC ProgramBinary = nullptr;
+    inline PFNGLPROGRAMPARAMETERIPROC ProgramParameteri = nullptr;
+
+    // KHR_parallel_shader_compile (ARB_parallel_shader_compile has the same enums)
+    inline PFNGLMAXSHADERCOMPILERTHREADSKHRPROC MaxShaderCompilerThreads = nullptr;
+
+    // ARB_buffer_storage
+    inline PFNGLBUFFERSTORAGEPROC BufferStorage = nullptr;
+
+    // ARB_multi_draw_indirect
+    inline PFNGLMULTIDRAWELEMENTSINDIRECTPROC MultiDrawElementsIndirect = nullptr;
+
+    inline bool hasExtension(const char* name) {
+        GLint nrExtensions = 0;
+        glGetIntegerv(GL_NUM_EXTENSIONS, &nrExtensions);
+        for (GLint i = 0; i < nrExtensions; i++) {
+            const char* extension = reinterpret_cast<const char*>(glGetStringi(GL_EXTENSIONS, i));
+            if (extension && std::strcmp(extension, name) == 0)
+                return true;
+        }
+        return false;
+    }
+
+    inline bool hasVersion(int major, int minor) {
+        GLint contextMajor = 0, contextMinor = 0;
+        glGetIntegerv(GL_MAJOR_VERSION, &contextMajor);
+        glGetIntegerv(GL_MINOR_VERSION, &contextMinor);
+        return contextMajor > major || (contextMajor == major && contextMinor >= minor);
+    }
+
+    // must be called with a current context, after gladLoadGLLoader
+    inline void load(GLADloadproc loader) {
+        Support& s = support();
+        s = Support();
+
+        if (hasVersion(4, 1) || hasExtension("GL_ARB_get_program_binary")) {
+            GetProgramBinary = reinterpret_cast<PFNGLGETPROGRAMBINARYPROC>(loader("glGetProgramBinary"));
+            ProgramBinary = reinterpret_cast<PFNGLPROGRAMBINARYPROC>(loader("glProgramBinary"));
+            ProgramParameteri = reinterpret_cast<PFNGLPROGRAMPARAMETERIPROC>(loader("glProgramParameteri"));
+            GLint nrFormats = 0;
+            glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &nrFormats);
+            // some drivers (macOS among them) expose the entry points but no formats
+            s.programBinary = GetProgramBinary && ProgramBinary && ProgramParameteri && nrFormats > 0;
+        }
+
+        if (hasExtension("GL_KHR_parallel_shader_compile"))
+            MaxShaderCompilerThreads = reinterpret_cast<PFNGLMAXSHADERCOMPILERTHREADSKHRPROC>(loader("glMaxShaderCompilerThreadsKHR"));
+        else if (hasExtension("GL_ARB_parallel_shader_compile"))
+            MaxShaderCompilerThreads = reinterpret_cast<PFNGLMAXSHADERCOMPILERTHREADSKHRPROC>(loader("glMaxShaderCompilerThreadsARB"));
+        if (MaxShaderCompilerThreads) {
+            // let the driver use as many compiler threads as it likes
+            MaxShaderCompilerThreads(0xFFFFFFFFu);
+            s.parallelShaderCompile = true;
+        }
+
+        if (hasVersion(4, 4) || hasExtension("GL_ARB_buffer_storage")) {
+            BufferStorage = reinterpret_cast<PFNGLBUFFERSTORAGEPROC>(loader("glBufferStorage"));
+            s.bufferStorage = BufferStorage != nullptr;
+        }
+
+        // the draw index is only useful to the shaders with gl_DrawIDARB: they're #version 330, so the extension has
+        // to be there even on 4.6, where gl_DrawID is core but only in #version 460 shaders
+        if ((hasVersion(4, 3) || hasExtension("GL_ARB_multi_draw_indirect")) && hasExtension("GL_ARB_shader_draw_parameters")) {
+            MultiDrawElementsIndirect = reinterpret_cast<PFNGLMULTIDRAWELEMENTSINDIRECTPROC>(loader("glMultiDrawElementsIndirect"));
+            s.multiDrawIndirect = MultiDrawElementsIndirect != nullptr;
+        }
+
+        s.loaded = true;
+    }
+}
+
+#endif
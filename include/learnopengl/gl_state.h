@@ -0,0 +1,233 @@
+#ifndef GL_STATE_H
+#define GL_STATE_H
+
+#include <glad/glad.h>
+
+// Shadow copy of the bits of GL state the render loops touch every frame (program, VAO, texture bindings,
+// a few capabilities, framebuffer), so setting something that's already set never reaches the driver.
+//
+// The shadow is only right if every change goes through here. Code that calls GL directly (setup code, a
+// library) must call GLState::invalidate() afterwards; the next call of each kind then goes to the driver.
+// Deleting a bound object should be followed by the matching forget*() so a recycled name isn't skipped.
+//
+// Issued and skipped calls are counted per frame: call GLState::beginFrame() once at the top of the loop and
+// read GLState::lastFrame() for the previous frame's numbers.
+namespace GLState {
+    const unsigned int UNKNOWN = 0xFFFFFFFFu;
+    const int MAX_TEXTURE_UNITS = 32;
+
+    // texture targets with their own binding per unit
+    enum TextureTarget {
+        TEXTURE_2D,
+        TEXTURE_2D_ARRAY,
+        TEXTURE_3D,
+        TEXTURE_CUBE_MAP,
+        TEXTURE_BUFFER,
+        NR_TEXTURE_TARGETS
+    };
+
+    // capabilities that are cached; anything else is passed straight through
+    enum Capability {
+        DEPTH_TEST,
+        CULL_FACE,
+        BLEND,
+        STENCIL_TEST,
+        NR_CAPABILITIES
+    };
+
+    struct Stats {
+        unsigned int issued = 0;
+        unsigned int skipped = 0;
+        // glUniform* calls made / avoided by Shader's shadowed setters
+        unsigned int uniformUploads = 0;
+        unsigned int uniformSkips = 0;
+    };
+
+    struct Cache {
+        unsigned int program;
+        unsigned int vertexArray;
+        unsigned int activeTexture; // unit index, not GL_TEXTUREi
+        unsigned int textures[MAX_TEXTURE_UNITS][NR_TEXTURE_TARGETS];
+        int capabilities[NR_CAPABILITIES]; // -1 unknown, 0 disabled, 1 enabled
+        unsigned int drawFramebuffer;
+        unsigned int readFramebuffer;
+
+        Stats frame;
+        Stats previousFrame;
+
+        Cache() { reset(); }
+
+        void reset() {
+            program = UNKNOWN;
+            vertexArray = UNKNOWN;
+            activeTexture = UNKNOWN;
+            for (int unit = 0; unit < MAX_TEXTURE_UNITS; unit++)
+                for (int target = 0; target < NR_TEXTURE_TARGETS; target++)
+                    textures[unit][target] = UNKNOWN;
+            for (int capability = 0; capability < NR_CAPABILITIES; capability++)
+                capabilities[capability] = -1;
+            drawFramebuffer = UNKNOWN;
+            readFramebuffer = UNKNOWN;
+        }
+    };
+
+    inline Cache& cache() {
+        static Cache c;
+        return c;
+    }
+
+    // true if the call has to go to the driver; updates the shadow value and the counters
+    inline bool changes(unsigned int& current, unsigned int value) {
+        Stats& stats = cache().frame;
+        if (current == value) {
+            stats.skipped++;
+            return false;
+        }
+        current = value;
+        stats.issued++;
+        return true;
+    }
+
+    inline void beginFrame() {
+        Cache& c = cache();
+        c.previousFrame = c.frame;
+        c.frame = Stats();
+    }
+
+    inline const Stats& lastFrame() {
+        return cache().previousFrame;
+    }
+
+    // forget everything; the next call of each kind is issued
+    inline void invalidate() {
+        cache().reset();
+    }
+
+    inline void useProgram(unsigned int program) {
+        if (changes(cache().program, program))
+            glUseProgram(program);
+    }
+
+    inline void bindVertexArray(unsigned int vertexArray) {
+        if (changes(cache().vertexArray, vertexArray))
+            glBindVertexArray(vertexArray);
+    }
+
+    // unit is an index (0, 1, ...), not GL_TEXTURE0 + i
+    inline void activeTexture(unsigned int unit) {
+        if (changes(cache().activeTexture, unit))
+            glActiveTexture(GL_TEXTURE0 + unit);
+    }
+
+    inline int textureTargetIndex(GLenum target) {
+        switch (target) {
+            case GL_TEXTURE_2D:       return TEXTURE_2D;
+            case GL_TEXTURE_2D_ARRAY: return TEXTURE_2D_ARRAY;
+            case GL_TEXTURE_3D:       return TEXTURE_3D;
+            case GL_TEXTURE_CUBE_MAP: return TEXTURE_CUBE_MAP;
+            case GL_TEXTURE_BUFFER:   return TEXTURE_BUFFER;
+            default:                  return -1;
+        }
+    }
+
+    // binds to the active unit, like glBindTexture
+    inline void bindTexture(GLenum target, unsigned int texture) {
+        Cache& c = cache();
+        int targetIndex = textureTargetIndex(target);
+        if (targetIndex < 0 || c.activeTexture >= (unsigned int)MAX_TEXTURE_UNITS) {
+            // untracked target or unknown unit: issue it, and don't trust this unit's shadow any more
+            if (c.activeTexture < (unsigned int)MAX_TEXTURE_UNITS && targetIndex >= 0)
+                c.textures[c.activeTexture][targetIndex] = UNKNOWN;
+            c.frame.issued++;
+            glBindTexture(target, texture);
+            return;
+        }
+        if (changes(c.textures[c.activeTexture][targetIndex], texture))
+            glBindTexture(target, texture);
+    }
+
+    // activeTexture(unit) + bindTexture(target, texture)
+    inline void bindTexture(unsigned int unit, GLenum target, unsigned int texture) {
+        Cache& c = cache();
+        int targetIndex = textureTargetIndex(target);
+        // already bound there: don't even switch the active unit
+        if (unit < (unsigned int)MAX_TEXTURE_UNITS && targetIndex >= 0 && c.textures[unit][targetIndex] == texture) {
+            c.frame.skipped++;
+            return;
+        }
+        activeTexture(unit);
+        bindTexture(target, texture);
+    }
+
+    inline int capabilityIndex(GLenum capability) {
+        switch (capability) {
+            case GL_DEPTH_TEST:   return DEPTH_TEST;
+            case GL_CULL_FACE:    return CULL_FACE;
+            case GL_BLEND:        return BLEND;
+            case GL_STENCIL_TEST: return STENCIL_TEST;
+            default:              return -1;
+        }
+    }
+
+    inline void setEnabled(GLenum capability, bool enabled) {
+        Cache& c = cache();
+        int index = capabilityIndex(capability);
+        if (index >= 0 && c.capabilities[index] == (int)enabled) {
+            c.frame.skipped++;
+            return;
+        }
+        if (index >= 0)
+            c.capabilities[index] = (int)enabled;
+        c.frame.issued++;
+        if (enabled)
+            glEnable(capability);
+        else
+            glDisable(capability);
+    }
+
+    inline void enable(GLenum capability) {
+        setEnabled(capability, true);
+    }
+
+    inline void disable(GLenum capability) {
+        setEnabled(capability, false);
+    }
+
+    // GL_FRAMEBUFFER sets both the draw and the read binding, like glBindFramebuffer
+    inline void bindFramebuffer(GLenum target, unsigned int framebuffer) {
+        Cache& c = cache();
+        bool draw = target == GL_FRAMEBUFFER || target == GL_DRAW_FRAMEBUFFER;
+        bool read = target == GL_FRAMEBUFFER || target == GL_READ_FRAMEBUFFER;
+        if ((!draw || c.drawFramebuffer == framebuffer) && (!read || c.readFramebuffer == framebuffer)) {
+            c.frame.skipped++;
+            return;
+        }
+        if (draw)
+            c.drawFramebuffer = framebuffer;
+        if (read)
+            c.readFramebuffer = framebuffer;
+        c.frame.issued++;
+        glBindFramebuffer(target, framebuffer);
+    }
+
+    // call after deleting a program / VAO / texture that might still be in the shadow
+    inline void forgetProgram(unsigned int program) {
+        if (cache().program == program)
+            cache().program = UNKNOWN;
+    }
+
+    inline void forgetVertexArray(unsigned int vertexArray) {
+        if (cache().vertexArray == vertexArray)
+            cache().vertexArray = UNKNOWN;
+    }
+
+    inline void forgetTexture(unsigned int texture) {
+        Cache& c = cache();
+        for (int unit = 0; unit < MAX_TEXTURE_UNITS; unit++)
+            for (int target = 0; target < NR_TEXTURE_TARGETS; target++)
+                if (c.textures[unit][target] == texture)
+                    c.textures[unit][target] = UNKNOWN;
+    }
+}
+
+#endif
@@ -0,0 +1,83 @@
+#ifndef GPU_TIMER_H
+#define GPU_TIMER_H
+
+#include <glad/glad.h>
+
+// GPU time of a stretch of commands, measured with GL_TIME_ELAPSED queries (core since 3.3). The result of a
+// query is only read once the GPU has finished it, a few frames later, so timing never stalls the pipeline;
+// milliseconds() averages the frames that completed since it was last called.
+//
+//     timer.begin();
+//     ... draw ...
+//     timer.end();
+//     double ms = timer.milliseconds();
+//
+// only one GL_TIME_ELAPSED query can be active at a time, so timers can't be nested.
+// the query ring is freed by deleteQueries(), not by the destructor.
+class GpuTimer {
+public:
+    GpuTimer() {
+        glGenQueries(FRAMES_IN_FLIGHT, queries);
+    }
+
+    GpuTimer(const GpuTimer&) = delete;
+    GpuTimer& operator=(const GpuTimer&) = delete;
+
+    void begin() {
+        // out of free queries (GPU far behind): skip this frame's measurement rather than wait
+        skipping = pending == FRAMES_IN_FLIGHT;
+        if (!skipping)
+            glBeginQuery(GL_TIME_ELAPSED, queries[(first + pending) % FRAMES_IN_FLIGHT]);
+    }
+
+    void end() {
+        if (skipping)
+            return;
+        glEndQuery(GL_TIME_ELAPSED);
+        pending++;
+        collect();
+    }
+
+    // average over the frames collected since the last call; returns the previous average if none finished
+    double milliseconds() {
+        collect();
+        if (nrSamples > 0) {
+            average = totalNanoseconds / 1.0e6 / nrSamples;
+            totalNanoseconds = 0.0;
+            nrSamples = 0;
+        }
+        return average;
+    }
+
+    void deleteQueries() {
+        glDeleteQueries(FRAMES_IN_FLIGHT, queries);
+    }
+
+private:
+    static const int FRAMES_IN_FLIGHT = 4;
+
+    unsigned int queries[FRAMES_IN_FLIGHT];
+    int first = 0;   // oldest query still waiting for its result
+    int pending = 0;
+    bool skipping = false;
+    double totalNanoseconds = 0.0;
+    int nrSamples = 0;
+    double average = 0.0;
+
+    void collect() {
+        while (pending > 0) {
+            int available = 0;
+            glGetQueryObjectiv(queries[first], GL_QUERY_RESULT_AVAILABLE, &available);
+            if (!available)
+                return;
+            GLuint64 elapsed = 0;
+            glGetQueryObjectui64v(queries[first], GL_QUERY_RESULT, &elapsed);
+            totalNanoseconds += (double)elapsed;
+            nrSamples++;
+            first = (first + 1) % FRAMES_IN_FLIGHT;
+            pending--;
+        }
+    }
+};
+
+#endif
@@ -0,0 +1,488 @@
+#ifndef IMAGE_DECODER_H
+#define IMAGE_DECODER_H
+
+#include "stb_image/stb_image.h"
+
+#ifdef LEARNOPENGL_WITH_LIBJPEG
+#include <csetjmp>
+#include <jpeglib.h>
+#endif
+#ifdef LEARNOPENGL_WITH_LIBPNG
+#include <png.h>
+#endif
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+// decoded pixels are malloc'd by every backend (stb_image, libjpeg, libpng all agree on this)
+struct PixelDeleter {
+    void operator()(unsigned char* pixels) const { std::free(pixels); }
+};
+
+// tightly packed 8-bit image, rows top to bottom
+struct DecodedImage {
+    int width = 0;
+    int height = 0;
+    int nrComponents = 0;
+    std::unique_ptr<unsigned char, PixelDeleter> pixels;
+
+    std::size_t sizeInBytes() const {
+        return static_cast<std::size_t>(width) * height * nrComponents;
+    }
+};
+
+enum class ImageFormat {
+    UNKNOWN,
+    JPEG,
+    PNG
+};
+
+// sniffs the container format from the first few bytes of the encoded file
+inline ImageFormat detectImageFormat(const unsigned char* bytes, std::size_t size) {
+    static const unsigned char pngMagic[8] = { 0x89, 'P', 'N', 'G', '\r', '\n', 0x1A, '\n' };
+    if (size >= 3 && bytes[0] == 0xFF && bytes[1] == 0xD8 && bytes[2] == 0xFF)
+        return ImageFormat::JPEG;
+    if (size >= 8 && std::memcmp(bytes, pngMagic, 8) == 0)
+        return ImageFormat::PNG;
+    return ImageFormat::UNKNOWN;
+}
+
+// a decoder backend turns an encoded file held in memory into 8-bit pixels.
+// decode() must be safe to call from several threads at once.
+class ImageDecoder {
+public:
+    virtual ~ImageDecoder() = default;
+
+    virtual const char* name() const = 0;
+    virtual bool canDecode(ImageFormat format) const = 0;
+    virtual bool decode(const unsigned char* bytes, std::size_t size, DecodedImage& image) const = 0;
+};
+
+// the reference backend; handles every format stb_image knows about
+class StbImageDecoder : public ImageDecoder {
+public:
+    const char* name() const override { return "stb_image"; }
+
+    bool canDecode(ImageFormat /*format*/) const override { return true; }
+
+    bool decode(const unsigned char* bytes, std::size_t size, DecodedImage& image) const override {
+        int width, height, nrComponents;
+        unsigned char* data = stbi_load_from_memory(bytes, static_cast<int>(size), &width, &height, &nrComponents, 0);
+        if (!data)
+            return false;
+        image.width = width;
+        image.height = height;
+        image.nrComponents = nrComponents;
+        image.pixels.reset(data);
+        return true;
+    }
+};
+
+#ifdef LEARNOPENGL_WITH_LIBJPEG
+// libjpeg-turbo backend (SIMD huffman/IDCT/color conversion)
+class LibJpegDecoder : public ImageDecoder {
+public:
+    const char* name() const override { return "libjpeg"; }
+
+    bool canDecode(ImageFormat format) const override { return format == ImageFormat::JPEG; }
+
+    bool decode(const unsigned char* bytes, std::size_t size, DecodedImage& image) const override {
+        jpeg_decompress_struct cinfo;
+        ErrorManager jerr;
+        cinfo.err = jpeg_std_error(&jerr.pub);
+        jerr.pub.error_exit = onError; // the default handler calls exit()
+        unsigned char* volatile data = nullptr;
+
+        if (setjmp(jerr.jump)) {
+            jpeg_destroy_decompress(&cinfo);
+            std::free(data);
+            return false;
+        }
+
+        jpeg_create_decompress(&cinfo);
+        jpeg_mem_src(&cinfo, bytes, static_cast<unsigned long>(size));
+        jpeg_read_header(&cinfo, TRUE);
+        cinfo.out_color_space = (cinfo.num_components == 1) ? JCS_GRAYSCALE : JCS_RGB;
+        jpeg_start_decompress(&cinfo);
+
+        const std::size_t stride = static_cast<std::size_t>(cinfo.output_width) * cinfo.output_components;
+        data = static_cast<unsigned char*>(std::malloc(stride * cinfo.output_height));
+        if (!data) {
+            jpeg_destroy_decompress(&cinfo);
+            return false;
+        }
+        while (cinfo.output_scanline < cinfo.output_height) {
+            JSAMPROW row = data + cinfo.output_scanline * stride;
+            jpeg_read_scanlines(&cinfo, &row, 1);
+        }
+        jpeg_finish_decompress(&cinfo);
+
+        image.width = static_cast<int>(cinfo.output_width);
+        image.height = static_cast<int>(cinfo.output_height);
+        image.nrComponents = cinfo.output_components;
+        image.pixels.reset(data);
+        jpeg_destroy_decompress(&cinfo);
+        return true;
+    }
+
+private:
+    struct ErrorManager {
+        jpeg_error_mgr pub;
+        std::jmp_buf jump;
+    };
+
+    static void onError(j_common_ptr cinfo) {
+        std::longjmp(reinterpret_cast<ErrorManager*>(cinfo->err)->jump, 1);
+    }
+};
+#endif
+
+#ifdef LEARNOPENGL_WITH_LIBPNG
+// libpng backend (SIMD row filters); output is always 8 bits per channel
+class LibPngDecoder : public ImageDecoder {
+public:
+    const char* name() const override { return "libpng"; }
+
+    bool canDecode(ImageFormat format) const override { return format == ImageFormat::PNG; }
+
+    bool decode(const unsigned char* bytes, std::size_t size, DecodedImage& image) const override {
+        png_image png;
+        std::memset(&png, 0, sizeof(png));
+        png.version = PNG_IMAGE_VERSION;
+        if (!png_image_begin_read_from_memory(&png, bytes, size))
+            return false;
+
+        // keep the channel layout stb_image would report
+        int nrComponents;
+        if (png.format & PNG_FORMAT_FLAG_COLOR) {
+            nrComponents = (png.format & PNG_FORMAT_FLAG_ALPHA) ? 4 : 3;
+            png.format = (nrComponents == 4) ? PNG_FORMAT_RGBA : PNG_FORMAT_RGB;
+        } else {
+            nrComponents = (png.format & PNG_FORMAT_FLAG_ALPHA) ? 2 : 1;
+            png.format = (nrComponents == 2) ? PNG_FORMAT_GA : PNG_FORMAT_GRAY;
+        }
+
+        unsigned char* data = static_cast<unsigned char*>(std::malloc(PNG_IMAGE_SIZE(png)));
+        if (!data) {
+            png_image_free(&png);
+            return false;
+        }
+        if (!png_image_finish_read(&png, nullptr, data, 0, nullptr)) {
+            std::free(data);
+            return false;
+        }
+
+        image.width = static_cast<int>(png.width);
+        image.height = static_cast<int>(png.height);
+        image.nrComponents = nrComponents;
+        image.pixels.reset(data);
+        return true;
+    }
+};
+#endif
+
+// Baseline JPEGs with a restart interval that covers whole MCU rows can be split at the RSTn markers:
+// each group of intervals becomes a standalone JPEG (same tables, patched height) that any backend can
+// decode independently. The strips are then stitched back together.
+namespace JpegRestart {
+    struct Layout {
+        std::vector<unsigned char> header;          // SOI + tables + SOF + DRI + SOS, APPn/COM stripped but JFIF/Adobe
+        std::size_t heightOffset = 0;               // offset of the SOF height field inside header
+        int width = 0;
+        int height = 0;
+        int mcuHeight = 8;
+        int mcuRowsPerInterval = 0;
+        std::vector<std::pair<std::size_t, std::size_t>> intervals; // [begin, end) of each entropy-coded interval
+    };
+
+    inline unsigned readU16(const unsigned char* p) {
+        return (static_cast<unsigned>(p[0]) << 8) | p[1];
+    }
+
+    // returns false for anything we can't split (progressive, no DRI, intervals not aligned to MCU rows, ...)
+    inline bool parse(const unsigned char* bytes, std::size_t size, Layout& layout) {
+        if (size < 4 || bytes[0] != 0xFF || bytes[1] != 0xD8)
+            return false;
+
+        layout.header.assign(bytes, bytes + 2);
+        int restartInterval = 0;
+        int mcusPerRow = 0;
+        bool haveFrame = false;
+        bool haveScan = false;
+        std::size_t pos = 2;
+
+        while (pos + 4 <= size) {
+            if (bytes[pos] != 0xFF)
+                return false;
+            unsigned char marker = bytes[pos + 1];
+            if (marker == 0xFF) { // fill byte
+                pos++;
+                continue;
+            }
+            std::size_t length = readU16(bytes + pos + 2);
+            if (pos + 2 + length > size)
+                return false;
+            const unsigned char* segment = bytes + pos + 4;
+
+            if (marker == 0xC0 || marker == 0xC1) { // baseline / extended sequential huffman
+                if (length < 8)
+                    return false;
+                layout.heightOffset = layout.header.size() + 5;
+                layout.height = static_cast<int>(readU16(segment + 1));
+                layout.width = static_cast<int>(readU16(segment + 3));
+                int nrComponents = segment[5];
+                int maxH = 1, maxV = 1;
+                for (int c = 0; c < nrComponents; c++) {
+                    maxH = std::max(maxH, segment[6 + c * 3 + 1] >> 4);
+                    maxV = std::max(maxV, segment[6 + c * 3 + 1] & 0x0F);
+                }
+                layout.mcuHeight = 8 * maxV;
+                mcusPerRow = (layout.width + 8 * maxH - 1) / (8 * maxH);
+                haveFrame = true;
+            } else if (marker >= 0xC2 && marker <= 0xCF && marker != 0xC4 && marker != 0xC8 && marker != 0xCC) {
+                return false; // progressive, lossless or arithmetic coded
+            } else if (marker == 0xDD) {
+                restartInterval = static_cast<int>(readU16(segment));
+            }
+
+            // metadata (EXIF, ICC, comments) would be copied into every strip for nothing, but APP0 (JFIF) and
+            // APP14 (Adobe, whose transform flag says RGB vs YCbCr and CMYK vs YCCK) decide the colour space
+            bool metadata = (marker >= 0xE0 && marker <= 0xEF && marker != 0xE0 && marker != 0xEE) || marker == 0xFE;
+            if (!metadata)
+                layout.header.insert(layout.header.end(), bytes + pos, bytes + pos + 2 + length);
+            pos += 2 + length;
+
+            if (marker == 0xDA) { // start of scan, entropy-coded data follows
+                haveScan = true;
+                break;
+            }
+        }
+
+        if (!haveFrame || !haveScan || layout.height <= 0)
+            return false;
+        if (restartInterval <= 0 || mcusPerRow <= 0 || restartInterval % mcusPerRow != 0)
+            return false;
+        layout.mcuRowsPerInterval = restartInterval / mcusPerRow;
+
+        // walk the scan, splitting at RSTn; a 0xFF followed by 0x00 is a stuffed data byte
+        std::size_t begin = pos;
+        while (pos + 1 < size) {
+            if (bytes[pos] != 0xFF) {
+                pos++;
+                continue;
+            }
+            unsigned char next = bytes[pos + 1];
+            if (next == 0x00 || next == 0xFF) {
+                pos += (next == 0x00) ? 2 : 1;
+            } else if (next >= 0xD0 && next <= 0xD7) {
+                layout.intervals.emplace_back(begin, pos);
+                pos += 2;
+                begin = pos;
+            } else if (next == 0xD9) {
+                layout.intervals.emplace_back(begin, pos);
+                return true;
+            } else {
+                return false; // another scan (or DNL); not a single-scan baseline file
+            }
+        }
+        return false;
+    }
+
+    // builds a standalone JPEG holding intervals [first, last)
+    inline std::vector<unsigned char> makeStrip(const unsigned char* bytes, const Layout& layout,
+                                                std::size_t first, std::size_t last, int stripHeight) {
+        std::vector<unsigned char> strip(layout.header);
+        strip[layout.heightOffset]     = static_cast<unsigned char>(stripHeight >> 8);
+        strip[layout.heightOffset + 1] = static_cast<unsigned char>(stripHeight & 0xFF);
+        for (std::size_t i = first; i < last; i++) {
+            if (i != first) {
+                // decoders expect the marker sequence to restart at RST0
+                strip.push_back(0xFF);
+                strip.push_back(static_cast<unsigned char>(0xD0 + ((i - first - 1) & 7)));
+            }
+            strip.insert(strip.end(), bytes + layout.intervals[i].first, bytes + layout.intervals[i].second);
+        }
+        strip.push_back(0xFF);
+        strip.push_back(0xD9);
+        return strip;
+    }
+
+    inline bool decodeParallel(const unsigned char* bytes, std::size_t size, const ImageDecoder& decoder,
+                               unsigned int nrThreads, DecodedImage& image) {
+        Layout layout;
+        if (nrThreads < 2 || !parse(bytes, size, layout) || layout.intervals.size() < 2)
+            return false;
+
+        // a couple of strips per thread evens out the load without making the strips tiny
+        const std::size_t nrIntervals = layout.intervals.size();
+        const std::size_t nrStrips = std::min<std::size_t>(nrIntervals, nrThreads * 2);
+        const std::size_t intervalsPerStrip = (nrIntervals + nrStrips - 1) / nrStrips;
+        const int rowsPerInterval = layout.mcuRowsPerInterval * layout.mcuHeight;
+
+        // chroma upsampling looks at the neighbouring rows, so every strip is decoded with one extra interval
+        // above and below (where there is one) and the overlap is cropped away when stitching
+        std::vector<DecodedImage> strips((nrIntervals + intervalsPerStrip - 1) / intervalsPerStrip);
+        std::vector<int> skipRows(strips.size(), 0);
+        std::atomic<std::size_t> nextStrip(0);
+        std::atomic<bool> failed(false);
+
+        auto worker = [&]() {
+            for (std::size_t s = nextStrip++; s < strips.size() && !failed; s = nextStrip++) {
+                std::size_t first = (s == 0) ? 0 : s * intervalsPerStrip - 1;
+                std::size_t last = std::min((s + 1) * intervalsPerStrip + 1, nrIntervals);
+                int firstRow = static_cast<int>(first) * rowsPerInterval;
+                int stripHeight = std::min(static_cast<int>(last - first) * rowsPerInterval, layout.height - firstRow);
+                if (stripHeight <= 0) {
+                    failed = true;
+                    break;
+                }
+                std::vector<unsigned char> encoded = makeStrip(bytes, layout, first, last, stripHeight);
+                if (!decoder.decode(encoded.data(), encoded.size(), strips[s]) || strips[s].height != stripHeight)
+                    failed = true;
+                skipRows[s] = static_cast<int>(s * intervalsPerStrip - first) * rowsPerInterval;
+            }
+        };
+
+        std::vector<std::thread> threads;
+        unsigned int nrWorkers = static_cast<unsigned int>(std::min<std::size_t>(nrThreads, strips.size()));
+        for (unsigned int t = 1; t < nrWorkers; t++)
+            threads.emplace_back(worker);
+        worker();
+        for (std::thread& t : threads)
+            t.join();
+        if (failed)
+            return false;
+
+        // stitch the strips
+        const int nrComponents = strips[0].nrComponents;
+        const std::size_t stride = static_cast<std::size_t>(layout.width) * nrComponents;
+        unsigned char* data = static_cast<unsigned char*>(std::malloc(stride * layout.height));
+        if (!data)
+            return false;
+        for (std::size_t s = 0; s < strips.size(); s++) {
+            const DecodedImage& strip = strips[s];
+            if (strip.nrComponents != nrComponents || strip.width != layout.width) {
+                std::free(data);
+                return false;
+            }
+            int firstRow = static_cast<int>(s * intervalsPerStrip) * rowsPerInterval;
+            int nrRows = std::min(static_cast<int>(intervalsPerStrip) * rowsPerInterval, layout.height - firstRow);
+            std::memcpy(data + firstRow * stride, strip.pixels.get() + skipRows[s] * stride, nrRows * stride);
+        }
+
+        image.width = layout.width;
+        image.height = layout.height;
+        image.nrComponents = nrComponents;
+        image.pixels.reset(data);
+        return true;
+    }
+}
+
+// Decoder selection. Backends are tried in registration order (most specific first); stb_image is always
+// registered last as the catch-all, so an image that a faster backend rejects still loads.
+namespace ImageDecoders {
+    struct Settings {
+        std::string preferred;          // backend name to try first, empty for registration order
+        bool flipVertically = false;    // same meaning as stbi_set_flip_vertically_on_load
+        unsigned int nrThreads = std::max(1u, std::thread::hardware_concurrency());
+        std::size_t parallelThreshold = 1 << 20; // don't split JPEGs smaller than this (bytes)
+    };
+
+    inline Settings& settings() {
+        static Settings s;
+        return s;
+    }
+
+    inline std::vector<std::unique_ptr<ImageDecoder>>& registry() {
+        static std::vector<std::unique_ptr<ImageDecoder>> decoders = []() {
+            std::vector<std::unique_ptr<ImageDecoder>> list;
+#ifdef LEARNOPENGL_WITH_LIBJPEG
+            list.emplace_back(new LibJpegDecoder());
+#endif
+#ifdef LEARNOPENGL_WITH_LIBPNG
+            list.emplace_back(new LibPngDecoder());
+#endif
+            list.emplace_back(new StbImageDecoder());
+            return list;
+        }();
+        return decoders;
+    }
+
+    // registers an extra backend ahead of the built-in ones; call before any loading starts
+    inline void registerDecoder(std::unique_ptr<ImageDecoder> decoder) {
+        registry().insert(registry().begin(), std::move(decoder));
+    }
+
+    inline void setPreferredDecoder(const std::string& name) { settings().preferred = name; }
+    inline void setFlipVerticallyOnLoad(bool flip) { settings().flipVertically = flip; }
+
+    inline const ImageDecoder* find(const std::string& name) {
+        for (const std::unique_ptr<ImageDecoder>& decoder : registry())
+            if (name == decoder->name())
+                return decoder.get();
+        return nullptr;
+    }
+
+    inline void flipRows(DecodedImage& image) {
+        const std::size_t stride = static_cast<std::size_t>(image.width) * image.nrComponents;
+        std::vector<unsigned char> tmp(stride);
+        unsigned char* pixels = image.pixels.get();
+        for (int top = 0, bottom = image.height - 1; top < bottom; top++, bottom--) {
+            std::memcpy(tmp.data(), pixels + top * stride, stride);
+            std::memcpy(pixels + top * stride, pixels + bottom * stride, stride);
+            std::memcpy(pixels + bottom * stride, tmp.data(), stride);
+        }
+    }
+
+    // decodes an in-memory file with a specific backend, splitting large JPEGs across threads when possible
+    inline bool decodeWith(const ImageDecoder& decoder, const unsigned char* bytes, std::size_t size, DecodedImage& image) {
+        const Settings& s = settings();
+        ImageFormat format = detectImageFormat(bytes, size);
+        if (!decoder.canDecode(format))
+            return false;
+        bool decoded = false;
+        if (format == ImageFormat::JPEG && size >= s.parallelThreshold)
+            decoded = JpegRestart::decodeParallel(bytes, size, decoder, s.nrThreads, image);
+        if (!decoded)
+            decoded = decoder.decode(bytes, size, image);
+        if (decoded && s.flipVertically)
+            flipRows(image);
+        return decoded;
+    }
+
+    inline bool decode(const unsigned char* bytes, std::size_t size, DecodedImage& image) {
+        const ImageDecoder* preferred = find(settings().preferred);
+        if (preferred && decodeWith(*preferred, bytes, size, image))
+            return true;
+        for (const std::unique_ptr<ImageDecoder>& decoder : registry())
+            if (decoder.get() != preferred && decodeWith(*decoder, bytes, size, image))
+                return true;
+        return false;
+    }
+
+    inline bool readFile(const std::string& path, std::vector<unsigned char>& bytes) {
+        std::ifstream file(path, std::ios::binary);
+        if (!file)
+            return false;
+        bytes.assign(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+        return !bytes.empty();
+    }
+
+    // drop-in replacement for stbi_load(path, ..., 0)
+    inline bool load(const std::string& path, DecodedImage& image) {
+        std::vector<unsigned char> bytes;
+        return readFile(path, bytes) && decode(bytes.data(), bytes.size(), image);
+    }
+}
+
+#endif
@@ -0,0 +1,313 @@
+#ifndef INDIRECT_DRAWS_H
+#define INDIRECT_DRAWS_H
+
+#include <glad/glad.h>
+
+#include <glm/glm.hpp>
+
+#include "learnopengl/gl_extensions.h"
+#include "learnopengl/gl_state.h"
+#include "learnopengl/mesh.h"
+#include "learnopengl/shader.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <vector>
+
+// one draw of glMultiDrawElementsIndirect, laid out the way GL reads it from the indirect buffer
+struct DrawElementsIndirectCommand {
+    GLuint count;
+    GLuint instanceCount; // 0 skips the draw
+    GLuint firstIndex;
+    GLint baseVertex;
+    GLuint baseInstance;
+};
+
+static_assert(sizeof(DrawElementsIndirectCommand) == 20, "DrawElementsIndirectCommand is five tightly packed ints");
+
+// Meshes copied into one vertex and one index buffer behind a single vertex array (same attributes as Mesh), so
+// draws of different meshes can go out in one indirect call. Each mesh keeps its own range: its indices are left
+// as they were and baseVertex moves them to where its vertices ended up.
+//
+// deleteBuffers() frees the merged vertex and index buffers and their VAO.
+class MergedMeshes {
+public:
+    struct Range {
+        GLuint firstIndex;
+        GLuint count;
+        GLint baseVertex;
+    };
+
+    unsigned int VAO;
+
+    explicit MergedMeshes(const vector<Mesh>& meshes) {
+        vector<Vertex> vertices;
+        vector<unsigned int> indices;
+        for (const Mesh& mesh : meshes) {
+            ranges.push_back({ (GLuint)indices.size(), (GLuint)mesh.indices.size(), (GLint)vertices.size() });
+            vertices.insert(vertices.end(), mesh.vertices.begin(), mesh.vertices.end());
+            indices.insert(indices.end(), mesh.indices.begin(), mesh.indices.end());
+        }
+        for (const Vertex& vertex : vertices)
+            radius = std::max(radius, glm::length(vertex.Position));
+
+        glGenVertexArrays(1, &VAO);
+        glGenBuffers(1, &VBO);
+        glGenBuffers(1, &EBO);
+
+        GLState::bindVertexArray(VAO);
+        glBindBuffer(GL_ARRAY_BUFFER, VBO);
+        glBufferData(GL_ARRAY_BUFFER, vertices.size() * sizeof(Vertex), vertices.data(), GL_STATIC_DRAW);
+        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, EBO);
+        glBufferData(GL_ELEMENT_ARRAY_BUFFER, indices.size() * sizeof(unsigned int), indices.data(), GL_STATIC_DRAW);
+
+        glEnableVertexAttribArray(0);
+        glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)0);
+        glEnableVertexAttribArray(1);
+        glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)offsetof(Vertex, Normal));
+        glEnableVertexAttribArray(2);
+        glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)offsetof(Vertex, TexCoords));
+        glBindBuffer(GL_ARRAY_BUFFER, 0);
+    }
+
+    MergedMeshes(const MergedMeshes&) = delete;
+    MergedMeshes& operator=(const MergedMeshes&) = delete;
+
+    const Range& range(std::size_t mesh) const {
+        return ranges[mesh];
+    }
+
+    std::size_t size() const {
+        return ranges.size();
+    }
+
+    // bounding sphere of all meshes around their origin, for culling copies placed with a model matrix
+    float boundingRadius() const {
+        return radius;
+    }
+
+    void deleteBuffers() {
+        GLState::forgetVertexArray(VAO);
+        glDeleteVertexArrays(1, &VAO);
+        glDeleteBuffers(1, &VBO);
+        glDeleteBuffers(1, &EBO);
+    }
+
+private:
+    unsigned int VBO, EBO;
+    vector<Range> ranges;
+    float radius = 0.0f;
+};
+
+// A pass compiled into DrawElementsIndirectCommands plus a model matrix per draw, kept on the GPU between frames.
+// Every draw shares one program, vertex array and set of textures; the shader includes
+// src/shaders/indirect_draws.glsl and reads its model matrix with drawModel(), which indexes the per-draw data
+// with the draw's position in the command array:
+//
+//     IndirectDrawBuffer pass(merged.VAO, 3);            // per-draw data on texture unit 3
+//     pass.add(merged.range(mesh), model);               // once, while building the scene
+//     ...
+//     pass.setModel(draw, model);                        // whenever something changes; unchanged values are free
+//     pass.setVisible(draw, visible);
+//     pass.upload();                                     // patches only what changed since the last upload
+//     pass.draw(shader);
+//
+// With GLExtensions::support().multiDrawIndirect the whole pass is one glMultiDrawElementsIndirect and the draw
+// index is gl_DrawIDARB; shaders are built with shaderDefines() for that. On a plain 3.3 context the commands
+// stay on the CPU and draw() walks them instead, one glDrawElementsBaseVertex per visible draw with the index in
+// a drawID uniform, so the per-draw data and the shaders are the same either way.
+//
+// Hidden draws keep their slot with instanceCount 0: the commands never move, so a visibility flip is a 4 byte
+// patch rather than a rebuild.
+//
+// deleteBuffers() frees the command buffer and the per-draw data buffer with its texture.
+class IndirectDrawBuffer {
+public:
+    // what the last upload() and draw() did
+    struct Stats {
+        std::size_t patchedCommands = 0; // commands rewritten by upload()
+        std::size_t patchedModels = 0;   // model matrices rewritten by upload()
+        std::size_t bufferUpdates = 0;   // glBufferData / glBufferSubData calls those took
+        std::size_t drawCalls = 0;       // GL draw calls issued by draw()
+    };
+
+    IndirectDrawBuffer(unsigned int vertexArray, unsigned int dataTextureUnit)
+        : vertexArray(vertexArray), dataUnit(dataTextureUnit), multiDraw(GLExtensions::support().multiDrawIndirect) {
+        glGenBuffers(1, &commandBuffer);
+        glGenBuffers(1, &dataBuffer);
+        glGenTextures(1, &dataTexture);
+    }
+
+    IndirectDrawBuffer(const IndirectDrawBuffer&) = delete;
+    IndirectDrawBuffer& operator=(const IndirectDrawBuffer&) = delete;
+
+    // the defines shaders drawn through an IndirectDrawBuffer need on this context
+    static ShaderDefines shaderDefines() {
+        ShaderDefines defines;
+        if (GLExtensions::support().multiDrawIndirect)
+            defines.push_back({ "MULTI_DRAW_INDIRECT", "" });
+        return defines;
+    }
+
+    // appends a draw of range and returns its index (its drawID in the shader)
+    std::size_t add(const MergedMeshes::Range& range, const glm::mat4& model, bool visible = true) {
+        list.push_back({ range.count, visible ? 1u : 0u, range.firstIndex, range.baseVertex, 0u });
+        models.push_back(model);
+        commandDirty.push_back(0);
+        modelDirty.push_back(0);
+        return list.size() - 1;
+    }
+
+    void setModel(std::size_t draw, const glm::mat4& model) {
+        if (models[draw] == model)
+            return;
+        models[draw] = model;
+        markDirty(modelDirty, dirtyModels, draw);
+    }
+
+    void setVisible(std::size_t draw, bool visible) {
+        GLuint instanceCount = visible ? 1u : 0u;
+        if (list[draw].instanceCount == instanceCount)
+            return;
+        list[draw].instanceCount = instanceCount;
+        markDirty(commandDirty, dirtyCommands, draw);
+    }
+
+    const vector<DrawElementsIndirectCommand>& commands() const {
+        return list;
+    }
+
+    const glm::mat4& model(std::size_t draw) const {
+        return models[draw];
+    }
+
+    std::size_t size() const {
+        return list.size();
+    }
+
+    // brings the GPU copies up to date: everything after the buffers had to grow, otherwise one glBufferSubData
+    // per run of consecutive changed draws
+    void upload() {
+        stats_.patchedCommands = stats_.patchedModels = stats_.bufferUpdates = 0;
+        if (list.size() > capacity) {
+            capacity = list.size();
+            if (multiDraw) {
+                glBindBuffer(GL_COPY_WRITE_BUFFER, commandBuffer);
+                glBufferData(GL_COPY_WRITE_BUFFER, capacity * sizeof(DrawElementsIndirectCommand), list.data(), GL_DYNAMIC_DRAW);
+                stats_.patchedCommands = capacity;
+                stats_.bufferUpdates++;
+            }
+            glBindBuffer(GL_TEXTURE_BUFFER, dataBuffer);
+            glBufferData(GL_TEXTURE_BUFFER, capacity * sizeof(glm::mat4), models.data(), GL_DYNAMIC_DRAW);
+            GLState::bindTexture(dataUnit, GL_TEXTURE_BUFFER, dataTexture);
+            glTexBuffer(GL_TEXTURE_BUFFER, GL_RGBA32F, dataBuffer);
+            glBindBuffer(GL_TEXTURE_BUFFER, 0);
+            stats_.patchedModels = capacity;
+            stats_.bufferUpdates++;
+
+            clearDirty(commandDirty, dirtyCommands);
+            clearDirty(modelDirty, dirtyModels);
+            return;
+        }
+
+        // without multi-draw the commands are only ever read on the CPU
+        if (multiDraw)
+            stats_.patchedCommands = patch(GL_COPY_WRITE_BUFFER, commandBuffer, list.data(), sizeof(DrawElementsIndirectCommand), dirtyCommands);
+        stats_.patchedModels = patch(GL_TEXTURE_BUFFER, dataBuffer, models.data(), sizeof(glm::mat4), dirtyModels);
+        clearDirty(commandDirty, dirtyCommands);
+        clearDirty(modelDirty, dirtyModels);
+    }
+
+    // draws the whole pass with shader, which must already have its other uniforms and textures set
+    void draw(Shader& shader) {
+        stats_.drawCalls = 0;
+        if (list.empty())
+            return;
+
+        shader.use();
+        shader.setInt("drawData", (int)dataUnit);
+        GLState::bindTexture(dataUnit, GL_TEXTURE_BUFFER, dataTexture);
+        GLState::bindVertexArray(vertexArray);
+
+        if (multiDraw) {
+            shader.commit();
+            glBindBuffer(GL_DRAW_INDIRECT_BUFFER, commandBuffer);
+            GLExtensions::MultiDrawElementsIndirect(GL_TRIANGLES, GL_UNSIGNED_INT, (void*)0, (GLsizei)list.size(), 0);
+            glBindBuffer(GL_DRAW_INDIRECT_BUFFER, 0);
+            stats_.drawCalls = 1;
+            return;
+        }
+
+        for (std::size_t i = 0; i < list.size(); i++) {
+            const DrawElementsIndirectCommand& command = list[i];
+            if (command.instanceCount == 0)
+                continue;
+            shader.setInt("drawID", (int)i);
+            shader.commit();
+            glDrawElementsBaseVertex(GL_TRIANGLES, (GLsizei)command.count, GL_UNSIGNED_INT,
+                                     (void*)(std::uintptr_t)(command.firstIndex * sizeof(GLuint)), command.baseVertex);
+            stats_.drawCalls++;
+        }
+    }
+
+    const Stats& stats() const {
+        return stats_;
+    }
+
+    void deleteBuffers() {
+        GLState::forgetTexture(dataTexture);
+        glDeleteTextures(1, &dataTexture);
+        glDeleteBuffers(1, &commandBuffer);
+        glDeleteBuffers(1, &dataBuffer);
+    }
+
+private:
+    unsigned int vertexArray;
+    unsigned int dataUnit;
+    bool multiDraw;
+    unsigned int commandBuffer, dataBuffer, dataTexture;
+    std::size_t capacity = 0; // draws the GPU buffers have room for
+
+    vector<DrawElementsIndirectCommand> list;
+    vector<glm::mat4> models;
+    // a flag per draw so each is queued once, and the queue of draws changed since the last upload()
+    vector<std::uint8_t> commandDirty, modelDirty;
+    vector<std::uint32_t> dirtyCommands, dirtyModels;
+
+    Stats stats_;
+
+    static void markDirty(vector<std::uint8_t>& flags, vector<std::uint32_t>& queue, std::size_t draw) {
+        if (flags[draw])
+            return;
+        flags[draw] = 1;
+        queue.push_back((std::uint32_t)draw);
+    }
+
+    static void clearDirty(vector<std::uint8_t>& flags, vector<std::uint32_t>& queue) {
+        for (std::uint32_t draw : queue)
+            flags[draw] = 0;
+        queue.clear();
+    }
+
+    // uploads the queued elements of data, merging consecutive ones into one update; returns how many were written
+    std::size_t patch(GLenum target, unsigned int buffer, const void* data, std::size_t stride, vector<std::uint32_t>& queue) {
+        if (queue.empty())
+            return 0;
+        std::sort(queue.begin(), queue.end());
+        glBindBuffer(target, buffer);
+        const char* bytes = static_cast<const char*>(data);
+        for (std::size_t first = 0; first < queue.size(); ) {
+            std::size_t last = first + 1;
+            while (last < queue.size() && queue[last] == queue[last - 1] + 1)
+                last++;
+            std::size_t offset = queue[first] * stride;
+            glBufferSubData(target, offset, (last - first) * stride, bytes + offset);
+            stats_.bufferUpdates++;
+            first = last;
+        }
+        glBindBuffer(target, 0);
+        return queue.size();
+    }
+};
+
+#endif
@@ -0,0 +1,84 @@
+#ifndef INSTANCE_BUFFER_H
+#define INSTANCE_BUFFER_H
+
+#include <glad/glad.h>
+
+#include <glm/glm.hpp>
+
+#include "learnopengl/gl_state.h"
+
+#include <algorithm>
+#include <cstddef>
+#include <vector>
+
+// what one instance of an instanced draw gets: its model matrix and one vec4 of its own (a color, a lightmap
+// rectangle, ...)
+struct InstanceData {
+    glm::mat4 model;
+    glm::vec4 data;
+};
+
+// Per-instance vertex attributes in a buffer of InstanceData, so a whole group of objects is drawn with one
+// glDrawArraysInstanced instead of a uniform upload and a draw each. attach() adds the attributes (divisor 1) to
+// a vertex array next to its per-vertex ones; the shader declares them at the same locations:
+//
+//     layout (location = N)     in mat4 instanceModel;   // N .. N + 3
+//     layout (location = N + 4) in vec4 instanceData;
+//
+//     InstanceBuffer instances;
+//     instances.attach(VAO, N);
+//     instances.update(data);                            // every frame for moving objects, once for static ones
+//     glDrawArraysInstanced(GL_TRIANGLES, 0, 36, (GLsizei)data.size());
+//     ...
+//     instances.deleteBuffers();
+class InstanceBuffer {
+public:
+    unsigned int VBO;
+
+    InstanceBuffer() {
+        glGenBuffers(1, &VBO);
+    }
+
+    InstanceBuffer(const InstanceBuffer&) = delete;
+    InstanceBuffer& operator=(const InstanceBuffer&) = delete;
+
+    void attach(unsigned int vertexArray, unsigned int firstLocation) {
+        attachBuffer(vertexArray, firstLocation, VBO, 0);
+    }
+
+    // the same attributes read from InstanceData at offset in some other buffer (a StreamBuffer, ...)
+    static void attachBuffer(unsigned int vertexArray, unsigned int firstLocation, unsigned int buffer, std::size_t offset) {
+        GLState::bindVertexArray(vertexArray);
+        glBindBuffer(GL_ARRAY_BUFFER, buffer);
+        for (unsigned int column = 0; column < 4; column++) {
+            glVertexAttribPointer(firstLocation + column, 4, GL_FLOAT, GL_FALSE, sizeof(InstanceData),
+                                  (void*)(offset + offsetof(InstanceData, model) + column * sizeof(glm::vec4)));
+            glEnableVertexAttribArray(firstLocation + column);
+            glVertexAttribDivisor(firstLocation + column, 1);
+        }
+        glVertexAttribPointer(firstLocation + 4, 4, GL_FLOAT, GL_FALSE, sizeof(InstanceData), (void*)(offset + offsetof(InstanceData, data)));
+        glEnableVertexAttribArray(firstLocation + 4);
+        glVertexAttribDivisor(firstLocation + 4, 1);
+        glBindBuffer(GL_ARRAY_BUFFER, 0);
+    }
+
+    // each update orphans the old storage, so the driver hands out fresh memory instead of waiting for draws
+    // still reading last frame's instances
+    void update(const std::vector<InstanceData>& instances) {
+        std::size_t size = instances.size() * sizeof(InstanceData);
+        capacity = std::max(capacity, size);
+        glBindBuffer(GL_ARRAY_BUFFER, VBO);
+        glBufferData(GL_ARRAY_BUFFER, capacity, NULL, GL_STREAM_DRAW);
+        glBufferSubData(GL_ARRAY_BUFFER, 0, size, instances.data());
+        glBindBuffer(GL_ARRAY_BUFFER, 0);
+    }
+
+    void deleteBuffers() {
+        glDeleteBuffers(1, &VBO);
+    }
+
+private:
+    std::size_t capacity = 0;
+};
+
+#endif
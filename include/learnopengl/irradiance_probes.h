@@ -0,0 +1,234 @@
+#ifndef IRRADIANCE_PROBES_H
+#define IRRADIANCE_PROBES_H
+
+#include <glad/glad.h>
+
+#include <glm/glm.hpp>
+
+#include "learnopengl/bake_scene.h"
+#include "learnopengl/gl_state.h"
+#include "learnopengl/shader.h"
+#include "learnopengl/thread_pool.h"
+
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+// A grid of irradiance probes over a box, baked on the CPU from a BakeScene: each probe traces rays in every
+// direction and keeps the incoming light as L2 spherical harmonics (9 RGB coefficients). Shaders interpolate
+// the coefficients trilinearly (probes.glsl), so diffuse light from any direction at any point in the box costs
+// seven texture fetches, independent of how many lights went into the bake.
+//
+// What a probe sees: the static lights bounced once off the scene, plus the lights' ambient terms arriving
+// along the rays that escape, so probes in corners and between objects get less of it. Direct light is left
+// to the shaders.
+//
+//     IrradianceProbes probes(gridMin, gridMax, glm::ivec3(8));
+//     probes.bake(scene, pool);                  // after scene.build()
+//     probes.upload();
+//     probes.bind(shader, unit);                 // per program that includes probes.glsl
+//     ...
+//     probes.deleteBuffers();
+//
+// Storage: the coefficients are convolved with the cosine lobe at bake time, so a lookup is just the SH basis
+// dotted with them. The 27 floats per probe go into 7 RGBA16F texels (56 bytes), one 3D texture with the 7
+// texels stacked as slabs along z.
+class IrradianceProbes {
+public:
+    static const int NR_COEFFICIENTS = 9;
+    static const int NR_SLABS = 7; // RGBA texels per probe, must match PROBE_SLABS in probes.glsl
+
+    // rays traced per probe; the default keeps the noise below 8-bit output
+    int samples = 256;
+
+    IrradianceProbes(const glm::vec3& boundsMin, const glm::vec3& boundsMax, const glm::ivec3& counts)
+        : boundsMin(boundsMin), boundsMax(boundsMax), counts(glm::max(counts, glm::ivec3(2))) {
+        coefficients.assign((std::size_t)this->counts.x * this->counts.y * this->counts.z * NR_COEFFICIENTS, glm::vec3(0.0f));
+    }
+
+    void bake(const BakeScene& scene, ThreadPool& pool) {
+        // a probe whose rays nearly all stop within half a grid cell is buried in geometry; its light would leak
+        // through the surfaces around it, so it gets its neighbors' instead
+        float buriedDistance = 0.5f * glm::length(spacing()) / std::sqrt(3.0f);
+        std::vector<char> buried(nrProbes(), 0);
+
+        pool.parallelFor(nrProbes(), [&](std::size_t probe) {
+            glm::vec3 origin = position(probe);
+            glm::vec3 ambient = scene.ambient(origin);
+            BakeScene::Random random((std::uint32_t)probe);
+            glm::vec3 sh[NR_COEFFICIENTS] = {};
+            int nearHits = 0;
+
+            for (int s = 0; s < samples; s++) {
+                glm::vec3 direction = BakeScene::sampleSphere(random);
+                float distance;
+                glm::vec3 light = scene.bouncedRadiance(origin, direction, &distance);
+                if (distance == INFINITY)
+                    light = ambient;
+                else if (distance < buriedDistance)
+                    nearHits++;
+
+                float basis[NR_COEFFICIENTS];
+                evaluateBasis(direction, basis);
+                for (int k = 0; k < NR_COEFFICIENTS; k++)
+                    sh[k] += light * basis[k];
+            }
+
+            // uniform sphere samples weigh 4pi / samples, and the values above are irradiance (a * E), so
+            // radiance is a further 1 / pi
+            glm::vec3* dst = &coefficients[probe * NR_COEFFICIENTS];
+            for (int k = 0; k < NR_COEFFICIENTS; k++)
+                dst[k] = sh[k] * (4.0f / samples) * bandConvolution(k);
+            buried[probe] = nearHits > samples * 9 / 10;
+        });
+
+        fillBuried(buried);
+    }
+
+    // creates the texture on the first call, refreshes it after later bakes
+    void upload() {
+        std::vector<glm::vec4> texels((std::size_t)nrProbes() * NR_SLABS);
+        for (std::size_t probe = 0; probe < nrProbes(); probe++) {
+            const float* src = &coefficients[probe * NR_COEFFICIENTS].x;
+            glm::ivec3 cell = probeCell(probe);
+            for (int slab = 0; slab < NR_SLABS; slab++) {
+                glm::vec4 texel(0.0f);
+                for (int c = 0; c < 4 && 4 * slab + c < 3 * NR_COEFFICIENTS; c++)
+                    texel[c] = src[4 * slab + c];
+                int z = slab * counts.z + cell.z;
+                texels[((std::size_t)z * counts.y + cell.y) * counts.x + cell.x] = texel;
+            }
+        }
+
+        if (texture == 0) {
+            glGenTextures(1, &texture);
+            GLState::bindTexture(GL_TEXTURE_3D, texture);
+            glTexParameteri(GL_TEXTURE_3D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+            glTexParameteri(GL_TEXTURE_3D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+            glTexParameteri(GL_TEXTURE_3D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+            glTexParameteri(GL_TEXTURE_3D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+            glTexParameteri(GL_TEXTURE_3D, GL_TEXTURE_WRAP_R, GL_CLAMP_TO_EDGE);
+        } else {
+            GLState::bindTexture(GL_TEXTURE_3D, texture);
+        }
+        glTexImage3D(GL_TEXTURE_3D, 0, GL_RGBA16F, counts.x, counts.y, counts.z * NR_SLABS, 0, GL_RGBA, GL_FLOAT, texels.data());
+    }
+
+    // binds the coefficients to unit and sets probes.glsl's uniforms
+    void bind(Shader& shader, unsigned int unit) {
+        GLState::bindTexture(unit, GL_TEXTURE_3D, texture);
+        shader.setInt("probeCoefficients", unit);
+        shader.setVec3("probeGridMin", boundsMin);
+        shader.setVec3("probeGridMax", boundsMax);
+    }
+
+    // what probes.glsl computes, on the CPU: trilinear over the 8 surrounding probes
+    glm::vec3 irradiance(const glm::vec3& worldPos, const glm::vec3& normal) const {
+        glm::vec3 cell = glm::clamp((worldPos - boundsMin) / (boundsMax - boundsMin), 0.0f, 1.0f) * glm::vec3(counts - 1);
+        glm::ivec3 base = glm::min(glm::ivec3(cell), counts - 2);
+        glm::vec3 f = cell - glm::vec3(base);
+
+        float basis[NR_COEFFICIENTS];
+        evaluateBasis(normal, basis);
+        glm::vec3 result(0.0f);
+        for (int corner = 0; corner < 8; corner++) {
+            glm::ivec3 offset(corner & 1, (corner >> 1) & 1, corner >> 2);
+            glm::vec3 w = glm::mix(glm::vec3(1.0f) - f, f, glm::vec3(offset));
+            const glm::vec3* sh = &coefficients[probeIndex(base + offset) * NR_COEFFICIENTS];
+            glm::vec3 e(0.0f);
+            for (int k = 0; k < NR_COEFFICIENTS; k++)
+                e += sh[k] * basis[k];
+            result += e * (w.x * w.y * w.z);
+        }
+        return glm::max(result, glm::vec3(0.0f));
+    }
+
+    glm::vec3 position(std::size_t probe) const {
+        return boundsMin + glm::vec3(probeCell(probe)) * spacing();
+    }
+
+    std::size_t nrProbes() const {
+        return (std::size_t)counts.x * counts.y * counts.z;
+    }
+
+    void deleteBuffers() {
+        glDeleteTextures(1, &texture);
+        texture = 0;
+    }
+
+private:
+    glm::vec3 boundsMin, boundsMax;
+    glm::ivec3 counts;
+    std::vector<glm::vec3> coefficients; // NR_COEFFICIENTS per probe, x fastest
+    unsigned int texture = 0;
+
+    glm::vec3 spacing() const {
+        return (boundsMax - boundsMin) / glm::vec3(counts - 1);
+    }
+
+    glm::ivec3 probeCell(std::size_t probe) const {
+        return glm::ivec3((int)(probe % counts.x), (int)(probe / counts.x % counts.y), (int)(probe / ((std::size_t)counts.x * counts.y)));
+    }
+
+    std::size_t probeIndex(const glm::ivec3& cell) const {
+        return ((std::size_t)cell.z * counts.y + cell.y) * counts.x + cell.x;
+    }
+
+    // real SH basis up to l = 2, in the order probes.glsl unpacks them
+    static void evaluateBasis(const glm::vec3& n, float basis[NR_COEFFICIENTS]) {
+        basis[0] = 0.282095f;
+        basis[1] = 0.488603f * n.y;
+        basis[2] = 0.488603f * n.z;
+        basis[3] = 0.488603f * n.x;
+        basis[4] = 1.092548f * n.x * n.y;
+        basis[5] = 1.092548f * n.y * n.z;
+        basis[6] = 0.315392f * (3.0f * n.z * n.z - 1.0f);
+        basis[7] = 1.092548f * n.x * n.z;
+        basis[8] = 0.546274f * (n.x * n.x - n.y * n.y);
+    }
+
+    // clamped cosine convolution per band (Ramamoorthi & Hanrahan): radiance to irradiance
+    static float bandConvolution(int k) {
+        return k == 0 ? 3.14159265f : k < 4 ? 2.09439510f : 0.78539816f;
+    }
+
+    // buried probes take the average of their unburied neighbors, spreading inwards until all are filled
+    void fillBuried(std::vector<char>& buried) {
+        if (std::count(buried.begin(), buried.end(), 0) == 0)
+            return; // nothing to copy from
+
+        const glm::ivec3 neighbors[6] = { { 1, 0, 0 }, { -1, 0, 0 }, { 0, 1, 0 }, { 0, -1, 0 }, { 0, 0, 1 }, { 0, 0, -1 } };
+        bool remaining = true;
+        while (remaining) {
+            remaining = false;
+            std::vector<char> next = buried;
+            for (std::size_t probe = 0; probe < nrProbes(); probe++) {
+                if (!buried[probe])
+                    continue;
+                glm::vec3 sum[NR_COEFFICIENTS] = {};
+                int count = 0;
+                for (const glm::ivec3& offset : neighbors) {
+                    glm::ivec3 cell = probeCell(probe) + offset;
+                    if (glm::any(glm::lessThan(cell, glm::ivec3(0))) || glm::any(glm::greaterThanEqual(cell, counts)))
+                        continue;
+                    std::size_t neighbor = probeIndex(cell);
+                    if (buried[neighbor])
+                        continue;
+                    for (int k = 0; k < NR_COEFFICIENTS; k++)
+                        sum[k] += coefficients[neighbor * NR_COEFFICIENTS + k];
+                    count++;
+                }
+                if (count == 0) {
+                    remaining = true;
+                    continue;
+                }
+                for (int k = 0; k < NR_COEFFICIENTS; k++)
+                    coefficients[probe * NR_COEFFICIENTS + k] = sum[k] / (float)count;
+                next[probe] = 0;
+            }
+            buried.swap(next);
+        }
+    }
+};
+
+#endif
@@ -0,0 +1,273 @@
+#ifndef LIGHT_CLUSTERS_H
+#define LIGHT_CLUSTERS_H
+
+#include "learnopengl/thread_pool.h"
+
+#include <glm/glm.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <thread>
+#include <vector>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define LIGHT_CLUSTERS_SSE
+#include <emmintrin.h>
+#endif
+
+// CPU light assignment for clustered forward shading. The view frustum is cut into TILES_X x TILES_Y screen
+// tiles and SLICES depth slices (exponentially spaced, so near clusters stay small), and every light sphere is
+// tested against the view-space AABB of each froxel its screen/depth bounds touch. The result is one
+// (offset, count) range per cluster into a flat list of light indices, which is what the shaders read.
+//
+// Work is split by depth slice over a ThreadPool; within a slice four froxels of a tile row are tested at once
+// with SSE2 (scalar fallback elsewhere). Nothing here touches GL, so it can be benchmarked headlessly; see
+// ClusteredLighting for the upload side.
+//
+//     LightClusters clusters;
+//     clusters.setProjection(projection);
+//     clusters.assign(viewSpaceSpheres); // xyz = view-space center, w = radius
+class LightClusters {
+public:
+    // must match the CLUSTER_* defines in src/shaders/clustered.glsl
+    static const int TILES_X = 16;
+    static const int TILES_Y = 9;
+    static const int SLICES = 24;
+    static const int NR_CLUSTERS = TILES_X * TILES_Y * SLICES;
+
+    struct Range {
+        unsigned int offset;
+        unsigned int count;
+    };
+
+    // false forces the scalar kernel (for comparisons); has no effect without SSE2
+    bool useSimd = true;
+
+    explicit LightClusters(unsigned int nrThreads = std::max(1u, std::thread::hardware_concurrency()))
+        : pool(nrThreads), clusterRanges(NR_CLUSTERS), counts(NR_CLUSTERS), sliceLights(SLICES), sliceHits(SLICES),
+          minX(NR_CLUSTERS), maxX(NR_CLUSTERS), minY(NR_CLUSTERS), maxY(NR_CLUSTERS), minZ(NR_CLUSTERS), maxZ(NR_CLUSTERS) {}
+
+    LightClusters(const LightClusters&) = delete;
+    LightClusters& operator=(const LightClusters&) = delete;
+
+    // rebuilds the froxel bounds; cheap to call every frame since it returns early if nothing changed.
+    // expects a symmetric perspective projection (glm::perspective).
+    void setProjection(const glm::mat4& projection) {
+        if (projection == currentProjection)
+            return;
+        currentProjection = projection;
+
+        // recover the frustum from the matrix: depth planes from the third column, slopes from the diagonal
+        nearPlane = projection[3][2] / (projection[2][2] - 1.0f);
+        farPlane  = projection[3][2] / (projection[2][2] + 1.0f);
+        scaleX = projection[0][0];
+        scaleY = projection[1][1];
+
+        float logRatio = std::log(farPlane / nearPlane);
+        depthScale = SLICES / logRatio;
+        depthBias  = -SLICES * std::log(nearPlane) / logRatio;
+
+        for (int s = 0; s < SLICES; s++) {
+            float sliceNear = nearPlane * std::pow(farPlane / nearPlane, (float)s / SLICES);
+            float sliceFar  = nearPlane * std::pow(farPlane / nearPlane, (float)(s + 1) / SLICES);
+            for (int y = 0; y < TILES_Y; y++) {
+                float ndcY0 = -1.0f + 2.0f * y / TILES_Y;
+                float ndcY1 = -1.0f + 2.0f * (y + 1) / TILES_Y;
+                for (int x = 0; x < TILES_X; x++) {
+                    float ndcX0 = -1.0f + 2.0f * x / TILES_X;
+                    float ndcX1 = -1.0f + 2.0f * (x + 1) / TILES_X;
+                    // the froxel's corners lie on the near and far slice planes; its AABB covers all eight
+                    int cluster = index(x, y, s);
+                    minX[cluster] = std::min(std::min(ndcX0 * sliceNear, ndcX0 * sliceFar), std::min(ndcX1 * sliceNear, ndcX1 * sliceFar)) / scaleX;
+                    maxX[cluster] = std::max(std::max(ndcX0 * sliceNear, ndcX0 * sliceFar), std::max(ndcX1 * sliceNear, ndcX1 * sliceFar)) / scaleX;
+                    minY[cluster] = std::min(std::min(ndcY0 * sliceNear, ndcY0 * sliceFar), std::min(ndcY1 * sliceNear, ndcY1 * sliceFar)) / scaleY;
+                    maxY[cluster] = std::max(std::max(ndcY0 * sliceNear, ndcY0 * sliceFar), std::max(ndcY1 * sliceNear, ndcY1 * sliceFar)) / scaleY;
+                    minZ[cluster] = -sliceFar;
+                    maxZ[cluster] = -sliceNear;
+                }
+            }
+        }
+    }
+
+    // spheres are view-space: xyz center (camera looks down -z), w radius. setProjection must have been called.
+    void assign(const std::vector<glm::vec4>& spheres) {
+        lights = &spheres;
+        bounds.resize(spheres.size());
+
+        // conservative tile/slice ranges per light, so the slice jobs only test froxels the light can touch
+        const std::size_t BOUNDS_CHUNK = 1024;
+        pool.parallelFor((spheres.size() + BOUNDS_CHUNK - 1) / BOUNDS_CHUNK, [&](std::size_t chunk) {
+            std::size_t last = std::min(spheres.size(), (chunk + 1) * BOUNDS_CHUNK);
+            for (std::size_t i = chunk * BOUNDS_CHUNK; i < last; i++)
+                bounds[i] = lightBounds(spheres[i]);
+        });
+
+        // bin the lights by the slices they touch (most touch one or two), so a slice job only visits its own
+        for (std::vector<unsigned int>& binned : sliceLights)
+            binned.clear();
+        for (std::size_t i = 0; i < spheres.size(); i++)
+            for (int slice = bounds[i].slice0; slice <= bounds[i].slice1; slice++)
+                sliceLights[slice].push_back((unsigned int)i);
+
+        // each slice owns its clusters, so the slice jobs never write to the same place. hits are collected in
+        // light order and scattered once the offsets are known, which keeps each cluster's list sorted
+        pool.parallelFor(SLICES, [this](std::size_t slice) { assignSlice((int)slice); });
+
+        unsigned int total = 0;
+        for (int cluster = 0; cluster < NR_CLUSTERS; cluster++) {
+            clusterRanges[cluster].offset = total;
+            clusterRanges[cluster].count = counts[cluster];
+            total += counts[cluster];
+        }
+        lightIndices.resize(total);
+        pool.parallelFor(SLICES, [this](std::size_t slice) { scatterSlice((int)slice); });
+        lights = nullptr;
+    }
+
+    // cluster index as the shaders compute it: x fastest, then y, then slice
+    static int index(int x, int y, int slice) {
+        return (slice * TILES_Y + y) * TILES_X + x;
+    }
+
+    const std::vector<Range>& ranges() const { return clusterRanges; }
+    const std::vector<unsigned int>& indices() const { return lightIndices; }
+    unsigned int nrThreads() const { return pool.size(); }
+
+    float nearPlane = 0.1f, farPlane = 100.0f;
+    // slice = floor(log(depth) * depthScale + depthBias), depth being the positive view-space distance
+    float depthScale = 0.0f, depthBias = 0.0f;
+
+private:
+    struct LightBounds {
+        int x0, x1, y0, y1, slice0, slice1; // inclusive; slice0 > slice1 when the light is outside the frustum
+    };
+
+    struct Hit {
+        unsigned int cluster;
+        unsigned int light;
+    };
+
+    ThreadPool pool;
+    glm::mat4 currentProjection = glm::mat4(0.0f);
+    float scaleX = 1.0f, scaleY = 1.0f;
+
+    std::vector<Range> clusterRanges;
+    std::vector<unsigned int> lightIndices;
+    std::vector<unsigned int> counts;
+    // per slice, reused between frames so the steady state doesn't allocate
+    std::vector<std::vector<unsigned int>> sliceLights;
+    std::vector<std::vector<Hit>> sliceHits;
+
+    // froxel AABBs, structure-of-arrays so four neighbouring froxels load into one SSE register
+    std::vector<float> minX, maxX, minY, maxY, minZ, maxZ;
+
+    const std::vector<glm::vec4>* lights = nullptr;
+    std::vector<LightBounds> bounds;
+
+    int sliceOf(float depth) const {
+        return std::min(std::max((int)std::floor(std::log(depth) * depthScale + depthBias), 0), SLICES - 1);
+    }
+
+    static int tileOf(float ndc, int tiles) {
+        return std::min(std::max((int)std::floor((ndc * 0.5f + 0.5f) * tiles), 0), tiles - 1);
+    }
+
+    LightBounds lightBounds(const glm::vec4& sphere) const {
+        LightBounds b = { 0, -1, 0, -1, 0, -1 };
+        float depthMin = -sphere.z - sphere.w;
+        float depthMax = -sphere.z + sphere.w;
+        if (depthMax < nearPlane || depthMin > farPlane)
+            return b;
+        depthMin = std::max(depthMin, nearPlane);
+        depthMax = std::min(depthMax, farPlane);
+
+        // x/depth over the box around the (near-clipped) sphere peaks at its corners
+        float ndcX0 = scaleX * std::min((sphere.x - sphere.w) / depthMin, (sphere.x - sphere.w) / depthMax);
+        float ndcX1 = scaleX * std::max((sphere.x + sphere.w) / depthMin, (sphere.x + sphere.w) / depthMax);
+        float ndcY0 = scaleY * std::min((sphere.y - sphere.w) / depthMin, (sphere.y - sphere.w) / depthMax);
+        float ndcY1 = scaleY * std::max((sphere.y + sphere.w) / depthMin, (sphere.y + sphere.w) / depthMax);
+        if (ndcX1 < -1.0f || ndcX0 > 1.0f || ndcY1 < -1.0f || ndcY0 > 1.0f)
+            return b;
+
+        b.x0 = tileOf(ndcX0, TILES_X);
+        b.x1 = tileOf(ndcX1, TILES_X);
+        b.y0 = tileOf(ndcY0, TILES_Y);
+        b.y1 = tileOf(ndcY1, TILES_Y);
+        b.slice0 = sliceOf(depthMin);
+        b.slice1 = sliceOf(depthMax);
+        return b;
+    }
+
+    void assignSlice(int slice) {
+        int first = index(0, 0, slice);
+        std::fill(counts.begin() + first, counts.begin() + first + TILES_X * TILES_Y, 0u);
+
+        std::vector<Hit>& hits = sliceHits[slice];
+        hits.clear();
+
+        const std::vector<glm::vec4>& spheres = *lights;
+        for (unsigned int light : sliceLights[slice]) {
+            const LightBounds& b = bounds[light];
+            for (int y = b.y0; y <= b.y1; y++) {
+#ifdef LIGHT_CLUSTERS_SSE
+                if (useSimd) {
+                    testRowSimd(spheres[light], light, index(0, y, slice), b.x0, b.x1, hits);
+                    continue;
+                }
+#endif
+                testRow(spheres[light], light, index(0, y, slice), b.x0, b.x1, hits);
+            }
+        }
+
+        for (const Hit& hit : hits)
+            counts[hit.cluster]++;
+    }
+
+    void scatterSlice(int slice) {
+        unsigned int cursor[TILES_X * TILES_Y];
+        int first = index(0, 0, slice);
+        for (int i = 0; i < TILES_X * TILES_Y; i++)
+            cursor[i] = clusterRanges[first + i].offset;
+        for (const Hit& hit : sliceHits[slice])
+            lightIndices[cursor[hit.cluster - first]++] = hit.light;
+    }
+
+    // scalar sphere vs AABB: squared distance from the center to the box
+    void testRow(const glm::vec4& sphere, unsigned int light, int rowStart, int x0, int x1, std::vector<Hit>& hits) {
+        for (int x = x0; x <= x1; x++) {
+            int cluster = rowStart + x;
+            float dx = std::max(minX[cluster] - sphere.x, 0.0f) + std::max(sphere.x - maxX[cluster], 0.0f);
+            float dy = std::max(minY[cluster] - sphere.y, 0.0f) + std::max(sphere.y - maxY[cluster], 0.0f);
+            float dz = std::max(minZ[cluster] - sphere.z, 0.0f) + std::max(sphere.z - maxZ[cluster], 0.0f);
+            if (dx * dx + dy * dy + dz * dz <= sphere.w * sphere.w)
+                hits.push_back({ (unsigned int)cluster, light });
+        }
+    }
+
+#ifdef LIGHT_CLUSTERS_SSE
+    // same test, four froxels at a time (TILES_X is a multiple of 4, so a group never spans two rows)
+    void testRowSimd(const glm::vec4& sphere, unsigned int light, int rowStart, int x0, int x1, std::vector<Hit>& hits) {
+        const __m128 zero = _mm_setzero_ps();
+        const __m128 cx = _mm_set1_ps(sphere.x), cy = _mm_set1_ps(sphere.y), cz = _mm_set1_ps(sphere.z);
+        const __m128 radius2 = _mm_set1_ps(sphere.w * sphere.w);
+        for (int x = x0 & ~3; x <= x1; x += 4) {
+            int cluster = rowStart + x;
+            __m128 dx = _mm_add_ps(_mm_max_ps(_mm_sub_ps(_mm_loadu_ps(&minX[cluster]), cx), zero), _mm_max_ps(_mm_sub_ps(cx, _mm_loadu_ps(&maxX[cluster])), zero));
+            __m128 dy = _mm_add_ps(_mm_max_ps(_mm_sub_ps(_mm_loadu_ps(&minY[cluster]), cy), zero), _mm_max_ps(_mm_sub_ps(cy, _mm_loadu_ps(&maxY[cluster])), zero));
+            __m128 dz = _mm_add_ps(_mm_max_ps(_mm_sub_ps(_mm_loadu_ps(&minZ[cluster]), cz), zero), _mm_max_ps(_mm_sub_ps(cz, _mm_loadu_ps(&maxZ[cluster])), zero));
+            __m128 distance2 = _mm_add_ps(_mm_add_ps(_mm_mul_ps(dx, dx), _mm_mul_ps(dy, dy)), _mm_mul_ps(dz, dz));
+            // lanes outside [x0, x1] belong to the group but not to the light's range
+            int lanes = (0xF << std::max(x0 - x, 0)) & (0xF >> std::max(x + 3 - x1, 0));
+            int inside = _mm_movemask_ps(_mm_cmple_ps(distance2, radius2)) & lanes;
+            while (inside != 0) {
+                static const unsigned char LOWEST_LANE[16] = { 0, 0, 1, 0, 2, 0, 1, 0, 3, 0, 1, 0, 2, 0, 1, 0 };
+                hits.push_back({ (unsigned int)(cluster + LOWEST_LANE[inside]), light });
+                inside &= inside - 1;
+            }
+        }
+    }
+#endif
+};
+
+#endif
@@ -0,0 +1,201 @@
+#ifndef LIGHT_CULLING_H
+#define LIGHT_CULLING_H
+
+#include <glm/glm.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+// distance at which a light of the given intensity (its brightest channel), dimmed by
+// 1 / (constant + linear * d + quadratic * d^2), falls to cutoff. 5/256 is the usual cutoff for 8-bit output.
+inline float attenuationRadius(float constant, float linear, float quadratic, float intensity, float cutoff = 5.0f / 256.0f) {
+    float c = constant - intensity / cutoff;
+    if (c >= 0.0f)
+        return 0.0f; // never brighter than the cutoff
+    if (quadratic <= 0.0f)
+        return linear > 0.0f ? -c / linear : INFINITY;
+    return (-linear + std::sqrt(linear * linear - 4.0f * quadratic * c)) / (2.0f * quadratic);
+}
+
+// the view frustum's six planes from the rows of the view-projection matrix (Gribb/Hartmann), normalized so
+// sphereInFrustum() can compare distances with a radius
+inline void frustumPlanes(const glm::mat4& viewProjection, glm::vec4 planes[6]) {
+    glm::mat4 m = glm::transpose(viewProjection);
+    planes[0] = m[3] + m[0];
+    planes[1] = m[3] - m[0];
+    planes[2] = m[3] + m[1];
+    planes[3] = m[3] - m[1];
+    planes[4] = m[3] + m[2];
+    planes[5] = m[3] - m[2];
+    for (int i = 0; i < 6; i++)
+        planes[i] /= glm::length(glm::vec3(planes[i]));
+}
+
+// false only when the sphere is entirely outside one of the planes
+inline bool sphereInFrustum(const glm::vec4 planes[6], const glm::vec3& center, float radius) {
+    for (int i = 0; i < 6; i++)
+        if (glm::dot(glm::vec3(planes[i]), center) + planes[i].w < -radius)
+            return false;
+    return true;
+}
+
+// CPU culling for a fixed-size light array (e.g. the Lights block): drops point lights whose radius sphere is
+// outside the view frustum or behind occluders on a coarse depth grid, then keeps the ones with the largest
+// estimated screen contribution.
+//
+//     culler.begin(view, projection);
+//     culler.addOccluder(center, radius);                        // spheres inside opaque objects, optional
+//     const std::vector<unsigned int>& visible = culler.cull(spheres, intensities, MAX_LIGHTS);
+//
+// the occlusion grid stores, per tile, the farthest depth that occluders cover all of the tile with. an occluder
+// only fills the tiles fully inside the square inscribed in its sphere's projection, and a light only counts as
+// hidden if every tile under it is covered closer than the light's nearest point, so it never culls a visible
+// light.
+class LightCuller {
+public:
+    static const int GRID_X = 32;
+    static const int GRID_Y = 18;
+
+    struct Stats {
+        int candidates = 0;
+        int outsideFrustum = 0;
+        int occluded = 0;
+        int dropped = 0; // visible but past maxLights
+        int kept = 0;
+    };
+
+    void begin(const glm::mat4& view, const glm::mat4& projection) {
+        this->view = view;
+        scaleX = projection[0][0];
+        scaleY = projection[1][1];
+        nearPlane = projection[3][2] / (projection[2][2] - 1.0f);
+
+        frustumPlanes(projection * view, planes);
+
+        std::fill(std::begin(grid), std::end(grid), INFINITY);
+    }
+
+    // a world-space sphere that is entirely inside something opaque
+    void addOccluder(const glm::vec3& center, float radius) {
+        glm::vec3 c = glm::vec3(view * glm::vec4(center, 1.0f));
+        float depth = -c.z;
+        if (depth - radius <= nearPlane)
+            return;
+
+        // the disk through the center facing the camera is inside the sphere; the square inscribed in its
+        // projection is covered, no farther than the back of the sphere
+        float half = radius * 0.70710678f;
+        int x0, y0, x1, y1;
+        if (!tileRange(c, half, depth, depth, true, x0, y0, x1, y1))
+            return;
+        float farthest = depth + radius;
+        for (int y = y0; y <= y1; y++)
+            for (int x = x0; x <= x1; x++)
+                grid[y * GRID_X + x] = std::min(grid[y * GRID_X + x], farthest);
+    }
+
+    // spheres are world-space position + radius, intensities the brightness to rank by (e.g. the brightest
+    // color channel). returns the surviving indices, most important first, at most maxLights of them.
+    const std::vector<unsigned int>& cull(const std::vector<glm::vec4>& spheres, const std::vector<float>& intensities, unsigned int maxLights) {
+        frameStats = Stats();
+        frameStats.candidates = (int)spheres.size();
+        ranked.clear();
+
+        for (unsigned int i = 0; i < spheres.size(); i++) {
+            const glm::vec4& sphere = spheres[i];
+            if (!sphereInFrustum(planes, glm::vec3(sphere), sphere.w)) {
+                frameStats.outsideFrustum++;
+                continue;
+            }
+
+            glm::vec3 c = glm::vec3(view * glm::vec4(glm::vec3(sphere), 1.0f));
+            float distance = glm::length(c);
+            if (isOccluded(c, sphere.w)) {
+                frameStats.occluded++;
+                continue;
+            }
+
+            // roughly the solid angle the sphere covers, full weight once the camera is inside it
+            float coverage = distance > sphere.w ? (sphere.w * sphere.w) / (distance * distance) : 1.0f;
+            ranked.push_back({ intensities[i] * coverage, i });
+        }
+
+        std::size_t count = std::min<std::size_t>(ranked.size(), maxLights);
+        std::partial_sort(ranked.begin(), ranked.begin() + count, ranked.end(),
+                          [](const Ranked& a, const Ranked& b) { return a.score > b.score; });
+
+        visible.resize(count);
+        for (std::size_t i = 0; i < count; i++)
+            visible[i] = ranked[i].index;
+        frameStats.kept = (int)count;
+        frameStats.dropped = (int)(ranked.size() - count);
+        return visible;
+    }
+
+    const Stats& stats() const {
+        return frameStats;
+    }
+
+private:
+    struct Ranked {
+        float score;
+        unsigned int index;
+    };
+
+    glm::mat4 view = glm::mat4(1.0f);
+    glm::vec4 planes[6];
+    float scaleX = 1.0f, scaleY = 1.0f, nearPlane = 0.1f;
+    float grid[GRID_X * GRID_Y];
+    std::vector<Ranked> ranked;
+    std::vector<unsigned int> visible;
+    Stats frameStats;
+
+    bool isOccluded(const glm::vec3& c, float radius) const {
+        float nearest = -c.z - radius;
+        if (nearest <= nearPlane)
+            return false;
+
+        // the sphere's view-space box bounds its projection
+        int x0, y0, x1, y1;
+        if (!tileRange(c, radius, nearest, -c.z + radius, false, x0, y0, x1, y1))
+            return false;
+        for (int y = y0; y <= y1; y++)
+            for (int x = x0; x <= x1; x++)
+                if (grid[y * GRID_X + x] >= nearest)
+                    return false;
+        return true;
+    }
+
+    // tiles under the view-space box center.xy +- half between depths nearDepth and farDepth. inner: only tiles
+    // the box covers completely (pass nearDepth == farDepth); otherwise every tile it touches. clamped to the screen
+    bool tileRange(const glm::vec3& center, float half, float nearDepth, float farDepth, bool inner, int& x0, int& y0, int& x1, int& y1) const {
+        // an edge right of (above) the view axis reaches farthest out at the near depth, one left of (below) it at the far one
+        auto project = [&](float edge, float scale, int tiles, bool upper) {
+            float depth = (edge >= 0.0f) == upper ? nearDepth : farDepth;
+            return (edge / depth * scale * 0.5f + 0.5f) * tiles;
+        };
+        float minX = project(center.x - half, scaleX, GRID_X, false);
+        float maxX = project(center.x + half, scaleX, GRID_X, true);
+        float minY = project(center.y - half, scaleY, GRID_Y, false);
+        float maxY = project(center.y + half, scaleY, GRID_Y, true);
+        if (inner) {
+            x0 = (int)std::ceil(minX);
+            y0 = (int)std::ceil(minY);
+            x1 = (int)std::floor(maxX) - 1;
+            y1 = (int)std::floor(maxY) - 1;
+        } else {
+            x0 = (int)std::floor(minX);
+            y0 = (int)std::floor(minY);
+            x1 = (int)std::floor(maxX);
+            y1 = (int)std::floor(maxY);
+        }
+        x0 = std::max(x0, 0);
+        y0 = std::max(y0, 0);
+        x1 = std::min(x1, GRID_X - 1);
+        y1 = std::min(y1, GRID_Y - 1);
+        return x0 <= x1 && y0 <= y1;
+    }
+};
+
+#endif
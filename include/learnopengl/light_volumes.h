@@ -0,0 +1,143 @@
+#ifndef LIGHT_VOLUMES_H
+#define LIGHT_VOLUMES_H
+
+#include <glad/glad.h>
+
+#include <glm/glm.hpp>
+
+#include "learnopengl/gl_state.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <vector>
+
+// one point light as src/shaders/point_light.glsl reads it. positions are view-space, so neither path
+// transforms lights per fragment; rewrite the array when the camera moves.
+struct ViewSpacePointLight {
+    glm::vec3 position; float radius;
+    glm::vec3 color;    float padding0;
+};
+
+static_assert(sizeof(ViewSpacePointLight) == 32, "ViewSpacePointLight is two RGBA32F texels");
+
+// Point lights for the deferred lighting pass, drawn as instanced spheres that cover each light's radius so
+// only the pixels a light can reach are shaded. The same buffer is also exposed as a texture buffer, which is
+// how the forward path loops over the lights; one upload per frame serves both renderers.
+//
+//     LightVolumes volumes(MAX_LIGHTS);
+//     volumes.update(lights);          // once per frame
+//     volumes.draw();                  // deferred: one instanced draw, attributes 0 (vertex), 1-2 (light)
+//     volumes.bindBuffer(unit);        // forward: samplerBuffer, two texels per light
+//
+// deleteBuffers() frees the sphere mesh, the per-light instance buffer and the buffer texture over it.
+class LightVolumes {
+public:
+    unsigned int VAO;
+
+    explicit LightVolumes(unsigned int maxLights) : maxLights(maxLights) {
+        std::vector<glm::vec3> vertices = makeSphere();
+        nrVertices = (int)vertices.size();
+
+        glGenVertexArrays(1, &VAO);
+        glGenBuffers(1, &sphereVBO);
+        glGenBuffers(1, &lightVBO);
+        GLState::bindVertexArray(VAO);
+
+        glBindBuffer(GL_ARRAY_BUFFER, sphereVBO);
+        glBufferData(GL_ARRAY_BUFFER, vertices.size() * sizeof(glm::vec3), vertices.data(), GL_STATIC_DRAW);
+        glEnableVertexAttribArray(0);
+        glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(glm::vec3), (void*)0);
+
+        // per instance: position + radius, color
+        glBindBuffer(GL_ARRAY_BUFFER, lightVBO);
+        glBufferData(GL_ARRAY_BUFFER, maxLights * sizeof(ViewSpacePointLight), NULL, GL_STREAM_DRAW);
+        glEnableVertexAttribArray(1);
+        glVertexAttribPointer(1, 4, GL_FLOAT, GL_FALSE, sizeof(ViewSpacePointLight), (void*)offsetof(ViewSpacePointLight, position));
+        glVertexAttribDivisor(1, 1);
+        glEnableVertexAttribArray(2);
+        glVertexAttribPointer(2, 4, GL_FLOAT, GL_FALSE, sizeof(ViewSpacePointLight), (void*)offsetof(ViewSpacePointLight, color));
+        glVertexAttribDivisor(2, 1);
+
+        GLState::bindVertexArray(0);
+        glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+        glGenTextures(1, &lightTexture);
+        GLState::bindTexture(GL_TEXTURE_BUFFER, lightTexture);
+        glTexBuffer(GL_TEXTURE_BUFFER, GL_RGBA32F, lightVBO);
+    }
+
+    LightVolumes(const LightVolumes&) = delete;
+    LightVolumes& operator=(const LightVolumes&) = delete;
+
+    // lights past maxLights are ignored
+    void update(const std::vector<ViewSpacePointLight>& lights) {
+        nrLights = (unsigned int)std::min<std::size_t>(lights.size(), maxLights);
+        glBindBuffer(GL_ARRAY_BUFFER, lightVBO);
+        // orphan, then fill: last frame's draws may still be reading the old contents
+        glBufferData(GL_ARRAY_BUFFER, maxLights * sizeof(ViewSpacePointLight), NULL, GL_STREAM_DRAW);
+        glBufferSubData(GL_ARRAY_BUFFER, 0, nrLights * sizeof(ViewSpacePointLight), lights.data());
+        glBindBuffer(GL_ARRAY_BUFFER, 0);
+    }
+
+    unsigned int size() const {
+        return nrLights;
+    }
+
+    // one sphere per light. the caller sets up blending/culling/depth state for the lighting pass.
+    void draw() const {
+        GLState::bindVertexArray(VAO);
+        glDrawArraysInstanced(GL_TRIANGLES, 0, nrVertices, nrLights);
+    }
+
+    void bindBuffer(unsigned int unit) const {
+        GLState::bindTexture(unit, GL_TEXTURE_BUFFER, lightTexture);
+    }
+
+    void deleteBuffers() {
+        GLState::forgetVertexArray(VAO);
+        GLState::forgetTexture(lightTexture);
+        glDeleteVertexArrays(1, &VAO);
+        glDeleteBuffers(1, &sphereVBO);
+        glDeleteBuffers(1, &lightVBO);
+        glDeleteTextures(1, &lightTexture);
+    }
+
+private:
+    static const int SPHERE_SEGMENTS = 16;
+    static const int SPHERE_RINGS = 8;
+
+    unsigned int maxLights;
+    unsigned int nrLights = 0;
+    int nrVertices = 0;
+    unsigned int sphereVBO, lightVBO, lightTexture;
+
+    // unit UV sphere as a triangle list, pushed out so its flat faces still enclose the unit sphere
+    static std::vector<glm::vec3> makeSphere() {
+        const float PI = 3.14159265359f;
+        float scale = 1.0f / (std::cos(PI / SPHERE_SEGMENTS) * std::cos(PI / (2 * SPHERE_RINGS)));
+        auto point = [&](int segment, int ring) {
+            float theta = 2.0f * PI * segment / SPHERE_SEGMENTS;
+            float phi = PI * ring / SPHERE_RINGS;
+            return scale * glm::vec3(std::sin(phi) * std::cos(theta), std::cos(phi), std::sin(phi) * std::sin(theta));
+        };
+
+        // counter-clockwise seen from outside, so culling front faces keeps the far side
+        std::vector<glm::vec3> vertices;
+        for (int ring = 0; ring < SPHERE_RINGS; ring++) {
+            for (int segment = 0; segment < SPHERE_SEGMENTS; segment++) {
+                glm::vec3 a = point(segment, ring), b = point(segment + 1, ring);
+                glm::vec3 c = point(segment, ring + 1), d = point(segment + 1, ring + 1);
+                if (ring > 0) {
+                    vertices.push_back(a); vertices.push_back(b); vertices.push_back(c);
+                }
+                if (ring < SPHERE_RINGS - 1) {
+                    vertices.push_back(b); vertices.push_back(d); vertices.push_back(c);
+                }
+            }
+        }
+        return vertices;
+    }
+};
+
+#endif
@@ -0,0 +1,377 @@
+#ifndef LIGHTMAP_BAKER_H
+#define LIGHTMAP_BAKER_H
+
+#include <glad/glad.h>
+
+#include <glm/glm.hpp>
+
+#include "learnopengl/bake_scene.h"
+#include "learnopengl/gl_state.h"
+#include "learnopengl/shader_cache.h"
+#include "learnopengl/thread_pool.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <map>
+#include <tuple>
+#include <vector>
+
+// Bakes the static lights of a BakeScene into one lightmap atlas on the CPU: the lights' ambient terms, direct
+// diffuse light with ray-traced shadows, and one bounce of indirect light. Static surfaces then shade with a
+// single texture fetch (irradiance, multiplied by their diffuse map) instead of looping over the lights.
+//
+// UVs: every mesh is unwrapped once into planar charts (triangles sharing a plane), packed into the mesh's own
+// rectangle with a gutter of padding texels around each chart. Every instance gets its own copy of that
+// rectangle in the atlas, reached through a per-instance scale/offset:
+//
+//     atlasUV = meshUV * scaleOffset.xy + scaleOffset.zw
+//
+// Texels are baked in parallel on a ThreadPool, then the gutters are filled from their neighbors so bilinear
+// filtering doesn't pull in unbaked black. The result is cached on disk under a hash of the scene, the lights
+// and the settings (like ShaderCache), so unchanged scenes load instead of baking.
+//
+//     LightmapBaker lightmaps(scene);            // after the scene's last addInstance() and build()
+//     lightmaps.bake(pool);                      // or load from the cache
+//     unsigned int texture = lightmaps.createTexture();
+//     ... meshUVs(mesh) as a vertex attribute, scaleOffset(instance) per draw ...
+class LightmapBaker {
+public:
+    struct Settings {
+        float texelsPerUnit = 16.0f; // in model space
+        int padding = 2;             // texels of gutter around every chart
+        int atlasWidth = 512;
+        int samples = 64;            // hemisphere rays per texel for the bounce
+        std::filesystem::path cacheDirectory = std::filesystem::current_path() / "lightmap_cache";
+    };
+
+    explicit LightmapBaker(const BakeScene& scene) : LightmapBaker(scene, Settings()) {}
+
+    LightmapBaker(const BakeScene& scene, const Settings& settings) : scene(scene), settings(settings) {
+        std::size_t nrMeshes = 0;
+        for (const BakeScene::Instance& instance : scene.instances())
+            nrMeshes = std::max(nrMeshes, (std::size_t)instance.mesh + 1);
+        charts.resize(nrMeshes);
+        for (std::size_t mesh = 0; mesh < nrMeshes; mesh++)
+            charts[mesh] = unwrap(scene.mesh((int)mesh));
+
+        // every instance gets its mesh's rectangle
+        std::vector<glm::ivec2> sizes;
+        for (const BakeScene::Instance& instance : scene.instances())
+            sizes.push_back(glm::ivec2(charts[instance.mesh].width, charts[instance.mesh].height));
+        atlasWidth = settings.atlasWidth;
+        for (const glm::ivec2& size : sizes)
+            atlasWidth = std::max(atlasWidth, size.x);
+        atlasHeight = std::max(1, shelfPack(sizes, atlasWidth, rects));
+    }
+
+    LightmapBaker(const LightmapBaker&) = delete;
+    LightmapBaker& operator=(const LightmapBaker&) = delete;
+
+    // loads the atlas from the cache if this exact bake was done before, otherwise bakes and stores it.
+    // returns true on a cache hit.
+    bool bake(ThreadPool& pool) {
+        std::uint64_t key = cacheKey();
+        if (loadCache(key))
+            return true;
+
+        std::vector<Sample> samples = rasterize();
+        texels.assign((std::size_t)atlasWidth * atlasHeight, glm::vec3(0.0f));
+
+        const std::size_t CHUNK = 64;
+        pool.parallelFor((samples.size() + CHUNK - 1) / CHUNK, [&](std::size_t chunk) {
+            std::size_t end = std::min(samples.size(), (chunk + 1) * CHUNK);
+            for (std::size_t i = chunk * CHUNK; i < end; i++)
+                texels[samples[i].texel] = irradiance(samples[i], (std::uint32_t)i);
+        });
+
+        std::vector<char> covered((std::size_t)atlasWidth * atlasHeight, 0);
+        for (const Sample& sample : samples)
+            covered[sample.texel] = 1;
+        dilate(covered);
+
+        storeCache(key);
+        return false;
+    }
+
+    // per-vertex UVs of a mesh in [0, 1] over its rectangle, parallel to BakeScene::mesh()
+    const std::vector<glm::vec2>& meshUVs(int mesh) const {
+        return charts[mesh].uvs;
+    }
+
+    glm::vec4 scaleOffset(int instance) const {
+        const Chart& chart = charts[scene.instances()[instance].mesh];
+        const glm::ivec2& origin = rects[instance];
+        return glm::vec4((float)chart.width / atlasWidth, (float)chart.height / atlasHeight,
+                         (float)origin.x / atlasWidth, (float)origin.y / atlasHeight);
+    }
+
+    int width() const { return atlasWidth; }
+    int height() const { return atlasHeight; }
+
+    // linear irradiance, rows bottom to top (as glTexImage2D takes them)
+    const std::vector<glm::vec3>& irradianceTexels() const {
+        return texels;
+    }
+
+    // RGB16F with bilinear filtering; the gutters keep neighboring charts from bleeding into each other
+    unsigned int createTexture() const {
+        unsigned int texture;
+        glGenTextures(1, &texture);
+        GLState::bindTexture(GL_TEXTURE_2D, texture);
+        glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB16F, atlasWidth, atlasHeight, 0, GL_RGB, GL_FLOAT, texels.data());
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+        return texture;
+    }
+
+private:
+    static constexpr char CACHE_MAGIC[8] = { 'L', 'O', 'G', 'L', 'L', 'M', '0', '1' };
+
+    // a mesh's unwrap: UVs normalized over a width x height texel rectangle
+    struct Chart {
+        std::vector<glm::vec2> uvs;
+        int width = 1;
+        int height = 1;
+    };
+
+    // one texel center that lies on a triangle
+    struct Sample {
+        std::size_t texel;
+        glm::vec3 position;
+        glm::vec3 normal;
+    };
+
+    const BakeScene& scene;
+    Settings settings;
+    std::vector<Chart> charts;
+    std::vector<glm::ivec2> rects; // per instance, atlas texel origin
+    int atlasWidth = 1, atlasHeight = 1;
+    std::vector<glm::vec3> texels;
+
+    // shelf packing, tallest first; returns the height used
+    static int shelfPack(const std::vector<glm::ivec2>& sizes, int width, std::vector<glm::ivec2>& origins) {
+        std::vector<std::size_t> order(sizes.size());
+        for (std::size_t i = 0; i < order.size(); i++)
+            order[i] = i;
+        std::stable_sort(order.begin(), order.end(), [&](std::size_t a, std::size_t b) { return sizes[a].y > sizes[b].y; });
+
+        origins.assign(sizes.size(), glm::ivec2(0));
+        int x = 0, y = 0, shelfHeight = 0;
+        for (std::size_t i : order) {
+            if (x + sizes[i].x > width) {
+                x = 0;
+                y += shelfHeight;
+                shelfHeight = 0;
+            }
+            origins[i] = glm::ivec2(x, y);
+            x += sizes[i].x;
+            shelfHeight = std::max(shelfHeight, sizes[i].y);
+        }
+        return y + shelfHeight;
+    }
+
+    Chart unwrap(const std::vector<glm::vec3>& positions) const {
+        // group triangles by the plane they lie in
+        std::map<std::tuple<int, int, int, int>, std::vector<std::size_t>> planes;
+        for (std::size_t t = 0; t + 2 < positions.size(); t += 3) {
+            glm::vec3 n = glm::normalize(glm::cross(positions[t + 1] - positions[t], positions[t + 2] - positions[t]));
+            float d = glm::dot(n, positions[t]);
+            planes[std::make_tuple((int)std::lround(n.x * 1000.0f), (int)std::lround(n.y * 1000.0f), (int)std::lround(n.z * 1000.0f),
+                                   (int)std::lround(d * 1000.0f))].push_back(t);
+        }
+
+        // project each plane's triangles onto it, in texels
+        std::vector<std::vector<std::size_t>> chartTriangles;
+        std::vector<glm::ivec2> sizes;
+        Chart chart;
+        chart.uvs.assign(positions.size(), glm::vec2(0.0f));
+        std::vector<glm::vec2> texelUVs(positions.size());
+        for (const auto& plane : planes) {
+            const std::vector<std::size_t>& triangles = plane.second;
+            glm::vec3 n = glm::normalize(glm::cross(positions[triangles[0] + 1] - positions[triangles[0]], positions[triangles[0] + 2] - positions[triangles[0]]));
+            glm::vec3 u = glm::normalize(glm::cross(std::abs(n.y) < 0.99f ? glm::vec3(0.0f, 1.0f, 0.0f) : glm::vec3(1.0f, 0.0f, 0.0f), n));
+            glm::vec3 v = glm::cross(n, u);
+
+            glm::vec2 minUV(INFINITY), maxUV(-INFINITY);
+            for (std::size_t t : triangles)
+                for (std::size_t k = t; k < t + 3; k++) {
+                    texelUVs[k] = glm::vec2(glm::dot(positions[k], u), glm::dot(positions[k], v)) * settings.texelsPerUnit;
+                    minUV = glm::min(minUV, texelUVs[k]);
+                    maxUV = glm::max(maxUV, texelUVs[k]);
+                }
+            for (std::size_t t : triangles)
+                for (std::size_t k = t; k < t + 3; k++)
+                    texelUVs[k] += glm::vec2((float)settings.padding) - minUV;
+
+            chartTriangles.push_back(triangles);
+            sizes.push_back(glm::ivec2((int)std::ceil(maxUV.x - minUV.x), (int)std::ceil(maxUV.y - minUV.y)) + 2 * settings.padding);
+        }
+
+        // roughly square
+        int area = 0, widest = 1;
+        for (const glm::ivec2& size : sizes) {
+            area += size.x * size.y;
+            widest = std::max(widest, size.x);
+        }
+        chart.width = std::max(widest, (int)std::ceil(std::sqrt((float)area)));
+        std::vector<glm::ivec2> origins;
+        chart.height = std::max(1, shelfPack(sizes, chart.width, origins));
+
+        for (std::size_t c = 0; c < chartTriangles.size(); c++)
+            for (std::size_t t : chartTriangles[c])
+                for (std::size_t k = t; k < t + 3; k++)
+                    chart.uvs[k] = (texelUVs[k] + glm::vec2(origins[c])) / glm::vec2((float)chart.width, (float)chart.height);
+        return chart;
+    }
+
+    // the texel centers every instance's triangles cover, with their world position and normal
+    std::vector<Sample> rasterize() const {
+        std::vector<Sample> samples;
+        std::vector<char> covered((std::size_t)atlasWidth * atlasHeight, 0);
+        const std::vector<glm::vec3>& world = scene.vertices();
+
+        for (std::size_t i = 0; i < scene.instances().size(); i++) {
+            const BakeScene::Instance& instance = scene.instances()[i];
+            const Chart& chart = charts[instance.mesh];
+            glm::vec2 scale((float)chart.width, (float)chart.height);
+            glm::vec2 origin(rects[i]);
+
+            for (std::size_t t = 0; t < chart.uvs.size() / 3; t++) {
+                unsigned int triangle = instance.firstTriangle + (unsigned int)t;
+                glm::vec2 a = chart.uvs[3 * t] * scale + origin;
+                glm::vec2 b = chart.uvs[3 * t + 1] * scale + origin;
+                glm::vec2 c = chart.uvs[3 * t + 2] * scale + origin;
+                float area = (b.x - a.x) * (c.y - a.y) - (c.x - a.x) * (b.y - a.y);
+                if (std::abs(area) < 1e-8f)
+                    continue;
+                glm::vec3 normal = scene.triangleNormal(triangle);
+
+                int x0 = std::max(0, (int)std::floor(std::min(a.x, std::min(b.x, c.x))));
+                int y0 = std::max(0, (int)std::floor(std::min(a.y, std::min(b.y, c.y))));
+                int x1 = std::min(atlasWidth - 1, (int)std::ceil(std::max(a.x, std::max(b.x, c.x))));
+                int y1 = std::min(atlasHeight - 1, (int)std::ceil(std::max(a.y, std::max(b.y, c.y))));
+                for (int y = y0; y <= y1; y++) {
+                    for (int x = x0; x <= x1; x++) {
+                        std::size_t texel = (std::size_t)y * atlasWidth + x;
+                        if (covered[texel])
+                            continue;
+                        glm::vec2 p(x + 0.5f, y + 0.5f);
+                        float wb = ((p.x - a.x) * (c.y - a.y) - (c.x - a.x) * (p.y - a.y)) / area;
+                        float wc = ((b.x - a.x) * (p.y - a.y) - (p.x - a.x) * (b.y - a.y)) / area;
+                        float wa = 1.0f - wb - wc;
+                        if (wa < 0.0f || wb < 0.0f || wc < 0.0f)
+                            continue;
+                        covered[texel] = 1;
+                        glm::vec3 position = world[3 * triangle] * wa + world[3 * triangle + 1] * wb + world[3 * triangle + 2] * wc;
+                        samples.push_back({ texel, position, normal });
+                    }
+                }
+            }
+        }
+        return samples;
+    }
+
+    glm::vec3 irradiance(const Sample& sample, std::uint32_t seed) const {
+        glm::vec3 result = scene.ambient(sample.position) + scene.directIrradiance(sample.position, sample.normal);
+
+        // cosine-weighted rays, so the bounce is just their average
+        BakeScene::Random random(seed);
+        glm::vec3 origin = sample.position + sample.normal * scene.rayBias;
+        glm::vec3 bounce(0.0f);
+        for (int s = 0; s < settings.samples; s++)
+            bounce += scene.bouncedRadiance(origin, BakeScene::sampleHemisphere(sample.normal, random));
+        return result + bounce / (float)std::max(1, settings.samples);
+    }
+
+    // grows the baked texels into the gutters, one ring per pass
+    void dilate(std::vector<char>& covered) {
+        for (int pass = 0; pass < settings.padding; pass++) {
+            std::vector<char> next = covered;
+            for (int y = 0; y < atlasHeight; y++) {
+                for (int x = 0; x < atlasWidth; x++) {
+                    std::size_t texel = (std::size_t)y * atlasWidth + x;
+                    if (covered[texel])
+                        continue;
+                    glm::vec3 sum(0.0f);
+                    int count = 0;
+                    for (int dy = -1; dy <= 1; dy++) {
+                        for (int dx = -1; dx <= 1; dx++) {
+                            int nx = x + dx, ny = y + dy;
+                            if (nx < 0 || ny < 0 || nx >= atlasWidth || ny >= atlasHeight)
+                                continue;
+                            std::size_t neighbor = (std::size_t)ny * atlasWidth + nx;
+                            if (covered[neighbor]) {
+                                sum += texels[neighbor];
+                                count++;
+                            }
+                        }
+                    }
+                    if (count > 0) {
+                        texels[texel] = sum / (float)count;
+                        next[texel] = 1;
+                    }
+                }
+            }
+            covered.swap(next);
+        }
+    }
+
+    std::uint64_t cacheKey() const {
+        std::uint64_t hash = ShaderCache::hashBytes(CACHE_MAGIC, sizeof(CACHE_MAGIC));
+        for (const BakeScene::Instance& instance : scene.instances()) {
+            const std::vector<glm::vec3>& mesh = scene.mesh(instance.mesh);
+            hash = ShaderCache::hashBytes(mesh.data(), mesh.size() * sizeof(glm::vec3), hash);
+            hash = ShaderCache::hashBytes(&instance.model, sizeof(instance.model), hash);
+            hash = ShaderCache::hashBytes(&instance.albedo, sizeof(instance.albedo), hash);
+        }
+        hash = ShaderCache::hashBytes(&scene.directionalLight(), sizeof(DirectionalLightStd140), hash);
+        hash = ShaderCache::hashBytes(scene.pointLights().data(), scene.pointLights().size() * sizeof(PointLightStd140), hash);
+        hash = ShaderCache::hashBytes(&settings.texelsPerUnit, sizeof(settings.texelsPerUnit), hash);
+        hash = ShaderCache::hashBytes(&settings.padding, sizeof(settings.padding), hash);
+        hash = ShaderCache::hashBytes(&settings.samples, sizeof(settings.samples), hash);
+        hash = ShaderCache::hashBytes(&scene.rayBias, sizeof(scene.rayBias), hash);
+        return ShaderCache::hashBytes(&atlasWidth, sizeof(atlasWidth), hash);
+    }
+
+    std::filesystem::path cachePath(std::uint64_t key) const {
+        char name[32];
+        std::snprintf(name, sizeof(name), "%016llx.bin", static_cast<unsigned long long>(key));
+        return settings.cacheDirectory / name;
+    }
+
+    bool loadCache(std::uint64_t key) {
+        std::ifstream file(cachePath(key), std::ios::binary);
+        if (!file)
+            return false;
+        char magic[sizeof(CACHE_MAGIC)];
+        int size[2] = {};
+        file.read(magic, sizeof(magic));
+        file.read(reinterpret_cast<char*>(size), sizeof(size));
+        if (!file || std::memcmp(magic, CACHE_MAGIC, sizeof(magic)) != 0 || size[0] != atlasWidth || size[1] != atlasHeight)
+            return false;
+        texels.resize((std::size_t)atlasWidth * atlasHeight);
+        file.read(reinterpret_cast<char*>(texels.data()), texels.size() * sizeof(glm::vec3));
+        return (bool)file;
+    }
+
+    void storeCache(std::uint64_t key) const {
+        std::error_code ec;
+        std::filesystem::create_directories(settings.cacheDirectory, ec);
+        std::ofstream file(cachePath(key), std::ios::binary);
+        if (!file)
+            return;
+        int size[2] = { atlasWidth, atlasHeight };
+        file.write(CACHE_MAGIC, sizeof(CACHE_MAGIC));
+        file.write(reinterpret_cast<const char*>(size), sizeof(size));
+        file.write(reinterpret_cast<const char*>(texels.data()), texels.size() * sizeof(glm::vec3));
+    }
+};
+
+#endif
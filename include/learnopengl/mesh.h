@@ -6,6 +6,7 @@
 #include "glm/glm.hpp"
 #include "glm/gtc/matrix_transform.hpp"
 
+#include "learnopengl/gl_state.h"
 #include "learnopengl/shader.h"
 
 #include <string>
@@ -40,50 +41,53 @@ class Mesh {
 
             // now that we have all the required data, set the vertex buffers and its attribute pointers.
             setupMesh();
+            setupSamplerNames();
         }
 
-        // render the mesh
+        // render the mesh. bindings go through GLState, so meshes sharing textures don't rebind them, and
+        // nothing is reset afterwards: the next draw binds what it needs.
         void Draw(Shader &shader) {
-            // bind appropriate textures
-            unsigned int diffuseNr  = 1;
-            unsigned int specularNr = 1;
-            unsigned int normalNr   = 1;
-            for (int i = 0; i < textures.size(); i++) {
-                glActiveTexture(GL_TEXTURE0 + i); // active proper texture unit before binding
-                                                  // retrieve texture number (the N in diffuse_textureN)
-                string number;
-                string name = textures[i].type;
-                if (name == "texture_diffuse") {
-                        number = diffuseNr;
-                        diffuseNr++;
-
-                } else if (name == "texture_specular") {
-                        number = specularNr;
-                        specularNr++;
-
-                } else if (name == "texture_normal") {
-                        number = normalNr;
-                        normalNr++;
-                }
-
-                // now set the sampler to the correct texture unit
-                glUniform1i(glGetUniformLocation(shader.ID, (name + number).c_str()), i);
-                // and finally bind the texture
-                glBindTexture(GL_TEXTURE_2D, textures[i].id);
-            }
+            bindTextures(shader);
 
             // draw mesh
-            glBindVertexArray(VAO);
+            GLState::bindVertexArray(VAO);
             glDrawElements(GL_TRIANGLES, static_cast<unsigned int>(indices.size()), GL_UNSIGNED_INT, 0);
-            glBindVertexArray(0);
+        }
 
-            // always good practice to set everything back to defaults once configured.
-            glActiveTexture(GL_TEXTURE0);
+        // binds the mesh's textures to units 0, 1, ... and points its samplers at them, without drawing; for
+        // draws of this mesh issued from somewhere else (an IndirectDrawBuffer, ...)
+        void bindTextures(Shader &shader) {
+            for (unsigned int i = 0; i < textures.size(); i++) {
+                // set the sampler to the texture unit
+                shader.setInt(samplerNames[i], static_cast<int>(i));
+                // and bind the texture to that unit
+                GLState::bindTexture(i, GL_TEXTURE_2D, textures[i].id);
+            }
         }
 
     private:
         // render data 
         unsigned int VBO, EBO;
+        // sampler uniform per texture (texture_diffuseN, texture_specularN, ...), hashed once up front
+        vector<UniformName> samplerNames;
+
+        // retrieve texture number (the N in diffuse_textureN) for every texture
+        void setupSamplerNames() {
+            unsigned int diffuseNr  = 1;
+            unsigned int specularNr = 1;
+            unsigned int normalNr   = 1;
+            for (unsigned int i = 0; i < textures.size(); i++) {
+                string number;
+                string name = textures[i].type;
+                if (name == "texture_diffuse")
+                    number = to_string(diffuseNr++);
+                else if (name == "texture_specular")
+                    number = to_string(specularNr++);
+                else if (name == "texture_normal")
+                    number = to_string(normalNr++);
+                samplerNames.push_back(UniformName(name + number));
+            }
+        }
 
         // initializes all the buffer objects/arrays
         void setupMesh() {
@@ -92,7 +96,7 @@ class Mesh {
             glGenBuffers(1, &VBO);
             glGenBuffers(1, &EBO);
 
-            glBindVertexArray(VAO);
+            GLState::bindVertexArray(VAO);
 
             // NOTE: A great thing about structs is that their memory layout is sequential for all its items.
             //          The effect is that we can simply pass a pointer to the struct and it translates perfectly to a glm::vec3/2 array which
@@ -5,11 +5,12 @@
 
 #include "glm/glm.hpp"
 #include "glm/gtc/matrix_transform.hpp"
-#include "stb_image/stb_image.h"
 #include "assimp/Importer.hpp"
 #include "assimp/scene.h"
 #include "assimp/postprocess.h"
 
+#include "learnopengl/gl_state.h"
+#include "learnopengl/image_decoder.h"
 #include "learnopengl/mesh.h"
 #include "learnopengl/shader.h"
 
@@ -169,32 +170,28 @@ unsigned int TextureFromFile(const char* path, const string& directory) {
     filename = directory + '/' + filename;
     unsigned int textureID;
     glGenTextures(1, &textureID);
-    int width, height, nrComponents;
     // load in texture
-    unsigned char *data = stbi_load(filename.c_str(), &width, &height, &nrComponents, 0);
-    if (data) {
+    DecodedImage image;
+    if (ImageDecoders::load(filename, image)) {
         GLenum format;
-        if (nrComponents == 1)
+        if (image.nrComponents == 1)
             format = GL_RED;
-        else if (nrComponents == 3)
+        else if (image.nrComponents == 3)
             format = GL_RGB;
-        else if (nrComponents == 4)
+        else if (image.nrComponents == 4)
             format = GL_RGBA;
 
-        glBindTexture(GL_TEXTURE_2D, textureID);
-        glTexImage2D(GL_TEXTURE_2D, 0, format, width, height, 0, format, GL_UNSIGNED_BYTE, data);
+        GLState::bindTexture(GL_TEXTURE_2D, textureID);
+        glTexImage2D(GL_TEXTURE_2D, 0, format, image.width, image.height, 0, format, GL_UNSIGNED_BYTE, image.pixels.get());
         glGenerateMipmap(GL_TEXTURE_2D);
 
         glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
         glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
         glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
         glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-
-        stbi_image_free(data);
     }
     else {
         std::cout << "Texture failed to load at path: " << path << std::endl;
-        stbi_image_free(data);
     }
     return textureID;
 }
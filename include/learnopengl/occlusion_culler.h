@@ -0,0 +1,515 @@
+#ifndef OCCLUSION_CULLER_H
+#define OCCLUSION_CULLER_H
+
+#include "learnopengl/thread_pool.h"
+
+#include <glm/glm.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <thread>
+#include <vector>
+
+#if defined(__AVX2__)
+#define OCCLUSION_CULLER_AVX2
+#include <immintrin.h>
+#elif defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define OCCLUSION_CULLER_SSE
+#include <emmintrin.h>
+#endif
+
+#if defined(OCCLUSION_CULLER_AVX2) || defined(OCCLUSION_CULLER_SSE)
+#define OCCLUSION_CULLER_SIMD
+#endif
+
+// Software occlusion culling: a few low-poly occluders (walls, floors, big boxes) are rasterized on the CPU into
+// a small depth buffer, and the bounding boxes of everything else are tested against it before they're drawn.
+//
+//     culler.begin(viewProjection);
+//     culler.addBoxOccluder(wallModel);                  // or addOccluder(vertices, indices, model)
+//     culler.rasterize();
+//     if (!culler.isBoxOccluded(model)) queue.submit(...);
+//
+// The depth buffer has two levels: pixels, in TILE_WIDTH x TILE_HEIGHT tiles, and the farthest depth of each
+// tile. A box whose nearest point is behind a tile's farthest depth is hidden there without looking at the
+// pixels. Triangles are binned to the tiles they touch and the tiles are rasterized in parallel on a ThreadPool,
+// each by one thread, eight (AVX2) or four (SSE2) pixels at a time; a scalar fallback covers other targets.
+// Vertices are snapped to 1/8 pixel, so edge functions are integers: a triangle's edges are set up once per
+// tile and stepped by additions from pixel to pixel and row to row, exactly, and the three signs of a group of
+// pixels make its coverage mask. Only covered pixels get a depth; groups with none are skipped. Triangles are
+// clipped to a guard band 2048 pixels across, which keeps the edge values within 32 bits and limits the buffer
+// to MAX_SIZE pixels a side.
+//
+// Culling is conservative down to the buffer's resolution. Occluders cover the pixels whose centers they cover
+// (so the two triangles of a wall leave no seam), each with the farthest depth its triangle has over the whole
+// pixel, and a box is only hidden if every pixel its projection touches, plus a one pixel border for the partly
+// covered pixels along an occluder's outline, holds a nearer depth than the box's nearest corner. What it can't
+// see is a gap between occluders that is narrower than a pixel. Triangles are clipped at the near plane; boxes
+// that cross it are always visible. Nothing here touches GL, so it can be benchmarked headlessly (see
+// src/benchmarks/occlusion_bench.cpp).
+class OcclusionCuller {
+public:
+    static const int TILE_WIDTH = 32;
+    static const int TILE_HEIGHT = 16;
+    static const int MAX_SIZE = 1024;
+
+    struct Stats {
+        int occluderTriangles = 0;   // passed to addOccluder()
+        int rasterizedTriangles = 0; // left after near clipping and dropping those that can't cover a pixel
+        int binned = 0;              // triangle-tile pairs rasterized
+        int tested = 0;              // boxes tested since begin()
+        int occluded = 0;
+    };
+
+    // false forces the scalar kernels (for comparisons); has no effect without SSE2
+    bool useSimd = true;
+
+    // width and height are clamped to MAX_SIZE and rounded up to whole tiles; 256 x 144 suits a 16:9 view
+    explicit OcclusionCuller(int width = 256, int height = 144,
+                             unsigned int nrThreads = std::max(1u, std::thread::hardware_concurrency()))
+        : pool(nrThreads), tilesX((clampSize(width) + TILE_WIDTH - 1) / TILE_WIDTH),
+          tilesY((clampSize(height) + TILE_HEIGHT - 1) / TILE_HEIGHT),
+          bufferWidth(tilesX * TILE_WIDTH), bufferHeight(tilesY * TILE_HEIGHT),
+          depth(bufferWidth * bufferHeight, 1.0f), tileMax(tilesX * tilesY, 1.0f), bins(tilesX * tilesY) {}
+
+    OcclusionCuller(const OcclusionCuller&) = delete;
+    OcclusionCuller& operator=(const OcclusionCuller&) = delete;
+
+    // starts a frame: drops the previous occluders and empties the depth buffer (once rasterize() runs)
+    void begin(const glm::mat4& viewProjection) {
+        this->viewProjection = viewProjection;
+        triangles.clear();
+        stats_ = Stats();
+        std::fill(depth.begin(), depth.end(), 1.0f);
+        std::fill(tileMax.begin(), tileMax.end(), 1.0f);
+    }
+
+    // an indexed triangle list in model space; both windings occlude
+    void addOccluder(const std::vector<glm::vec3>& vertices, const std::vector<unsigned int>& indices, const glm::mat4& model) {
+        glm::mat4 modelViewProjection = viewProjection * model;
+        clipVertices.resize(vertices.size());
+        for (std::size_t i = 0; i < vertices.size(); i++)
+            clipVertices[i] = modelViewProjection * glm::vec4(vertices[i], 1.0f);
+        for (std::size_t i = 0; i + 2 < indices.size(); i += 3)
+            addTriangle(clipVertices[indices[i]], clipVertices[indices[i + 1]], clipVertices[indices[i + 2]]);
+    }
+
+    // the unit cube [-0.5, 0.5]^3 under model, the same box isBoxOccluded() tests
+    void addBoxOccluder(const glm::mat4& model) {
+        static const std::vector<glm::vec3> corners = unitCubeCorners();
+        static const std::vector<unsigned int> indices = {
+            0, 1, 3, 0, 3, 2,  4, 6, 7, 4, 7, 5,  // -x, +x
+            0, 4, 5, 0, 5, 1,  2, 3, 7, 2, 7, 6,  // -y, +y
+            0, 2, 6, 0, 6, 4,  1, 5, 7, 1, 7, 3   // -z, +z
+        };
+        addOccluder(corners, indices, model);
+    }
+
+    // bins the occluders' triangles to tiles and rasterizes the tiles in parallel
+    void rasterize() {
+        for (std::vector<std::uint32_t>& bin : bins)
+            bin.clear();
+        for (std::uint32_t t = 0; t < (std::uint32_t)triangles.size(); t++) {
+            const Triangle& triangle = triangles[t];
+            for (int ty = triangle.y0 / TILE_HEIGHT; ty <= triangle.y1 / TILE_HEIGHT; ty++)
+                for (int tx = triangle.x0 / TILE_WIDTH; tx <= triangle.x1 / TILE_WIDTH; tx++)
+                    bins[ty * tilesX + tx].push_back(t);
+        }
+        for (const std::vector<std::uint32_t>& bin : bins)
+            stats_.binned += (int)bin.size();
+
+        pool.parallelFor(bins.size(), [this](std::size_t tile) { rasterizeTile((int)tile); });
+    }
+
+    // a world-space axis-aligned box
+    bool isOccluded(const glm::vec3& boxMin, const glm::vec3& boxMax) {
+        glm::vec4 corners[8];
+        for (int i = 0; i < 8; i++) {
+            glm::vec3 corner((i & 4) ? boxMax.x : boxMin.x, (i & 2) ? boxMax.y : boxMin.y, (i & 1) ? boxMax.z : boxMin.z);
+            corners[i] = viewProjection * glm::vec4(corner, 1.0f);
+        }
+        return testCorners(corners);
+    }
+
+    // the unit cube [-0.5, 0.5]^3 under model (an oriented box, tighter than its world-space bounds)
+    bool isBoxOccluded(const glm::mat4& model) {
+        static const std::vector<glm::vec3> unitCorners = unitCubeCorners();
+        glm::mat4 modelViewProjection = viewProjection * model;
+        glm::vec4 corners[8];
+        for (int i = 0; i < 8; i++)
+            corners[i] = modelViewProjection * glm::vec4(unitCorners[i], 1.0f);
+        return testCorners(corners);
+    }
+
+    int width() const {
+        return bufferWidth;
+    }
+
+    int height() const {
+        return bufferHeight;
+    }
+
+    // NDC depth (-1 near to 1 far) stored at pixel (x, y), y up
+    float depthAt(int x, int y) const {
+        return depth[pixelIndex(x, y)];
+    }
+
+    const Stats& stats() const {
+        return stats_;
+    }
+
+private:
+    // screen-space setup of one triangle: edge functions a * x + b * y + c of pixel (x, y), in 1/64ths of a pixel
+    // squared, >= 0 where the pixel's center is inside (or on the edge, so neighbouring triangles overlap rather
+    // than leave gaps); and the triangle's farthest depth over the pixel around (x, y) as a plane, with pixel
+    // centers at + 0.5
+    struct Triangle {
+        std::int32_t a[3], b[3], c[3];
+        float zx, zy, z0;
+        int x0, y0, x1, y1; // bounds of the pixels whose centers it covers, inclusive
+    };
+
+    static const int SUBPIXEL_BITS = 3;
+    static const int GUARD_BAND = 2048; // pixels across, centered on the buffer
+
+    ThreadPool pool;
+    int tilesX, tilesY;
+    int bufferWidth, bufferHeight;
+    glm::mat4 viewProjection = glm::mat4(1.0f);
+
+    std::vector<float> depth;   // tile after tile, each TILE_HEIGHT rows of TILE_WIDTH pixels
+    std::vector<float> tileMax; // farthest depth in each tile
+    std::vector<Triangle> triangles;
+    std::vector<std::vector<std::uint32_t>> bins; // triangles touching each tile
+    std::vector<glm::vec4> clipVertices;
+    Stats stats_;
+
+    static std::vector<glm::vec3> unitCubeCorners() {
+        std::vector<glm::vec3> corners;
+        for (int i = 0; i < 8; i++)
+            corners.push_back(glm::vec3((i & 4) ? 0.5f : -0.5f, (i & 2) ? 0.5f : -0.5f, (i & 1) ? 0.5f : -0.5f));
+        return corners;
+    }
+
+    int pixelIndex(int x, int y) const {
+        int tile = (y / TILE_HEIGHT) * tilesX + x / TILE_WIDTH;
+        return tile * TILE_WIDTH * TILE_HEIGHT + (y % TILE_HEIGHT) * TILE_WIDTH + x % TILE_WIDTH;
+    }
+
+    // clips against the near plane (z >= -w), where the divide would blow up, and the guard band, and sets up
+    // what's left. most triangles are inside all five planes and pass straight through
+    void addTriangle(const glm::vec4& v0, const glm::vec4& v1, const glm::vec4& v2) {
+        stats_.occluderTriangles++;
+        // the guard band in NDC: GUARD_BAND pixels across
+        const float guardX = (float)GUARD_BAND / bufferWidth, guardY = (float)GUARD_BAND / bufferHeight;
+        auto distance = [&](const glm::vec4& v, int plane) {
+            switch (plane) {
+                case 0:  return v.z + v.w;
+                case 1:  return guardX * v.w + v.x;
+                case 2:  return guardX * v.w - v.x;
+                case 3:  return guardY * v.w + v.y;
+                default: return guardY * v.w - v.y;
+            }
+        };
+
+        // each plane adds at most one vertex
+        glm::vec4 polygon[8] = { v0, v1, v2 }, clipped[8];
+        int count = 3;
+        for (int plane = 0; plane < 5 && count >= 3; plane++) {
+            bool inside = true;
+            for (int i = 0; i < count && inside; i++)
+                inside = distance(polygon[i], plane) >= 0.0f;
+            if (inside)
+                continue;
+            int clippedCount = 0;
+            for (int i = 0; i < count; i++) {
+                const glm::vec4& from = polygon[i];
+                const glm::vec4& to = polygon[(i + 1) % count];
+                float fromDistance = distance(from, plane), toDistance = distance(to, plane);
+                if (fromDistance >= 0.0f)
+                    clipped[clippedCount++] = from;
+                if ((fromDistance >= 0.0f) != (toDistance >= 0.0f))
+                    clipped[clippedCount++] = from + (to - from) * (fromDistance / (fromDistance - toDistance));
+            }
+            std::copy(clipped, clipped + clippedCount, polygon);
+            count = clippedCount;
+        }
+        for (int i = 1; i + 1 < count; i++)
+            setupTriangle(polygon[0], polygon[i], polygon[i + 1]);
+    }
+
+    void setupTriangle(const glm::vec4& c0, const glm::vec4& c1, const glm::vec4& c2) {
+        // w is at least the near distance here, but a vertex right on the near plane of an orthographic-ish
+        // projection could still have w = 0
+        if (c0.w <= 0.0f || c1.w <= 0.0f || c2.w <= 0.0f)
+            return;
+        glm::dvec3 p[3];
+        std::int64_t X[3], Y[3]; // snapped, in 1/8 pixels
+        const glm::vec4* clip[3] = { &c0, &c1, &c2 };
+        for (int i = 0; i < 3; i++) {
+            double invW = 1.0 / clip[i]->w;
+            p[i] = glm::dvec3((clip[i]->x * invW * 0.5 + 0.5) * bufferWidth, (clip[i]->y * invW * 0.5 + 0.5) * bufferHeight, clip[i]->z * invW);
+            X[i] = (std::int64_t)std::llround(p[i].x * (1 << SUBPIXEL_BITS));
+            Y[i] = (std::int64_t)std::llround(p[i].y * (1 << SUBPIXEL_BITS));
+        }
+
+        std::int64_t area = (X[1] - X[0]) * (Y[2] - Y[0]) - (X[2] - X[0]) * (Y[1] - Y[0]);
+        if (area == 0)
+            return;
+        if (area < 0) {
+            std::swap(p[1], p[2]);
+            std::swap(X[1], X[2]);
+            std::swap(Y[1], Y[2]);
+            area = -area;
+        }
+
+        // pixels whose centers (8 x + 4 in 1/8 pixels) are within the snapped bounds
+        const std::int64_t half = 1 << (SUBPIXEL_BITS - 1), one = 1 << SUBPIXEL_BITS;
+        auto firstCenter = [&](std::int64_t low) { return (int)floorDivide(low - half + one - 1, one); };
+        auto lastCenter = [&](std::int64_t high) { return (int)floorDivide(high - half, one); };
+        Triangle triangle;
+        triangle.x0 = std::max(firstCenter(std::min({ X[0], X[1], X[2] })), 0);
+        triangle.y0 = std::max(firstCenter(std::min({ Y[0], Y[1], Y[2] })), 0);
+        triangle.x1 = std::min(lastCenter(std::max({ X[0], X[1], X[2] })), bufferWidth - 1);
+        triangle.y1 = std::min(lastCenter(std::max({ Y[0], Y[1], Y[2] })), bufferHeight - 1);
+        if (triangle.x0 > triangle.x1 || triangle.y0 > triangle.y1)
+            return;
+
+        // edge i runs from vertex i to i + 1; its value at the center of pixel (x, y) is
+        // A (8 x + 4) + B (8 y + 4) + C, kept as a * x + b * y + c with c the value at pixel (0, 0). inside the
+        // guard band every value at a pixel of the buffer fits 32 bits, and so does every partial sum on the way
+        for (int i = 0; i < 3; i++) {
+            int j = (i + 1) % 3;
+            std::int64_t A = Y[i] - Y[j], B = X[j] - X[i], C = X[i] * Y[j] - Y[i] * X[j];
+            triangle.a[i] = (std::int32_t)(A * one);
+            triangle.b[i] = (std::int32_t)(B * one);
+            triangle.c[i] = (std::int32_t)((A + B) * half + C);
+        }
+
+        // depth is linear in screen space; the farthest point of the plane over a pixel is half a pixel of
+        // gradient away from its center
+        double depthArea = (p[1].x - p[0].x) * (p[2].y - p[0].y) - (p[2].x - p[0].x) * (p[1].y - p[0].y);
+        if (std::abs(depthArea) < 1e-6)
+            return;
+        double zx = ((p[1].z - p[0].z) * (p[2].y - p[0].y) - (p[2].z - p[0].z) * (p[1].y - p[0].y)) / depthArea;
+        double zy = ((p[2].z - p[0].z) * (p[1].x - p[0].x) - (p[1].z - p[0].z) * (p[2].x - p[0].x)) / depthArea;
+        triangle.zx = (float)zx;
+        triangle.zy = (float)zy;
+        triangle.z0 = (float)(p[0].z - zx * p[0].x - zy * p[0].y + 0.5 * (std::abs(zx) + std::abs(zy)));
+
+        triangles.push_back(triangle);
+        stats_.rasterizedTriangles++;
+    }
+
+    static int clampSize(int size) {
+        return size < 1 ? 1 : (size > MAX_SIZE ? MAX_SIZE : size);
+    }
+
+    static std::int64_t floorDivide(std::int64_t value, std::int64_t divisor) {
+        return value >= 0 ? value / divisor : -((-value + divisor - 1) / divisor);
+    }
+
+    void rasterizeTile(int tile) {
+        int tileX = (tile % tilesX) * TILE_WIDTH, tileY = (tile / tilesX) * TILE_HEIGHT;
+        float* pixels = &depth[tile * TILE_WIDTH * TILE_HEIGHT];
+
+        for (std::uint32_t t : bins[tile]) {
+            const Triangle& triangle = triangles[t];
+            int x0 = std::max(triangle.x0, tileX) - tileX, x1 = std::min(triangle.x1, tileX + TILE_WIDTH - 1) - tileX;
+            int y0 = std::max(triangle.y0, tileY) - tileY, y1 = std::min(triangle.y1, tileY + TILE_HEIGHT - 1) - tileY;
+#ifdef OCCLUSION_CULLER_SIMD
+            if (useSimd) {
+                rasterizeSimd(triangle, pixels, tileX, tileY, x0, y0, x1, y1);
+                continue;
+            }
+#endif
+            rasterize(triangle, pixels, tileX, tileY, x0, y0, x1, y1);
+        }
+
+        float farthest = -1.0f;
+        for (int i = 0; i < TILE_WIDTH * TILE_HEIGHT; i++)
+            farthest = std::max(farthest, pixels[i]);
+        tileMax[tile] = farthest;
+    }
+
+    // pixels (x0..x1, y0..y1) of the tile at screen (tileX, tileY), tile-relative; the edge values start at the
+    // first pixel and are stepped from there
+    void rasterize(const Triangle& triangle, float* pixels, int tileX, int tileY, int x0, int y0, int x1, int y1) const {
+        std::int32_t rowEdges[3];
+        for (int i = 0; i < 3; i++)
+            rowEdges[i] = triangle.c[i] + triangle.a[i] * (tileX + x0) + triangle.b[i] * (tileY + y0);
+        for (int y = y0; y <= y1; y++) {
+            float* row = pixels + y * TILE_WIDTH;
+            float z = triangle.zy * ((float)(tileY + y) + 0.5f) + triangle.z0;
+            std::int32_t e0 = rowEdges[0], e1 = rowEdges[1], e2 = rowEdges[2];
+            for (int x = x0; x <= x1; x++) {
+                if ((e0 | e1 | e2) >= 0)
+                    row[x] = std::min(row[x], triangle.zx * ((float)(tileX + x) + 0.5f) + z);
+                e0 += triangle.a[0];
+                e1 += triangle.a[1];
+                e2 += triangle.a[2];
+            }
+            for (int i = 0; i < 3; i++)
+                rowEdges[i] += triangle.b[i];
+        }
+    }
+
+    // the box's corners in clip space: hidden if all are in front of the near plane and every pixel under their
+    // screen bounds holds a nearer depth than the nearest corner
+    bool testCorners(const glm::vec4 corners[8]) {
+        stats_.tested++;
+        float minX = INFINITY, minY = INFINITY, maxX = -INFINITY, maxY = -INFINITY, nearest = INFINITY;
+        for (int i = 0; i < 8; i++) {
+            const glm::vec4& corner = corners[i];
+            if (corner.z < -corner.w || corner.w <= 0.0f)
+                return false;
+            float invW = 1.0f / corner.w;
+            float x = (corner.x * invW * 0.5f + 0.5f) * bufferWidth, y = (corner.y * invW * 0.5f + 0.5f) * bufferHeight;
+            minX = std::min(minX, x);
+            maxX = std::max(maxX, x);
+            minY = std::min(minY, y);
+            maxY = std::max(maxY, y);
+            nearest = std::min(nearest, corner.z * invW);
+        }
+
+        // every pixel the projection touches and the border around them; off screen is the frustum culling's business
+        int x0 = (int)std::max(std::floor(minX) - 1.0f, 0.0f), x1 = (int)std::min(std::ceil(maxX), bufferWidth - 1.0f);
+        int y0 = (int)std::max(std::floor(minY) - 1.0f, 0.0f), y1 = (int)std::min(std::ceil(maxY), bufferHeight - 1.0f);
+        if (x0 > x1 || y0 > y1)
+            return false;
+
+        for (int ty = y0 / TILE_HEIGHT; ty <= y1 / TILE_HEIGHT; ty++) {
+            for (int tx = x0 / TILE_WIDTH; tx <= x1 / TILE_WIDTH; tx++) {
+                int tile = ty * tilesX + tx;
+                if (tileMax[tile] < nearest)
+                    continue; // the whole tile is in front of the box
+                int tileX = tx * TILE_WIDTH, tileY = ty * TILE_HEIGHT;
+                int px0 = std::max(x0, tileX) - tileX, px1 = std::min(x1, tileX + TILE_WIDTH - 1) - tileX;
+                int py0 = std::max(y0, tileY) - tileY, py1 = std::min(y1, tileY + TILE_HEIGHT - 1) - tileY;
+                const float* pixels = &depth[tile * TILE_WIDTH * TILE_HEIGHT];
+                for (int y = py0; y <= py1; y++) {
+#ifdef OCCLUSION_CULLER_SIMD
+                    if (useSimd) {
+                        if (!rowHiddenSimd(pixels + y * TILE_WIDTH, px0, px1, nearest))
+                            return false;
+                        continue;
+                    }
+#endif
+                    for (int x = px0; x <= px1; x++)
+                        if (pixels[y * TILE_WIDTH + x] >= nearest)
+                            return false;
+                }
+            }
+        }
+        stats_.occluded++;
+        return true;
+    }
+
+#ifdef OCCLUSION_CULLER_SIMD
+    // the few operations the kernels need, eight or four lanes wide
+#ifdef OCCLUSION_CULLER_AVX2
+    typedef __m256 Lanes;
+    typedef __m256i IntLanes;
+    static const int LANES = 8;
+    static const int ALL_LANES = 0xFF;
+    static Lanes splat(float value) { return _mm256_set1_ps(value); }
+    static Lanes laneOffsets() { return _mm256_setr_ps(0.0f, 1.0f, 2.0f, 3.0f, 4.0f, 5.0f, 6.0f, 7.0f); }
+    static Lanes load(const float* p) { return _mm256_loadu_ps(p); }
+    static void store(float* p, Lanes v) { _mm256_storeu_ps(p, v); }
+    static Lanes add(Lanes a, Lanes b) { return _mm256_add_ps(a, b); }
+    static Lanes mul(Lanes a, Lanes b) { return _mm256_mul_ps(a, b); }
+    static Lanes min(Lanes a, Lanes b) { return _mm256_min_ps(a, b); }
+    static Lanes greaterEqual(Lanes a, Lanes b) { return _mm256_cmp_ps(a, b, _CMP_GE_OQ); }
+    static Lanes lessEqual(Lanes a, Lanes b) { return _mm256_cmp_ps(a, b, _CMP_LE_OQ); }
+    static Lanes both(Lanes a, Lanes b) { return _mm256_and_ps(a, b); }
+    static Lanes select(Lanes mask, Lanes a, Lanes b) { return _mm256_blendv_ps(b, a, mask); }
+    static int anyLane(Lanes mask) { return _mm256_movemask_ps(mask); }
+    static IntLanes splatInt(std::int32_t value) { return _mm256_set1_epi32(value); }
+    static IntLanes steps(std::int32_t step) {
+        return _mm256_setr_epi32(0, step, 2 * step, 3 * step, 4 * step, 5 * step, 6 * step, 7 * step);
+    }
+    static IntLanes addInt(IntLanes a, IntLanes b) { return _mm256_add_epi32(a, b); }
+    static IntLanes eitherInt(IntLanes a, IntLanes b) { return _mm256_or_si256(a, b); }
+    // all ones in the lanes that are >= 0
+    static Lanes nonNegative(IntLanes a) { return _mm256_castsi256_ps(_mm256_cmpgt_epi32(a, _mm256_set1_epi32(-1))); }
+    // one bit per lane, set where the sign is
+    static int signs(IntLanes a) { return _mm256_movemask_ps(_mm256_castsi256_ps(a)); }
+#else
+    typedef __m128 Lanes;
+    typedef __m128i IntLanes;
+    static const int LANES = 4;
+    static const int ALL_LANES = 0xF;
+    static Lanes splat(float value) { return _mm_set1_ps(value); }
+    static Lanes laneOffsets() { return _mm_setr_ps(0.0f, 1.0f, 2.0f, 3.0f); }
+    static Lanes load(const float* p) { return _mm_loadu_ps(p); }
+    static void store(float* p, Lanes v) { _mm_storeu_ps(p, v); }
+    static Lanes add(Lanes a, Lanes b) { return _mm_add_ps(a, b); }
+    static Lanes mul(Lanes a, Lanes b) { return _mm_mul_ps(a, b); }
+    static Lanes min(Lanes a, Lanes b) { return _mm_min_ps(a, b); }
+    static Lanes greaterEqual(Lanes a, Lanes b) { return _mm_cmpge_ps(a, b); }
+    static Lanes lessEqual(Lanes a, Lanes b) { return _mm_cmple_ps(a, b); }
+    static Lanes both(Lanes a, Lanes b) { return _mm_and_ps(a, b); }
+    static Lanes select(Lanes mask, Lanes a, Lanes b) { return _mm_or_ps(_mm_and_ps(mask, a), _mm_andnot_ps(mask, b)); }
+    static int anyLane(Lanes mask) { return _mm_movemask_ps(mask); }
+    static IntLanes splatInt(std::int32_t value) { return _mm_set1_epi32(value); }
+    static IntLanes steps(std::int32_t step) { return _mm_setr_epi32(0, step, 2 * step, 3 * step); }
+    static IntLanes addInt(IntLanes a, IntLanes b) { return _mm_add_epi32(a, b); }
+    static IntLanes eitherInt(IntLanes a, IntLanes b) { return _mm_or_si128(a, b); }
+    static Lanes nonNegative(IntLanes a) { return _mm_castsi128_ps(_mm_cmpgt_epi32(a, _mm_set1_epi32(-1))); }
+    static int signs(IntLanes a) { return _mm_movemask_ps(_mm_castsi128_ps(a)); }
+#endif
+
+    // same as rasterize(), LANES pixels at a time: edge values are set up once for the first group of the first
+    // row, then stepped by LANES pixels along a row and by one row down. a pixel is covered when none of its
+    // edge values is negative, i.e. when the sign of the three or'ed together is clear. lanes outside [x0, x1]
+    // are outside the triangle, whose bounds those are, or past the buffer's edge, which is outside them too;
+    // TILE_WIDTH is a multiple of LANES, so a group never leaves the row
+    void rasterizeSimd(const Triangle& triangle, float* pixels, int tileX, int tileY, int x0, int y0, int x1, int y1) const {
+        int first = x0 & ~(LANES - 1);
+        IntLanes rowEdges[3], groupStep[3], rowStep[3];
+        for (int i = 0; i < 3; i++) {
+            rowEdges[i] = addInt(splatInt(triangle.c[i] + triangle.a[i] * (tileX + first) + triangle.b[i] * (tileY + y0)), steps(triangle.a[i]));
+            groupStep[i] = splatInt(triangle.a[i] * LANES);
+            rowStep[i] = splatInt(triangle.b[i]);
+        }
+        const Lanes zx = splat(triangle.zx), offsets = laneOffsets();
+
+        for (int y = y0; y <= y1; y++) {
+            float* row = pixels + y * TILE_WIDTH;
+            const Lanes z = splat(triangle.zy * ((float)(tileY + y) + 0.5f) + triangle.z0);
+            IntLanes e0 = rowEdges[0], e1 = rowEdges[1], e2 = rowEdges[2];
+            for (int x = first; x <= x1; x += LANES) {
+                IntLanes edges = eitherInt(eitherInt(e0, e1), e2);
+                int covered = ~signs(edges) & ALL_LANES;
+                e0 = addInt(e0, groupStep[0]);
+                e1 = addInt(e1, groupStep[1]);
+                e2 = addInt(e2, groupStep[2]);
+                if (!covered)
+                    continue;
+
+                Lanes current = load(row + x);
+                Lanes nearest = min(current, add(mul(zx, add(splat((float)(tileX + x) + 0.5f), offsets)), z));
+                store(row + x, covered == ALL_LANES ? nearest : select(nonNegative(edges), nearest, current));
+            }
+            for (int i = 0; i < 3; i++)
+                rowEdges[i] = addInt(rowEdges[i], rowStep[i]);
+        }
+    }
+
+    // true if pixels x0..x1 of a tile row are all nearer than nearest
+    bool rowHiddenSimd(const float* row, int x0, int x1, float nearest) const {
+        const Lanes limit = splat(nearest), first = splat((float)x0), last = splat((float)x1);
+        const Lanes offsets = laneOffsets();
+        for (int x = x0 & ~(LANES - 1); x <= x1; x += LANES) {
+            Lanes xs = add(splat((float)x), offsets);
+            Lanes inRange = both(greaterEqual(xs, first), lessEqual(xs, last));
+            if (anyLane(both(inRange, greaterEqual(load(row + x), limit))))
+                return false;
+        }
+        return true;
+    }
+#endif
+};
+
+#endif
@@ -0,0 +1,85 @@
+#ifndef RADIX_SORT_H
+#define RADIX_SORT_H
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <utility>
+#include <vector>
+
+// a sort key and what it belongs to (an index into the caller's items)
+struct SortPair {
+    std::uint64_t key;
+    std::uint32_t value;
+};
+
+// LSD radix sort of pairs by key, ascending. It is stable, so pairs with equal keys keep the order they were
+// added in. Only the key bits that differ between pairs are sorted on: one pass over the keys finds them, and the
+// digits (up to RADIX_BITS wide) are laid over those bits, skipping the runs that are the same for every key. A
+// layer, a translucency bit or id fields with fewer distinct values than their width allows then cost no passes;
+// fully random 64-bit keys take six. One more pass over the keys builds every digit's histogram.
+//
+// The result ends up in pairs. scratch only has to outlive the call, but keeping both vectors around across
+// frames makes the sort allocation-free once they have grown to the largest size seen.
+const int RADIX_BITS = 11;
+
+inline void radixSort(std::vector<SortPair>& pairs, std::vector<SortPair>& scratch) {
+    const std::size_t count = pairs.size();
+    if (count < 2)
+        return;
+
+    // bits that differ from the first key somewhere
+    const std::uint64_t first = pairs[0].key;
+    std::uint64_t varying = 0;
+    for (const SortPair& pair : pairs)
+        varying |= pair.key ^ first;
+    if (varying == 0)
+        return;
+
+    // digits: each starts at the lowest varying bit the previous ones didn't cover
+    const int MAX_DIGITS = (64 + RADIX_BITS - 1) / RADIX_BITS;
+    int shifts[MAX_DIGITS], widths[MAX_DIGITS], nrDigits = 0;
+    int highest = 63;
+    while (!(varying >> highest & 1))
+        highest--;
+    for (int bit = 0; bit <= highest; ) {
+        while (!(varying >> bit & 1))
+            bit++;
+        shifts[nrDigits] = bit;
+        widths[nrDigits] = std::min(RADIX_BITS, highest - bit + 1);
+        bit += widths[nrDigits++];
+    }
+
+    std::uint32_t histograms[MAX_DIGITS][1 << RADIX_BITS];
+    for (int digit = 0; digit < nrDigits; digit++)
+        std::memset(histograms[digit], 0, sizeof(std::uint32_t) << widths[digit]);
+    for (const SortPair& pair : pairs)
+        for (int digit = 0; digit < nrDigits; digit++)
+            histograms[digit][(pair.key >> shifts[digit]) & ((1u << widths[digit]) - 1)]++;
+
+    scratch.resize(count);
+    SortPair* src = pairs.data();
+    SortPair* dst = scratch.data();
+    for (int digit = 0; digit < nrDigits; digit++) {
+        std::uint32_t* histogram = histograms[digit];
+        const int shift = shifts[digit];
+        const std::uint64_t mask = (1u << widths[digit]) - 1;
+
+        // bucket offsets
+        std::uint32_t offset = 0;
+        for (std::uint32_t bucket = 0; bucket <= mask; bucket++) {
+            std::uint32_t bucketCount = histogram[bucket];
+            histogram[bucket] = offset;
+            offset += bucketCount;
+        }
+        for (std::size_t i = 0; i < count; i++)
+            dst[histogram[(src[i].key >> shift) & mask]++] = src[i];
+        std::swap(src, dst);
+    }
+
+    // an odd number of passes left the result in scratch
+    if (src != pairs.data())
+        pairs.swap(scratch);
+}
+
+#endif
@@ -0,0 +1,193 @@
+#ifndef RENDER_QUEUE_H
+#define RENDER_QUEUE_H
+
+#include <glad/glad.h>
+
+#include <glm/glm.hpp>
+
+#include "learnopengl/gl_state.h"
+#include "learnopengl/radix_sort.h"
+#include "learnopengl/shader.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <functional>
+#include <vector>
+
+// 64-bit draw sort keys. Sorting by them groups draws by layer first, opaque before translucent, then:
+//
+//     opaque:       program | material | vertex array | depth, near to far (early-Z rejects what's hidden)
+//     translucent:  depth, far to near (correct blending) | program | material | vertex array
+//
+//     bits   63-61  60           59-0
+//            layer  translucent  the fields above: program 10, material 14, vertex array 12, depth 24
+//
+// Program, material and vertex array ids are truncated to their widths; that only costs grouping, since the
+// queue binds what the item says, not what the key says.
+namespace RenderKey {
+    const int LAYER_BITS = 3;
+    const int PROGRAM_BITS = 10;
+    const int MATERIAL_BITS = 14;
+    const int VERTEX_ARRAY_BITS = 12;
+    const int DEPTH_BITS = 24;
+    const std::uint64_t TRANSLUCENT_BIT = 1ull << 60;
+
+    inline std::uint64_t field(std::uint64_t value, int bits, int shift) {
+        return (value & ((1ull << bits) - 1)) << shift;
+    }
+
+    // depth: 0 (near) to 1 (far), see RenderQueue::setDepthRange()
+    inline std::uint64_t opaque(unsigned int layer, unsigned int program, unsigned int material, unsigned int vertexArray, float depth) {
+        std::uint64_t quantized = (std::uint64_t)(std::min(std::max(depth, 0.0f), 1.0f) * ((1u << DEPTH_BITS) - 1));
+        return field(layer, LAYER_BITS, 61) | field(program, PROGRAM_BITS, 50) | field(material, MATERIAL_BITS, 36)
+            | field(vertexArray, VERTEX_ARRAY_BITS, 24) | quantized;
+    }
+
+    inline std::uint64_t translucent(unsigned int layer, unsigned int program, unsigned int material, unsigned int vertexArray, float depth) {
+        std::uint64_t quantized = (std::uint64_t)(std::min(std::max(depth, 0.0f), 1.0f) * ((1u << DEPTH_BITS) - 1));
+        return field(layer, LAYER_BITS, 61) | TRANSLUCENT_BIT | field(((1u << DEPTH_BITS) - 1) - quantized, DEPTH_BITS, 36)
+            | field(program, PROGRAM_BITS, 26) | field(material, MATERIAL_BITS, 12) | field(vertexArray, VERTEX_ARRAY_BITS, 0);
+    }
+}
+
+// Collects a frame's draws, sorts them by RenderKey and replays them through GLState, so program, vertex array
+// and texture switches happen once per group instead of in whatever order the code submitted them.
+//
+//     queue.setDepthRange(near, far);
+//     queue.clear();
+//     queue.submit(item, model, layer, translucent, viewDepth); // any order
+//     queue.sort();                                             // or skip it to replay in submission order
+//     queue.execute([&](Shader& shader, const RenderQueue::Item& item) { ... per-draw uniforms ... });
+//
+// Items are plain data with no GL calls until execute(), so building and sorting a queue needs no context. Only
+// 16-byte (key, index) pairs are sorted; items and their model matrices stay where they were submitted, in two
+// arrays indexed by the pair's value, and are only read again by execute().
+class RenderQueue {
+public:
+    static const int MAX_TEXTURES = 4;
+
+    struct Item {
+        Shader* shader = nullptr;
+        unsigned int vertexArray = 0;
+        unsigned int textures[MAX_TEXTURES] = {}; // GL_TEXTURE_2D on units 0, 1, ...; 0 leaves the unit alone
+        unsigned int material = 0;                // the caller's id for textures + per-draw uniforms
+        bool cullFace = true;
+        GLenum mode = GL_TRIANGLES;
+        GLint first = 0;                          // first vertex, or first index with an indexType
+        GLsizei count = 0;
+        GLenum indexType = 0;                     // 0: glDrawArrays, else glDrawElements from the bound element buffer
+    };
+
+    // what the last execute() switched; translucent items also turn blending on, opaque ones off
+    struct Stats {
+        int items = 0;
+        int programChanges = 0;
+        int vertexArrayChanges = 0;
+        int textureChanges = 0;
+    };
+
+    // view-space depths mapped to the key's depth bits
+    void setDepthRange(float nearDepth, float farDepth) {
+        this->nearDepth = nearDepth;
+        this->depthScale = 1.0f / std::max(farDepth - nearDepth, 1e-6f);
+    }
+
+    void clear() {
+        items.clear();
+        transforms.clear();
+        pairs.clear();
+    }
+
+    // model is set as "model"
+    void submit(const Item& item, const glm::mat4& model, unsigned int layer, bool translucent, float viewDepth) {
+        float depth = (viewDepth - nearDepth) * depthScale;
+        unsigned int program = item.shader ? item.shader->ID : 0;
+        submit(item, model, translucent ? RenderKey::translucent(layer, program, item.material, item.vertexArray, depth)
+                                        : RenderKey::opaque(layer, program, item.material, item.vertexArray, depth));
+    }
+
+    // with a key built by hand (RenderKey::opaque / translucent)
+    void submit(const Item& item, const glm::mat4& model, std::uint64_t key) {
+        pairs.push_back({ key, (std::uint32_t)items.size() });
+        items.push_back(item);
+        transforms.push_back(model);
+    }
+
+    void sort() {
+        radixSort(pairs, scratch);
+    }
+
+    // draws every item in the current order; perDraw, if given, runs after the item's state is bound and
+    // before "model" is committed, for uniforms of the caller's own (e.g. from a material table)
+    void execute(const std::function<void(Shader&, const Item&)>& perDraw = nullptr) {
+        frameStats = Stats();
+        frameStats.items = (int)pairs.size();
+        const Item* previous = nullptr;
+
+        for (const SortPair& pair : pairs) {
+            const Item& item = items[pair.value];
+            Shader& shader = *item.shader;
+            if (!previous || previous->shader != item.shader) {
+                shader.use();
+                frameStats.programChanges++;
+            }
+            if (!previous || previous->vertexArray != item.vertexArray)
+                frameStats.vertexArrayChanges++;
+            for (int unit = 0; unit < MAX_TEXTURES; unit++)
+                if (item.textures[unit] && (!previous || previous->textures[unit] != item.textures[unit]))
+                    frameStats.textureChanges++;
+            previous = &item;
+
+            GLState::bindVertexArray(item.vertexArray);
+            for (int unit = 0; unit < MAX_TEXTURES; unit++)
+                if (item.textures[unit])
+                    GLState::bindTexture(unit, GL_TEXTURE_2D, item.textures[unit]);
+            GLState::setEnabled(GL_CULL_FACE, item.cullFace);
+            GLState::setEnabled(GL_BLEND, (pair.key & RenderKey::TRANSLUCENT_BIT) != 0);
+
+            if (perDraw)
+                perDraw(shader, item);
+            shader.setMat4("model", transforms[pair.value]);
+            shader.commit();
+
+            if (item.indexType == 0)
+                glDrawArrays(item.mode, item.first, item.count);
+            else
+                glDrawElements(item.mode, item.count, item.indexType, (void*)(std::uintptr_t)(item.first * indexSize(item.indexType)));
+        }
+    }
+
+    // items in execution order, with their keys
+    const std::vector<SortPair>& order() const {
+        return pairs;
+    }
+
+    const Item& item(std::uint32_t index) const {
+        return items[index];
+    }
+
+    const glm::mat4& transform(std::uint32_t index) const {
+        return transforms[index];
+    }
+
+    std::size_t size() const {
+        return items.size();
+    }
+
+    const Stats& stats() const {
+        return frameStats;
+    }
+
+private:
+    std::vector<Item> items;
+    std::vector<glm::mat4> transforms;
+    std::vector<SortPair> pairs, scratch;
+    float nearDepth = 0.0f, depthScale = 1.0f;
+    Stats frameStats;
+
+    static std::size_t indexSize(GLenum indexType) {
+        return indexType == GL_UNSIGNED_BYTE ? 1 : indexType == GL_UNSIGNED_SHORT ? 2 : 4;
+    }
+};
+
+#endif
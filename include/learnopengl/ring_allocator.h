@@ -0,0 +1,142 @@
+#ifndef RING_ALLOCATOR_H
+#define RING_ALLOCATOR_H
+
+#include <cstddef>
+#include <vector>
+
+// The bookkeeping of a buffer the CPU writes while the GPU is still reading earlier frames out of it: the buffer
+// is split into nrRegions regions, one per frame in flight, handed out in turn. Each frame sub-allocates linearly
+// from its region; at its end a fence goes in behind the frame's commands, and a region is only reused once its
+// fence has signalled, waiting for it if the GPU is that far behind.
+//
+//     allocator.beginFrame();                                    // may wait for the frame nrRegions ago
+//     std::size_t offset = allocator.allocate(size, alignment);  // NO_SPACE when the region is full
+//     ... write at offset, draw from it ...
+//     allocator.endFrame();                                      // after the frame's last draw reading the region
+//
+// No GL calls are made here: fences come from a Fences object with
+//
+//     typedef ... Fence;
+//     Fence insert();            // behind every command issued so far
+//     bool signaled(Fence);      // without blocking
+//     void wait(Fence);          // blocks until signaled
+//     void remove(Fence);
+//
+// GLFences (stream_buffer.h) implements it with sync objects; mocks that signal on their own schedule exercise
+// the reclamation without a context (see src/tests/ring_allocator_test.cpp and
+// src/benchmarks/ring_allocator_bench.cpp).
+template <typename Fences>
+class RingAllocator {
+public:
+    typedef typename Fences::Fence Fence;
+
+    static const std::size_t NO_SPACE = (std::size_t)-1;
+
+    // what the current frame (or the last one, after endFrame()) did
+    struct Stats {
+        std::size_t allocations = 0;
+        std::size_t bytes = 0;  // of the region in use, alignment padding included
+        std::size_t failed = 0; // allocations that didn't fit
+        bool waited = false;    // beginFrame() blocked on the region's fence
+    };
+
+    // regions are rounded up to MAX_ALIGNMENT, so every region starts aligned for any allocation
+    RingAllocator(Fences& fences, std::size_t regionSize, int nrRegions = 3)
+        : fences(fences), size((regionSize + MAX_ALIGNMENT - 1) / MAX_ALIGNMENT * MAX_ALIGNMENT),
+          regions(nrRegions), current(nrRegions - 1) {}
+
+    RingAllocator(const RingAllocator&) = delete;
+    RingAllocator& operator=(const RingAllocator&) = delete;
+
+    // moves to the next region, making sure the GPU is done with what was last written there
+    void beginFrame() {
+        current = (current + 1) % (int)regions.size();
+        Region& region = regions[current];
+        stats_ = Stats();
+        if (region.fenced) {
+            if (!fences.signaled(region.fence)) {
+                fences.wait(region.fence);
+                stats_.waited = true;
+                nrWaits++;
+            }
+            fences.remove(region.fence);
+            region.fenced = false;
+        }
+        head = regionOffset(current);
+    }
+
+    // offset (from the start of the whole buffer) of size free bytes aligned to alignment, a power of two no
+    // larger than MAX_ALIGNMENT
+    std::size_t allocate(std::size_t size, std::size_t alignment) {
+        std::size_t offset = (head + alignment - 1) & ~(alignment - 1);
+        if (offset + size > regionOffset(current) + this->size) {
+            stats_.failed++;
+            return NO_SPACE;
+        }
+        head = offset + size;
+        stats_.allocations++;
+        stats_.bytes = head - regionOffset(current);
+        return offset;
+    }
+
+    // the region stays reserved until the GPU has executed everything issued before this call
+    void endFrame() {
+        Region& region = regions[current];
+        region.fence = fences.insert();
+        region.fenced = true;
+    }
+
+    // drops the outstanding fences; like the GL wrappers it doesn't do this on destruction, so call it before the
+    // buffer (and the context) go away
+    void release() {
+        for (Region& region : regions) {
+            if (region.fenced)
+                fences.remove(region.fence);
+            region.fenced = false;
+        }
+    }
+
+    std::size_t regionSize() const {
+        return size;
+    }
+
+    int nrRegions() const {
+        return (int)regions.size();
+    }
+
+    // the region the current frame allocates from
+    int currentRegion() const {
+        return current;
+    }
+
+    std::size_t regionOffset(int region) const {
+        return (std::size_t)region * size;
+    }
+
+    const Stats& stats() const {
+        return stats_;
+    }
+
+    // beginFrame() calls that had to wait, since construction
+    std::size_t totalWaits() const {
+        return nrWaits;
+    }
+
+    static const std::size_t MAX_ALIGNMENT = 256;
+
+private:
+    struct Region {
+        Fence fence{};
+        bool fenced = false;
+    };
+
+    Fences& fences;
+    std::size_t size;
+    std::vector<Region> regions;
+    int current;
+    std::size_t head = 0;
+    Stats stats_;
+    std::size_t nrWaits = 0;
+};
+
+#endif
@@ -3,139 +3,635 @@
 
 #include <glad/glad.h>
 #include <glm/gtc/type_ptr.hpp>
+#include "learnopengl/file_watcher.h"
+#include "learnopengl/gl_extensions.h"
+#include "learnopengl/gl_state.h"
+#include "learnopengl/shader_cache.h"
+#include "learnopengl/shader_preprocessor.h"
+#include "learnopengl/uniform_blocks.h"
 #include <fstream>
 #include <sstream>
 #include <iostream>
+#include <algorithm>
 #include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
 
 const std::string RED = "\033[1;31m";
 const std::string WHITE = "\033[0m";
 
+// FNV-1a hash of a uniform name. constexpr so names can be hashed once at compile time.
+constexpr std::uint32_t hashUniformName(const char* name, std::size_t length) {
+	std::uint32_t hash = 2166136261u;
+	for (std::size_t i = 0; i < length; i++) {
+		hash ^= static_cast<unsigned char>(name[i]);
+		hash *= 16777619u;
+	}
+	return hash;
+}
+
+// a second, unrelated hash of the name (multiply-xorshift), checked alongside the first so that two names
+// only alias when both collide
+constexpr std::uint32_t checkUniformName(const char* name, std::size_t length) {
+	std::uint32_t hash = 0x9747b28cu ^ static_cast<std::uint32_t>(length);
+	for (std::size_t i = 0; i < length; i++) {
+		hash = (hash ^ static_cast<unsigned char>(name[i])) * 0x5bd1e995u;
+		hash ^= hash >> 15;
+	}
+	return hash;
+}
+
+constexpr std::size_t uniformNameLength(const char* name) {
+	std::size_t length = 0;
+	while (name[length] != '\0')
+		length++;
+	return length;
+}
+
+// key into a shader's uniform table. string literals are always hashed at compile time (consteval, so even
+// unoptimized builds never hash "model" per call); names built at runtime go through std::string.
+struct UniformName {
+	std::uint32_t hash;
+	std::uint32_t check;
+
+	template <std::size_t N>
+	consteval UniformName(const char (&name)[N])
+		: hash(hashUniformName(name, uniformNameLength(name))), check(checkUniformName(name, uniformNameLength(name))) {}
+	UniformName(const std::string& name)
+		: hash(hashUniformName(name.data(), name.size())), check(checkUniformName(name.data(), name.size())) {}
+	constexpr UniformName(std::uint32_t precomputedHash, std::uint32_t precomputedCheck)
+		: hash(precomputedHash), check(precomputedCheck) {}
+};
+
+constexpr UniformName operator""_u(const char* name, std::size_t length) {
+	return UniformName(hashUniformName(name, length), checkUniformName(name, length));
+}
+
 class Shader {
 public:
 	unsigned int ID;
 
-	Shader(const char* vertexPath, const char* fragmentPath) {
-		// 1. retrieve source code from file paths
+	// what the constructor does on a binary cache miss. COMPILE_BLOCKING compiles, links and checks the result
+	// before returning. COMPILE_ASYNC only hands the work to the driver, so many programs can compile at once
+	// (truly in parallel with KHR_parallel_shader_compile); poll ready() and call finish(), or let use() finish it.
+	enum CompileMode {
+		COMPILE_BLOCKING,
+		COMPILE_ASYNC
+	};
+
+	// defines are injected after #version in both stages (see ShaderVariants for a cache of permutations)
+	Shader(const char* vertexPath, const char* fragmentPath, const ShaderDefines& defines = ShaderDefines(),
+			CompileMode mode = COMPILE_BLOCKING)
+		: vertexPath(vertexPath), fragmentPath(fragmentPath), defines(defines) {
+		// 1. retrieve source code from file paths, with #includes expanded
 		std::string vertexCodeStr, fragmentCodeStr;
-                std::string vertexFileName, fragmentFileName;
-		std::ifstream vertexFile, fragmentFile;
-		vertexFile.exceptions	(std::ifstream::failbit | std::ifstream::badbit);
-                fragmentFile.exceptions (std::ifstream::failbit | std::ifstream::badbit);
-
-		try {
-			// open files
-			vertexFile.open(vertexPath);
-			fragmentFile.open(fragmentPath);
-			std::stringstream vertexStream, fragmentStream;
-
-			// read file's buffer content into streams
-			vertexStream << vertexFile.rdbuf();
-			fragmentStream << fragmentFile.rdbuf();
-
-			// close file handlers
-			vertexFile.close();
-			fragmentFile.close();
-
-			// convert stream into string
-			vertexCodeStr = vertexStream.str();
-			fragmentCodeStr = fragmentStream.str();
-
-                        // store the filenames
-                        std::string vertexPathStr(vertexPath);
-                        std::string fragmentPathStr(fragmentPath);
-                        std::size_t vertexFound = vertexPathStr.find_last_of("/\\");
-                        std::size_t fragmentFound = fragmentPathStr.find_last_of("/\\");
-                        vertexFileName = vertexPathStr.substr(vertexFound+1);
-                        fragmentFileName = fragmentPathStr.substr(fragmentFound+1);
-		} 
-		catch (std::ifstream::failure e) {
-			std::cout << RED << "ERROR::SHADER::FILE_NOT_SUCCESSFULLY_READ" << WHITE << std::endl;
-		}
-
-		const char* vertexShaderSource = vertexCodeStr.c_str();
-		const char* fragmentShaderSource = fragmentCodeStr.c_str();
-
-		// 2. compile and link shaders
-		unsigned int vertex, fragment;
+		readSources(vertexCodeStr, fragmentCodeStr, vertexFiles, fragmentFiles);
+
+		// 2. reuse the linked program from a previous run when the driver still accepts it
+		std::uint64_t cacheKey = 0;
+		ID = 0;
+		if (ShaderCache::available()) {
+			cacheKey = ShaderCache::makeKey({ vertexCodeStr, fragmentCodeStr });
+			ID = ShaderCache::load(cacheKey);
+		}
+		if (ID) {
+			setupProgram();
+			return;
+		}
+
+		// 3. otherwise compile and link; nothing is checked until finish()
+		link.reset(new PendingLink(submitLink(vertexCodeStr, fragmentCodeStr, describeSources(vertexFiles), describeSources(fragmentFiles), cacheKey)));
+		ID = link->program;
+		if (mode == COMPILE_BLOCKING)
+			finish();
+	}
+
+	// true once an async compile/link can be finished without stalling. without parallel shader compile support
+	// there's no way to ask, so this is always true and finish() waits for the driver.
+	bool ready() const {
+		return !link || completed(*link);
+	}
+
+	// checks the result of an async compile/link (waiting for it if needed) and reflects the program
+	void finish() {
+		if (!link)
+			return;
+		finishLink(*link);
+		link.reset();
+		setupProgram();
+	}
+
+	// activates shader program (skipped if it's already current, see GLState)
+	void use() {
+		finish();
+		GLState::useProgram(ID);
+	}
+
+	// starts watching the source files (and everything they include) on a background thread; edits are picked
+	// up by reloadIfChanged()
+	void enableHotReload() {
+		watcher.reset(new FileWatcher(watchedFiles(), [this]() {
+			// runs on the watcher thread: do the file I/O here so the render thread only compiles
+			PendingSources sources;
+			sources.ok = readSources(sources.vertexCode, sources.fragmentCode, sources.vertexFiles, sources.fragmentFiles);
+			std::lock_guard<std::mutex> lock(pendingMutex);
+			pending.reset(new PendingSources(std::move(sources)));
+		}));
+	}
+
+	// queues sources read elsewhere, includes expanded but this shader's defines not injected yet (ShaderVariants
+	// reads its files once for every permutation); picked up by the next reloadIfChanged()
+	void reloadFrom(const std::string& vertexSource, const std::string& fragmentSource,
+			const std::vector<std::string>& vertexStageFiles, const std::vector<std::string>& fragmentStageFiles) {
+		PendingSources sources;
+		sources.ok = true;
+		sources.vertexCode = ShaderPreprocessor::injectDefines(vertexSource, defines);
+		sources.fragmentCode = ShaderPreprocessor::injectDefines(fragmentSource, defines);
+		sources.vertexFiles = vertexStageFiles;
+		sources.fragmentFiles = fragmentStageFiles;
+		std::lock_guard<std::mutex> lock(pendingMutex);
+		pending.reset(new PendingSources(std::move(sources)));
+	}
+
+	// call from the render thread, before use(), every frame. new sources from the watcher are handed to the
+	// driver as a separate program and polled on later frames; the program ID is swapped only once that one has
+	// linked, so an edit never stalls a frame (except without parallel shader compile support, where there's no
+	// way to ask and the first poll waits). on failure the previous program stays active. sources that arrive
+	// while a reload is still compiling replace it. returns true on a swap.
+	bool reloadIfChanged() {
+		finish();
+		std::unique_ptr<PendingSources> sources;
+		{
+			// never wait on the watcher; it'll still be there next frame
+			std::unique_lock<std::mutex> lock(pendingMutex, std::try_to_lock);
+			if (lock.owns_lock())
+				sources = std::move(pending);
+		}
+		if (sources && sources->ok) {
+			if (reload)
+				discardLink(reload->link);
+			std::uint64_t cacheKey = ShaderCache::available() ? ShaderCache::makeKey({ sources->vertexCode, sources->fragmentCode }) : 0;
+			reload.reset(new PendingReload());
+			reload->link = submitLink(sources->vertexCode, sources->fragmentCode, describeSources(sources->vertexFiles), describeSources(sources->fragmentFiles), cacheKey);
+			reload->vertexFiles = std::move(sources->vertexFiles);
+			reload->fragmentFiles = std::move(sources->fragmentFiles);
+		}
+		if (!reload || !completed(reload->link))
+			return false;
+
+		std::unique_ptr<PendingReload> linked = std::move(reload);
+		unsigned int program = linked->link.program;
+		if (!finishLink(linked->link)) {
+			glDeleteProgram(program);
+			std::cout << RED << "ERROR::SHADER::RELOAD_FAILED: keeping the previous program for "
+				<< fileName(vertexPath) << " + " << fileName(fragmentPath) << WHITE << std::endl;
+			return false;
+		}
+
+		glDeleteProgram(ID);
+		GLState::forgetProgram(ID);
+		ID = program;
+		// block bindings and locations belong to the old program
+		setupProgram();
+		// the edit may have added or dropped an #include (the watcher is only ours to update if we have one)
+		if (linked->vertexFiles != vertexFiles || linked->fragmentFiles != fragmentFiles) {
+			vertexFiles = linked->vertexFiles;
+			fragmentFiles = linked->fragmentFiles;
+			if (watcher)
+				enableHotReload();
+		}
+		std::cout << "SHADER::RELOADED: " << fileName(vertexPath) << " + " << fileName(fragmentPath) << std::endl;
+		return true;
+	}
+
+	// looks up a uniform location in the reflected table; -1 (ignored by glUniform*) if it isn't active
+	int getLocation(UniformName name) const {
+		const UniformSlot* slot = findSlot(name);
+		return slot ? slot->location : -1;
+	}
+
+	// Every active uniform has a shadow copy of the last value set through the setters below; setting the same
+	// value again is a memcmp and no GL call (counted in GLState's per-frame stats). With batching on, setters
+	// only update the shadow and commit() uploads whatever changed, once, right before the draw. The program must
+	// be current (use()) when a value is uploaded, i.e. at the setter call or at commit().
+	void setBatched(bool batched) {
+		batchUploads = batched;
+	}
+
+	void commit() {
+		for (std::uint32_t index : dirtyValues) {
+			UniformValue& value = uniformValues[index];
+			value.dirty = false;
+			uploadValue(value);
+		}
+		dirtyValues.clear();
+	}
+
+	// sets uniform values by table lookup
+	void setBool(UniformName name, bool value) {
+		int intValue = (int)value, location;
+		if (stage(name, &intValue, sizeof(intValue), location))
+			glUniform1i(location, intValue);
+	}
+
+	void setInt(UniformName name, int value) {
+		int location;
+		if (stage(name, &value, sizeof(value), location))
+			glUniform1i(location, value);
+	}
+
+	void setFloat(UniformName name, float value) {
+		int location;
+		if (stage(name, &value, sizeof(value), location))
+			glUniform1f(location, value);
+	}
+
+	void setMat4(UniformName name, const glm::mat4 &mat) {
+		int location;
+		if (stage(name, glm::value_ptr(mat), sizeof(glm::mat4), location))
+			glUniformMatrix4fv(location, 1, GL_FALSE, glm::value_ptr(mat));
+	}
+
+	void setVec2(UniformName name, float x, float y) {
+		const float values[2] = { x, y };
+		int location;
+		if (stage(name, values, sizeof(values), location))
+			glUniform2f(location, x, y);
+	}
+
+	void setVec3(UniformName name, float x, float y, float z) {
+		const float values[3] = { x, y, z };
+		int location;
+		if (stage(name, values, sizeof(values), location))
+			glUniform3f(location, x, y, z);
+	}
+
+	void setVec3(UniformName name, const glm::vec3 &vec) {
+		setVec3(name, vec.x, vec.y, vec.z);
+	}
+
+	void setVec4(UniformName name, float s, float t, float u, float v) {
+		const float values[4] = { s, t, u, v };
+		int location;
+		if (stage(name, values, sizeof(values), location))
+			glUniform4f(location, s, t, u, v);
+	}
+
+private:
+	std::string vertexPath, fragmentPath;
+	ShaderDefines defines;
+	// each stage's file followed by everything it includes (index = #line source string number)
+	std::vector<std::string> vertexFiles, fragmentFiles;
+
+	// sources read by the watcher thread, waiting for the render thread to compile them
+	struct PendingSources {
+		bool ok = false;
+		std::string vertexCode, fragmentCode;
+		std::vector<std::string> vertexFiles, fragmentFiles;
+	};
+	std::mutex pendingMutex;
+	std::unique_ptr<PendingSources> pending;
+	// declared after what its callback touches, so it's destroyed (and joined) first
+	std::unique_ptr<FileWatcher> watcher;
+
+	static std::string fileName(const std::string& path) {
+		return path.substr(path.find_last_of("/\\") + 1);
+	}
+
+	// the #line source numbers in a stage index into its file list: "object.frag (1: lights.glsl, ...)"
+	static std::string describeSources(const std::vector<std::string>& files) {
+		if (files.empty())
+			return "";
+		std::string description = fileName(files[0]);
+		if (files.size() < 2)
+			return description;
+		description += " (";
+		for (std::size_t i = 1; i < files.size(); i++)
+			description += (i > 1 ? ", " : "") + std::to_string(i) + ": " + fileName(files[i]);
+		return description + ")";
+	}
+
+	std::vector<std::string> watchedFiles() const {
+		std::vector<std::string> files = vertexFiles;
+		for (const std::string& file : fragmentFiles)
+			if (std::find(files.begin(), files.end(), file) == files.end())
+				files.push_back(file);
+		// keep watching the top-level files even if they couldn't be read this time
+		for (const std::string& path : { vertexPath, fragmentPath })
+			if (std::find(files.begin(), files.end(), path) == files.end())
+				files.push_back(path);
+		return files;
+	}
+
+	// reads both stages with includes expanded and the defines injected
+	bool readSources(std::string& vertexCodeStr, std::string& fragmentCodeStr,
+			std::vector<std::string>& vertexStageFiles, std::vector<std::string>& fragmentStageFiles) const {
+		return ShaderPreprocessor::load(vertexPath, defines, vertexCodeStr, vertexStageFiles) &&
+			ShaderPreprocessor::load(fragmentPath, defines, fragmentCodeStr, fragmentStageFiles);
+	}
+
+	// compile/link work handed to the driver but not checked yet
+	struct PendingLink {
+		unsigned int vertex = 0, fragment = 0, program = 0;
+		std::uint64_t cacheKey = 0;
+		std::string vertexDescription, fragmentDescription;
+	};
+	std::unique_ptr<PendingLink> link;
+
+	// a hot reload's program, compiling while the current one stays in use
+	struct PendingReload {
+		PendingLink link;
+		std::vector<std::string> vertexFiles, fragmentFiles;
+	};
+	std::unique_ptr<PendingReload> reload;
+
+	// true once finishLink() won't stall; always true without parallel shader compile support (no way to ask)
+	static bool completed(const PendingLink& link) {
+		if (!GLExtensions::support().parallelShaderCompile)
+			return true;
+		int status = 0;
+		glGetProgramiv(link.program, GL_COMPLETION_STATUS_KHR, &status);
+		return status != 0;
+	}
+
+	// drops work that's been superseded without waiting for (or reporting on) it
+	static void discardLink(PendingLink& link) {
+		glDeleteShader(link.vertex);
+		glDeleteShader(link.fragment);
+		glDeleteProgram(link.program);
+	}
+
+	// submits both compiles and the link without querying any status, so the driver is free to overlap them
+	static PendingLink submitLink(const std::string& vertexCode, const std::string& fragmentCode,
+			const std::string& vertexDescription, const std::string& fragmentDescription, std::uint64_t cacheKey) {
+		const char* vertexShaderSource = vertexCode.c_str();
+		const char* fragmentShaderSource = fragmentCode.c_str();
+
+		PendingLink link;
+		link.cacheKey = cacheKey;
+		link.vertexDescription = vertexDescription;
+		link.fragmentDescription = fragmentDescription;
+
+		// vertex shader
+		link.vertex = glCreateShader(GL_VERTEX_SHADER);
+		glShaderSource(link.vertex, 1, &vertexShaderSource, NULL);
+		glCompileShader(link.vertex);
+
+		// fragment shader
+		link.fragment = glCreateShader(GL_FRAGMENT_SHADER);
+		glShaderSource(link.fragment, 1, &fragmentShaderSource, NULL);
+		glCompileShader(link.fragment);
+
+		// shader program
+		link.program = glCreateProgram();
+		glAttachShader(link.program, link.vertex);
+		glAttachShader(link.program, link.fragment);
+		ShaderCache::prepare(link.program);
+		glLinkProgram(link.program);
+		return link;
+	}
+
+	// reports compile/link errors, stores the program in the binary cache if it linked and frees the shader
+	// objects. the first status query waits for the driver if the work hasn't completed yet.
+	static bool finishLink(PendingLink& link) {
 		int success;
 		char log[512];
 
-		// vertex shader
-		vertex = glCreateShader(GL_VERTEX_SHADER);
-		glShaderSource(vertex, 1, &vertexShaderSource, NULL);
-		glCompileShader(vertex);
-		glGetShaderiv(vertex, GL_COMPILE_STATUS, &success);
+		glGetShaderiv(link.vertex, GL_COMPILE_STATUS, &success);
 		if (!success) {
-			glGetShaderInfoLog(vertex, 512, NULL, log);
+			glGetShaderInfoLog(link.vertex, 512, NULL, log);
 			std::cout << RED << "ERROR::VERTEX::SHADER::COMPILATION_FAILED: "
-				<< log  << " in file " << vertexFileName << WHITE << std::endl;
+				<< log  << " in file " << link.vertexDescription << WHITE << std::endl;
 		}
 
-		// fragment shader
-		fragment = glCreateShader(GL_FRAGMENT_SHADER);
-		glShaderSource(fragment, 1, &fragmentShaderSource, NULL);
-		glCompileShader(fragment);
-		glGetShaderiv(fragment, GL_COMPILE_STATUS, &success);
+		glGetShaderiv(link.fragment, GL_COMPILE_STATUS, &success);
 		if (!success) {
-			glGetShaderInfoLog(fragment, 512, NULL, log);
+			glGetShaderInfoLog(link.fragment, 512, NULL, log);
 			std::cout << RED << "ERROR::FRAGMENT::SHADER::COMPILATION_FAILED: "
-				<< log << " in file " << fragmentFileName << WHITE << std::endl;
+				<< log << " in file " << link.fragmentDescription << WHITE << std::endl;
 		}
 
-		// 3. shader program
-		ID = glCreateProgram();
-		glAttachShader(ID, vertex);
-		glAttachShader(ID, fragment);
-		glLinkProgram(ID);
-		glGetProgramiv(ID, GL_COMPILE_STATUS, &success);
+		glGetProgramiv(link.program, GL_LINK_STATUS, &success);
 		if (!success) {
-			glGetProgramInfoLog(ID, 512, NULL, log);
+			glGetProgramInfoLog(link.program, 512, NULL, log);
 			std::cout << RED << "ERROR::SHADER::PROGRAM::LINKING_FAILED: "
 				<< log << WHITE << std::endl;
+		} else {
+			ShaderCache::store(link.cacheKey, link.program);
 		}
 
-		// 4. clean up individual shaders
-		glDeleteShader(vertex);
-		glDeleteShader(fragment);
+		// clean up individual shaders
+		glDeleteShader(link.vertex);
+		glDeleteShader(link.fragment);
+		return success != 0;
 	}
 
-	// activates shader program
-	void use() const {
-		glUseProgram(ID);
+	// attaches the shared Camera/Frame/Lights blocks (binary loads start from the default bindings too) and
+	// reflects the active uniforms so setters never have to ask the driver
+	void setupProgram() {
+		UniformBlocks::bindProgram(ID);
+		buildUniformTable();
 	}
 
-	// queries uniform location and sets its value
-	void setBool(const std::string& name, bool value) const {
-		glUniform1i(glGetUniformLocation(ID, name.c_str()), (int)value);
-	}
+	// open-addressed (linear probing) table of active uniform locations keyed by name hash. a slot only matches
+	// when the check hash agrees too, so setting a name that isn't active (compiled out by a define) can't write
+	// to an active uniform whose hash it happens to share.
+	// an empty slot has location -1, which doubles as the "not found" result.
+	struct UniformSlot {
+		std::uint32_t hash = 0;
+		std::uint32_t check = 0;
+		int location = -1;
+		std::uint32_t value = 0; // index into uniformValues; names aliasing one location ("a", "a[0]") share it
+	};
+	std::vector<UniformSlot> uniformTable;
 
-	void setInt(const std::string& name, int value) const {
-		glUniform1i(glGetUniformLocation(ID, name.c_str()), value);
-	}
+	// shadow copy of one location's last value, stored in uniformData
+	struct UniformValue {
+		int location = -1;
+		GLenum type = 0;
+		std::uint32_t offset = 0;
+		std::uint32_t size = 0;
+		bool known = false; // false until set once; a fresh program holds GL's defaults, not our values
+		bool dirty = false; // set while batched but not committed yet
+	};
+	std::vector<UniformValue> uniformValues;
+	std::vector<unsigned char> uniformData;
+	std::vector<std::uint32_t> dirtyValues;
+	bool batchUploads = false;
 
-	void setFloat(const std::string &name, float value) const {
-		glUniform1f(glGetUniformLocation(ID, name.c_str()), value);
+	const UniformSlot* findSlot(UniformName name) const {
+		if (uniformTable.empty())
+			return nullptr;
+		std::size_t mask = uniformTable.size() - 1;
+		for (std::size_t slot = name.hash & mask; ; slot = (slot + 1) & mask) {
+			const UniformSlot& entry = uniformTable[slot];
+			if (entry.location == -1)
+				return nullptr;
+			if (entry.hash == name.hash && entry.check == name.check)
+				return &entry;
+		}
 	}
 
-	void setMat4(const std::string &name, const glm::mat4 &mat) const {
-        glUniformMatrix4fv(glGetUniformLocation(ID, name.c_str()), 1, GL_FALSE, glm::value_ptr(mat));
+	// compares a new value against the shadow copy and records it. returns true if the caller should upload it
+	// right away; false if it's unchanged, inactive, or deferred to commit().
+	bool stage(UniformName name, const void* data, std::uint32_t size, int& location) {
+		const UniformSlot* slot = findSlot(name);
+		location = slot ? slot->location : -1;
+		if (!slot)
+			return false;
+
+		GLState::Stats& stats = GLState::cache().frame;
+		UniformValue& value = uniformValues[slot->value];
+		if (size != value.size) {
+			// setter doesn't match the declared type (GL will complain); don't shadow it
+			value.known = false;
+			stats.uniformUploads++;
+			return true;
+		}
+		unsigned char* shadow = uniformData.data() + value.offset;
+		if (value.known && std::memcmp(shadow, data, size) == 0) {
+			stats.uniformSkips++;
+			return false;
+		}
+		std::memcpy(shadow, data, size);
+		value.known = true;
+		if (batchUploads) {
+			if (!value.dirty) {
+				value.dirty = true;
+				dirtyValues.push_back(slot->value);
+			}
+			return false;
+		}
+		stats.uniformUploads++;
+		return true;
 	}
 
-	void setVec2(const std::string &name, float x, float y) const {
-        glUniform2f(glGetUniformLocation(ID, name.c_str()), x, y);
+	void uploadValue(const UniformValue& value) const {
+		GLState::cache().frame.uniformUploads++;
+		const unsigned char* data = uniformData.data() + value.offset;
+		const float* floats = reinterpret_cast<const float*>(data);
+		const int* ints = reinterpret_cast<const int*>(data);
+		switch (value.type) {
+			case GL_FLOAT:      glUniform1fv(value.location, 1, floats); break;
+			case GL_FLOAT_VEC2: glUniform2fv(value.location, 1, floats); break;
+			case GL_FLOAT_VEC3: glUniform3fv(value.location, 1, floats); break;
+			case GL_FLOAT_VEC4: glUniform4fv(value.location, 1, floats); break;
+			case GL_FLOAT_MAT4: glUniformMatrix4fv(value.location, 1, GL_FALSE, floats); break;
+			default:            glUniform1iv(value.location, 1, ints); break; // int, bool, samplers
+		}
 	}
 
-	void setVec3(const std::string &name, float x, float y, float z) const {
-        glUniform3f(glGetUniformLocation(ID, name.c_str()), x, y, z);
+	// bytes a setter writes for a uniform of this type; 0 for types no setter covers (never shadowed)
+	static std::uint32_t uniformTypeSize(GLenum type) {
+		switch (type) {
+			case GL_FLOAT:      return sizeof(float);
+			case GL_FLOAT_VEC2: return 2 * sizeof(float);
+			case GL_FLOAT_VEC3: return 3 * sizeof(float);
+			case GL_FLOAT_VEC4: return 4 * sizeof(float);
+			case GL_FLOAT_MAT4: return 16 * sizeof(float);
+			case GL_INT:
+			case GL_BOOL:
+			case GL_SAMPLER_1D:
+			case GL_SAMPLER_2D:
+			case GL_SAMPLER_3D:
+			case GL_SAMPLER_CUBE:
+			case GL_SAMPLER_2D_SHADOW:
+			case GL_SAMPLER_2D_ARRAY:
+			case GL_SAMPLER_2D_ARRAY_SHADOW:
+			case GL_SAMPLER_BUFFER:
+			case GL_INT_SAMPLER_BUFFER:
+			case GL_UNSIGNED_INT_SAMPLER_BUFFER:
+				return sizeof(int);
+			default:
+				return 0;
+		}
 	}
 
-	void setVec3(const std::string &name, const glm::vec3 &vec) const {
-        glUniform3f(glGetUniformLocation(ID, name.c_str()), vec.x, vec.y, vec.z);
+	void insertUniform(const std::string& name, int location, std::uint32_t value) {
+		UniformName key(name);
+		std::size_t mask = uniformTable.size() - 1;
+		for (std::size_t slot = key.hash & mask; ; slot = (slot + 1) & mask) {
+			UniformSlot& entry = uniformTable[slot];
+			if (entry.location == -1) {
+				entry.hash = key.hash;
+				entry.check = key.check;
+				entry.location = location;
+				entry.value = value;
+				return;
+			}
+			if (entry.hash == key.hash && entry.check == key.check) {
+				if (entry.location != location)
+					std::cout << RED << "ERROR::SHADER::UNIFORM_HASH_COLLISION: " << name << WHITE << std::endl;
+				return;
+			}
+		}
 	}
 
-	void setVec4(const std::string &name, float s, float t, float u, float v) const {
-        glUniform4f(glGetUniformLocation(ID, name.c_str()), s, t, u, v);
+	void buildUniformTable() {
+		uniformTable.clear();
+		uniformValues.clear();
+		uniformData.clear();
+		dirtyValues.clear();
+		int nrUniforms = 0, maxNameLength = 0;
+		glGetProgramiv(ID, GL_ACTIVE_UNIFORMS, &nrUniforms);
+		glGetProgramiv(ID, GL_ACTIVE_UNIFORM_MAX_LENGTH, &maxNameLength);
+
+		// gather names first; arrays report a single entry ("lights[0]") with a size, so expand them
+		struct ActiveUniform {
+			std::string name;
+			int location;
+			GLenum type;
+		};
+		std::vector<ActiveUniform> uniforms;
+		std::vector<char> nameBuffer(maxNameLength + 1);
+		for (int i = 0; i < nrUniforms; i++) {
+			int length = 0, size = 0;
+			GLenum type;
+			glGetActiveUniform(ID, i, (GLsizei)nameBuffer.size(), &length, &size, &type, nameBuffer.data());
+			std::string name(nameBuffer.data(), length);
+			int location = glGetUniformLocation(ID, name.c_str());
+			if (location == -1) // lives in a uniform block
+				continue;
+			uniforms.push_back({ name, location, type });
+
+			std::size_t bracket = name.rfind("[0]");
+			if (bracket == std::string::npos || bracket + 3 != name.size())
+				continue;
+			std::string base = name.substr(0, bracket);
+			uniforms.push_back({ base, location, type });
+			for (int element = 1; element < size; element++) {
+				std::string elementName = base + "[" + std::to_string(element) + "]";
+				uniforms.push_back({ elementName, glGetUniformLocation(ID, elementName.c_str()), type });
+			}
+		}
+
+		// keep the load factor at or below 1/2 so probe chains stay short
+		std::size_t capacity = 8;
+		while (capacity < uniforms.size() * 2)
+			capacity *= 2;
+		uniformTable.resize(capacity);
+		for (const ActiveUniform& uniform : uniforms) {
+			if (uniform.location == -1)
+				continue;
+			// one shadow value per location; an array's base name is gathered right after its "[0]" entry
+			std::uint32_t value = (std::uint32_t)uniformValues.size();
+			if (!uniformValues.empty() && uniformValues.back().location == uniform.location)
+				value--;
+			else {
+				UniformValue shadow;
+				shadow.location = uniform.location;
+				shadow.type = uniform.type;
+				shadow.offset = (std::uint32_t)uniformData.size();
+				shadow.size = uniformTypeSize(uniform.type);
+				uniformValues.push_back(shadow);
+				uniformData.resize(uniformData.size() + shadow.size);
+			}
+			insertUniform(uniform.name, uniform.location, value);
+		}
 	}
 };
 
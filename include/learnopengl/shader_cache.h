@@ -0,0 +1,165 @@
+#ifndef SHADER_CACHE_H
+#define SHADER_CACHE_H
+
+#include <glad/glad.h>
+
+#include "learnopengl/gl_extensions.h"
+
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <string>
+#include <vector>
+
+// On-disk cache of linked program binaries (glGetProgramBinary/glProgramBinary).
+//
+// Entries are keyed by a hash of the final shader sources plus the driver vendor/renderer/version strings,
+// so a driver update or a different GPU simply misses. A binary the driver refuses to load is deleted and the
+// caller falls back to compiling from source.
+namespace ShaderCache {
+    const char FILE_MAGIC[8] = { 'L', 'O', 'G', 'L', 'P', 'B', '0', '1' };
+
+    struct Settings {
+        bool enabled = true;
+        std::filesystem::path directory = std::filesystem::current_path() / "shader_cache";
+    };
+
+    inline Settings& settings() {
+        static Settings s;
+        return s;
+    }
+
+    inline void setEnabled(bool enabled) { settings().enabled = enabled; }
+    inline void setDirectory(const std::filesystem::path& directory) { settings().directory = directory; }
+
+    // the driver has to be able to hand out binaries in the first place
+    inline bool available() {
+        return settings().enabled && GLExtensions::support().programBinary;
+    }
+
+    // FNV-1a 64-bit, chained across several strings
+    inline std::uint64_t hashBytes(const void* data, std::size_t size, std::uint64_t hash = 14695981039346656037ull) {
+        const unsigned char* bytes = static_cast<const unsigned char*>(data);
+        for (std::size_t i = 0; i < size; i++) {
+            hash ^= bytes[i];
+            hash *= 1099511628211ull;
+        }
+        return hash;
+    }
+
+    inline std::uint64_t hashString(const std::string& str, std::uint64_t hash) {
+        // include the terminator so ("ab", "c") and ("a", "bc") hash differently
+        return hashBytes(str.c_str(), str.size() + 1, hash);
+    }
+
+    inline std::string glString(GLenum name) {
+        const GLubyte* str = glGetString(name);
+        return str ? reinterpret_cast<const char*>(str) : "";
+    }
+
+    inline std::uint64_t makeKey(const std::vector<std::string>& sources) {
+        std::uint64_t hash = hashBytes(FILE_MAGIC, sizeof(FILE_MAGIC));
+        for (const std::string& source : sources)
+            hash = hashString(source, hash);
+        hash = hashString(glString(GL_VENDOR), hash);
+        hash = hashString(glString(GL_RENDERER), hash);
+        hash = hashString(glString(GL_VERSION), hash);
+        return hash;
+    }
+
+    inline std::filesystem::path entryPath(std::uint64_t key) {
+        char name[32];
+        std::snprintf(name, sizeof(name), "%016llx.bin", static_cast<unsigned long long>(key));
+        return settings().directory / name;
+    }
+
+    // returns a linked program, or 0 on a miss / rejected binary
+    inline unsigned int load(std::uint64_t key) {
+        if (!available())
+            return 0;
+
+        std::filesystem::path path = entryPath(key);
+        std::ifstream file(path, std::ios::binary);
+        if (!file)
+            return 0;
+        std::vector<char> contents((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+        file.close();
+
+        const std::size_t headerSize = sizeof(FILE_MAGIC) + sizeof(std::uint64_t) + sizeof(GLenum);
+        std::uint64_t storedKey = 0;
+        GLenum format = 0;
+        bool valid = contents.size() > headerSize && std::memcmp(contents.data(), FILE_MAGIC, sizeof(FILE_MAGIC)) == 0;
+        if (valid) {
+            std::memcpy(&storedKey, contents.data() + sizeof(FILE_MAGIC), sizeof(storedKey));
+            std::memcpy(&format, contents.data() + sizeof(FILE_MAGIC) + sizeof(storedKey), sizeof(format));
+            valid = storedKey == key;
+        }
+
+        unsigned int program = 0;
+        if (valid) {
+            program = glCreateProgram();
+            GLExtensions::ProgramBinary(program, format, contents.data() + headerSize, (GLsizei)(contents.size() - headerSize));
+            int success = 0;
+            glGetProgramiv(program, GL_LINK_STATUS, &success);
+            if (!success) {
+                glDeleteProgram(program);
+                program = 0;
+            }
+        }
+
+        // stale or corrupt; drop it so the recompiled program can take its place
+        if (!program) {
+            std::error_code ec;
+            std::filesystem::remove(path, ec);
+        }
+        return program;
+    }
+
+    // must be called before glLinkProgram on programs that are going to be stored
+    inline void prepare(unsigned int program) {
+        if (available())
+            GLExtensions::ProgramParameteri(program, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
+    }
+
+    inline void store(std::uint64_t key, unsigned int program) {
+        if (!available())
+            return;
+
+        GLint length = 0;
+        glGetProgramiv(program, GL_PROGRAM_BINARY_LENGTH, &length);
+        if (length <= 0)
+            return;
+        std::vector<char> binary(length);
+        GLenum format = 0;
+        GLExtensions::GetProgramBinary(program, length, &length, &format, binary.data());
+
+        std::error_code ec;
+        std::filesystem::create_directories(settings().directory, ec);
+        // write to a temporary name first so a crash never leaves a truncated entry behind
+        std::filesystem::path path = entryPath(key);
+        std::filesystem::path tmpPath = path;
+        tmpPath += ".tmp";
+        std::ofstream file(tmpPath, std::ios::binary | std::ios::trunc);
+        if (!file)
+            return;
+        file.write(FILE_MAGIC, sizeof(FILE_MAGIC));
+        file.write(reinterpret_cast<const char*>(&key), sizeof(key));
+        file.write(reinterpret_cast<const char*>(&format), sizeof(format));
+        file.write(binary.data(), length);
+        file.close();
+        if (file)
+            std::filesystem::rename(tmpPath, path, ec);
+        else
+            std::filesystem::remove(tmpPath, ec);
+    }
+
+    inline void clear() {
+        std::error_code ec;
+        std::filesystem::remove_all(settings().directory, ec);
+    }
+}
+
+#endif
@@ -0,0 +1,162 @@
+#ifndef SHADER_PREPROCESSOR_H
+#define SHADER_PREPROCESSOR_H
+
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <utility>
+#include <vector>
+
+// (name, value) pairs injected as "#define name value" right after #version; an empty value defines just the name
+typedef std::vector<std::pair<std::string, std::string>> ShaderDefines;
+
+// Source-level preprocessing done before a shader is handed to the driver:
+//
+//  - #include "file" splices in another file, resolved relative to the file that includes it. Every file is
+//    included at most once per stage, so shared headers need no guards and cycles are harmless.
+//  - defines are injected after the #version line, so one file can be compiled into several permutations.
+//
+// #line directives keep driver error messages pointing at the right line; the source string number in them is
+// the file's index in the list load() returns (0 is the top-level file).
+namespace ShaderPreprocessor {
+    // if line is `#include "file"` (whitespace allowed around the #), stores file and returns true
+    inline bool parseInclude(const std::string& line, std::string& file) {
+        std::size_t pos = line.find_first_not_of(" \t");
+        if (pos == std::string::npos || line[pos] != '#')
+            return false;
+        pos = line.find_first_not_of(" \t", pos + 1);
+        if (pos == std::string::npos || line.compare(pos, 7, "include") != 0)
+            return false;
+        std::size_t open = line.find('"', pos + 7);
+        std::size_t close = open == std::string::npos ? std::string::npos : line.find('"', open + 1);
+        if (close == std::string::npos)
+            return false;
+        file = line.substr(open + 1, close - open - 1);
+        return true;
+    }
+
+    inline bool isVersionLine(const std::string& line) {
+        std::size_t pos = line.find_first_not_of(" \t");
+        if (pos == std::string::npos || line[pos] != '#')
+            return false;
+        pos = line.find_first_not_of(" \t", pos + 1);
+        return pos != std::string::npos && line.compare(pos, 7, "version") == 0;
+    }
+
+    inline bool readFile(const std::filesystem::path& path, std::string& contents) {
+        std::ifstream file;
+        file.exceptions(std::ifstream::failbit | std::ifstream::badbit);
+        try {
+            file.open(path);
+            std::stringstream stream;
+            stream << file.rdbuf();
+            contents = stream.str();
+        }
+        catch (std::ifstream::failure& e) {
+            return false;
+        }
+        return true;
+    }
+
+    // appends path to out with its includes expanded; files collects every file read (for #line and watching)
+    inline bool expand(const std::filesystem::path& path, std::string& out, std::vector<std::string>& files) {
+        int index = (int)files.size();
+        files.push_back(path.string());
+
+        std::string contents;
+        if (!readFile(path, contents)) {
+            std::cout << "\033[1;31m" << "ERROR::SHADER::FILE_NOT_SUCCESSFULLY_READ: " << path.string() << "\033[0m" << std::endl;
+            return false;
+        }
+
+        std::istringstream stream(contents);
+        std::string line, included;
+        int lineNumber = 0;
+        while (std::getline(stream, line)) {
+            lineNumber++;
+            if (!parseInclude(line, included)) {
+                out += line;
+                out += '\n';
+                continue;
+            }
+
+            std::filesystem::path includePath = (path.parent_path() / included).lexically_normal();
+            bool seen = false;
+            for (const std::string& file : files)
+                seen = seen || std::filesystem::path(file) == includePath;
+            if (seen) { // already spliced in once; keep the line count intact
+                out += '\n';
+                continue;
+            }
+
+            out += "#line 1 " + std::to_string(files.size()) + "\n";
+            if (!expand(includePath, out, files))
+                return false;
+            out += "#line " + std::to_string(lineNumber + 1) + " " + std::to_string(index) + "\n";
+        }
+        return true;
+    }
+
+    inline std::string injectDefines(const std::string& source, const ShaderDefines& defines) {
+        if (defines.empty())
+            return source;
+
+        std::string block;
+        for (const auto& define : defines)
+            block += "#define " + define.first + (define.second.empty() ? "" : " " + define.second) + "\n";
+
+        // #version has to stay the first statement; without one the defines simply go first
+        std::istringstream stream(source);
+        std::string line;
+        std::size_t offset = 0;
+        int lineNumber = 0;
+        while (std::getline(stream, line)) {
+            lineNumber++;
+            offset += line.size() + 1;
+            if (isVersionLine(line))
+                return source.substr(0, offset) + block + "#line " + std::to_string(lineNumber + 1) + " 0\n" + source.substr(offset);
+        }
+        return block + "#line 1 0\n" + source;
+    }
+
+    // reads a shader stage, expands includes and injects defines. files receives every file it depends on.
+    inline bool load(const std::string& path, const ShaderDefines& defines, std::string& source, std::vector<std::string>& files) {
+        std::string expanded;
+        files.clear();
+        if (!expand(std::filesystem::path(path).lexically_normal(), expanded, files))
+            return false;
+        source = injectDefines(expanded, defines);
+        return true;
+    }
+
+    // order-independent hash of a define set, so {A, B} and {B, A} select the same permutation
+    inline std::uint64_t hashDefines(const ShaderDefines& defines) {
+        std::uint64_t hash = 0;
+        for (const auto& define : defines) {
+            std::uint64_t h = 14695981039346656037ull;
+            for (char c : define.first) { h ^= (unsigned char)c; h *= 1099511628211ull; }
+            h ^= '='; h *= 1099511628211ull;
+            for (char c : define.second) { h ^= (unsigned char)c; h *= 1099511628211ull; }
+            hash += h ^ (h >> 29); // summing keeps it order-independent
+        }
+        return hash;
+    }
+
+    inline bool sameDefines(const ShaderDefines& a, const ShaderDefines& b) {
+        if (a.size() != b.size())
+            return false;
+        for (const auto& define : a) {
+            bool found = false;
+            for (const auto& other : b)
+                found = found || other == define;
+            if (!found)
+                return false;
+        }
+        return true;
+    }
+}
+
+#endif
@@ -0,0 +1,170 @@
+#ifndef SHADER_VARIANTS_H
+#define SHADER_VARIANTS_H
+
+#include "learnopengl/file_watcher.h"
+#include "learnopengl/shader.h"
+#include "learnopengl/shader_preprocessor.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+// Permutations of one vertex/fragment pair, compiled lazily the first time a define set is asked for and cached
+// by a hash of that set. Draws can then pick a program specialized for exactly the lights and features in play
+// (e.g. NR_POINT_LIGHTS=4, FLASHLIGHT=1) instead of a worst-case uber-shader. Each variant goes through the
+// program binary cache like any other Shader, so warm starts don't recompile them. Hot reload watches the files
+// once for all permutations: includes expand the same whatever the defines, so the sources are read once per edit
+// and every variant only injects its own defines.
+//
+//     ShaderVariants objectShaders("object.vert", "object.frag");
+//     Shader& shader = objectShaders.get({ { "NR_POINT_LIGHTS", "4" } });
+class ShaderVariants {
+public:
+    ShaderVariants(const char* vertexPath, const char* fragmentPath) : vertexPath(vertexPath), fragmentPath(fragmentPath) {}
+
+    ShaderVariants(const ShaderVariants&) = delete;
+    ShaderVariants& operator=(const ShaderVariants&) = delete;
+
+    // the order of the defines doesn't matter. references stay valid for the lifetime of this object.
+    // a variant submitted by prepare() is finished by its first use().
+    Shader& get(const ShaderDefines& defines) {
+        return find(defines, Shader::COMPILE_BLOCKING);
+    }
+
+    // submits a variant's compile without waiting for it, so permutations known up front (e.g. during loading)
+    // compile concurrently instead of stalling the first frame that needs them
+    void prepare(const ShaderDefines& defines) {
+        find(defines, Shader::COMPILE_ASYNC);
+    }
+
+    // true when every submitted variant can be finished without stalling
+    bool ready() const {
+        for (const auto& entry : variants)
+            if (!entry.second.shader->ready())
+                return false;
+        for (const Variant& collision : collisions)
+            if (!collision.shader->ready())
+                return false;
+        return true;
+    }
+
+    // applies to every variant, including ones compiled later
+    void enableHotReload() {
+        Sources sources;
+        readSources(sources);
+        watch(sources);
+    }
+
+    // call once per frame like Shader::reloadIfChanged(); returns true if any variant was swapped
+    bool reloadIfChanged() {
+        std::unique_ptr<Sources> sources;
+        {
+            // never wait on the watcher; it'll still be there next frame
+            std::unique_lock<std::mutex> lock(pendingMutex, std::try_to_lock);
+            if (lock.owns_lock())
+                sources = std::move(pending);
+        }
+        if (sources && sources->ok) {
+            for (auto& entry : variants)
+                entry.second.shader->reloadFrom(sources->vertexCode, sources->fragmentCode, sources->vertexFiles, sources->fragmentFiles);
+            for (Variant& collision : collisions)
+                collision.shader->reloadFrom(sources->vertexCode, sources->fragmentCode, sources->vertexFiles, sources->fragmentFiles);
+            // the edit may have added or dropped an #include
+            if (watchedFiles(*sources) != watched)
+                watch(*sources);
+        }
+
+        bool swapped = false;
+        for (auto& entry : variants)
+            swapped = entry.second.shader->reloadIfChanged() || swapped;
+        for (Variant& collision : collisions)
+            swapped = collision.shader->reloadIfChanged() || swapped;
+        return swapped;
+    }
+
+    std::size_t size() const {
+        return variants.size() + collisions.size();
+    }
+
+private:
+    struct Variant {
+        ShaderDefines defines;
+        std::unique_ptr<Shader> shader;
+    };
+
+    // both stages with includes expanded and no defines, read by the watcher thread
+    struct Sources {
+        bool ok = false;
+        std::string vertexCode, fragmentCode;
+        std::vector<std::string> vertexFiles, fragmentFiles;
+    };
+
+    std::string vertexPath, fragmentPath;
+    std::unordered_map<std::uint64_t, Variant> variants;
+    std::vector<Variant> collisions;
+
+    std::vector<std::string> watched;
+    std::mutex pendingMutex;
+    std::unique_ptr<Sources> pending;
+    // declared after what its callback touches, so it's destroyed (and joined) first
+    std::unique_ptr<FileWatcher> watcher;
+
+    void readSources(Sources& sources) const {
+        sources.ok = ShaderPreprocessor::load(vertexPath, ShaderDefines(), sources.vertexCode, sources.vertexFiles) &&
+            ShaderPreprocessor::load(fragmentPath, ShaderDefines(), sources.fragmentCode, sources.fragmentFiles);
+    }
+
+    // every file either stage depends on, plus the top-level files even if they couldn't be read this time
+    std::vector<std::string> watchedFiles(const Sources& sources) const {
+        std::vector<std::string> files = sources.vertexFiles;
+        for (const std::string& file : sources.fragmentFiles)
+            if (std::find(files.begin(), files.end(), file) == files.end())
+                files.push_back(file);
+        for (const std::string& path : { vertexPath, fragmentPath })
+            if (std::find(files.begin(), files.end(), path) == files.end())
+                files.push_back(path);
+        return files;
+    }
+
+    void watch(const Sources& sources) {
+        watched = watchedFiles(sources);
+        watcher.reset(new FileWatcher(watched, [this]() {
+            // runs on the watcher thread: the file I/O happens here, the per-variant work on the render thread
+            std::unique_ptr<Sources> read(new Sources());
+            readSources(*read);
+            std::lock_guard<std::mutex> lock(pendingMutex);
+            pending = std::move(read);
+        }));
+    }
+
+    Shader& find(const ShaderDefines& defines, Shader::CompileMode mode) {
+        std::uint64_t hash = ShaderPreprocessor::hashDefines(defines);
+        auto it = variants.find(hash);
+        if (it == variants.end())
+            return *variants.emplace(hash, makeVariant(defines, mode)).first->second.shader;
+        if (ShaderPreprocessor::sameDefines(it->second.defines, defines))
+            return *it->second.shader;
+
+        // two define sets with the same hash; never expected in practice, so a linear list is fine
+        for (Variant& collision : collisions)
+            if (ShaderPreprocessor::sameDefines(collision.defines, defines))
+                return *collision.shader;
+        std::cout << "\033[1;31m" << "ERROR::SHADER::VARIANT_HASH_COLLISION" << "\033[0m" << std::endl;
+        collisions.push_back(makeVariant(defines, mode));
+        return *collisions.back().shader;
+    }
+
+    Variant makeVariant(const ShaderDefines& defines, Shader::CompileMode mode) const {
+        Variant variant;
+        variant.defines = defines;
+        variant.shader.reset(new Shader(vertexPath.c_str(), fragmentPath.c_str(), defines, mode));
+        return variant;
+    }
+};
+
+#endif
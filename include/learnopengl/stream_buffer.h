@@ -0,0 +1,180 @@
+#ifndef STREAM_BUFFER_H
+#define STREAM_BUFFER_H
+
+#include <glad/glad.h>
+
+#include "learnopengl/gl_extensions.h"
+#include "learnopengl/ring_allocator.h"
+#include "learnopengl/uniform_blocks.h"
+
+#include <algorithm>
+#include <cstring>
+#include <iostream>
+
+// RingAllocator's fences as GL sync objects (core since 3.2)
+struct GLFences {
+    typedef GLsync Fence;
+
+    Fence insert() {
+        return glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+    }
+
+    bool signaled(Fence fence) {
+        GLenum result = glClientWaitSync(fence, 0, 0);
+        return result == GL_ALREADY_SIGNALED || result == GL_CONDITION_SATISFIED;
+    }
+
+    void wait(Fence fence) {
+        // the flush makes sure the fence itself reaches the GPU, or this could wait forever
+        GLbitfield flags = GL_SYNC_FLUSH_COMMANDS_BIT;
+        while (true) {
+            GLenum result = glClientWaitSync(fence, flags, 1000000000ull);
+            if (result != GL_TIMEOUT_EXPIRED)
+                return;
+            flags = 0;
+        }
+    }
+
+    void remove(Fence fence) {
+        glDeleteSync(fence);
+    }
+};
+
+// Per-frame data (uniform blocks, instance attributes, ...) written straight into one buffer instead of through
+// a glBufferSubData or a glUniform* call per item. With GLExtensions::support().bufferStorage the buffer is
+// allocated once with glBufferStorage, mapped persistently and coherently, and split into three regions by a
+// RingAllocator: each frame writes the region the GPU finished with two frames ago, with a plain memcpy. On a
+// plain 3.3 context the buffer is one region that's orphaned at the start of every frame and written with
+// glBufferSubData, so the driver hands out fresh storage rather than waiting on the previous frame's draws.
+//
+//     StreamBuffer stream(64 * 1024);                           // bytes per frame
+//     stream.beginFrame();
+//     stream.bindUniformBlock(UniformBlocks::CAMERA, cameraData); // replaces the block's UniformBuffer binding
+//     std::size_t offset = stream.push(instances.data(), bytes, 16);
+//     ... draw ...
+//     stream.endFrame();                                        // after the last draw reading this frame's data
+//
+// Offsets are only good for the frame they were pushed in; what's bound from the stream has to be bound again
+// every frame.
+//
+// deleteBuffers() drops the fences still in flight, unmaps a persistent mapping and frees the buffer.
+class StreamBuffer {
+public:
+    static const std::size_t NO_SPACE = RingAllocator<GLFences>::NO_SPACE;
+    static const int FRAMES_IN_FLIGHT = 3;
+
+    unsigned int buffer;
+
+    explicit StreamBuffer(std::size_t bytesPerFrame)
+        : persistent(GLExtensions::support().bufferStorage),
+          allocator(fences, bytesPerFrame, persistent ? FRAMES_IN_FLIGHT : 1) {
+        GLint alignment = 0;
+        glGetIntegerv(GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT, &alignment);
+        uniformAlignment = std::max<std::size_t>(alignment, 1);
+
+        glGenBuffers(1, &buffer);
+        glBindBuffer(GL_COPY_WRITE_BUFFER, buffer);
+        std::size_t size = allocator.regionSize() * allocator.nrRegions();
+        if (persistent) {
+            GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+            GLExtensions::BufferStorage(GL_COPY_WRITE_BUFFER, size, NULL, flags);
+            mapped = static_cast<char*>(glMapBufferRange(GL_COPY_WRITE_BUFFER, 0, size, flags));
+            if (!mapped) {
+                // immutable storage can't be orphaned: start over with a plain buffer (the regions then simply
+                // take turns, every frame orphaning the whole buffer)
+                std::cout << "\033[1;31m" << "ERROR::STREAM_BUFFER::PERSISTENT_MAP_FAILED" << "\033[0m" << std::endl;
+                glDeleteBuffers(1, &buffer);
+                glGenBuffers(1, &buffer);
+                glBindBuffer(GL_COPY_WRITE_BUFFER, buffer);
+                persistent = false;
+            }
+        }
+        if (!persistent)
+            glBufferData(GL_COPY_WRITE_BUFFER, size, NULL, GL_STREAM_DRAW);
+        glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+    }
+
+    StreamBuffer(const StreamBuffer&) = delete;
+    StreamBuffer& operator=(const StreamBuffer&) = delete;
+
+    bool isPersistent() const {
+        return persistent;
+    }
+
+    void beginFrame() {
+        allocator.beginFrame();
+        if (!persistent) {
+            glBindBuffer(GL_COPY_WRITE_BUFFER, buffer);
+            glBufferData(GL_COPY_WRITE_BUFFER, allocator.regionSize() * allocator.nrRegions(), NULL, GL_STREAM_DRAW);
+            glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+        }
+    }
+
+    // copies size bytes into this frame's region at an alignment (a power of two, at most 256) and returns their
+    // offset in buffer, or NO_SPACE when the region is full
+    std::size_t push(const void* data, std::size_t size, std::size_t alignment) {
+        std::size_t offset = allocator.allocate(size, alignment);
+        if (offset == NO_SPACE) {
+            if (!warnedFull) {
+                std::cout << "\033[1;31m" << "ERROR::STREAM_BUFFER::FRAME_REGION_FULL" << "\033[0m" << std::endl;
+                warnedFull = true;
+            }
+            return NO_SPACE;
+        }
+
+        if (persistent) {
+            std::memcpy(mapped + offset, data, size);
+        } else {
+            glBindBuffer(GL_COPY_WRITE_BUFFER, buffer);
+            glBufferSubData(GL_COPY_WRITE_BUFFER, offset, size, data);
+            glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+        }
+        return offset;
+    }
+
+    // pushes a std140 block and points its binding at it, for this frame; false (and the binding left alone)
+    // when it didn't fit
+    template <typename Block>
+    bool bindUniformBlock(UniformBlocks::Binding binding, const Block& data) {
+        std::size_t offset = push(&data, sizeof(Block), uniformAlignment);
+        if (offset == NO_SPACE)
+            return false;
+        glBindBufferRange(GL_UNIFORM_BUFFER, binding, buffer, offset, sizeof(Block));
+        return true;
+    }
+
+    // after the frame's last draw from the buffer; only the persistent ring needs to know when the GPU is done
+    void endFrame() {
+        if (persistent)
+            allocator.endFrame();
+    }
+
+    const RingAllocator<GLFences>::Stats& stats() const {
+        return allocator.stats();
+    }
+
+    std::size_t totalWaits() const {
+        return allocator.totalWaits();
+    }
+
+    void deleteBuffers() {
+        allocator.release();
+        if (mapped) {
+            glBindBuffer(GL_COPY_WRITE_BUFFER, buffer);
+            glUnmapBuffer(GL_COPY_WRITE_BUFFER);
+            glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+            mapped = nullptr;
+        }
+        glDeleteBuffers(1, &buffer);
+    }
+
+private:
+    bool persistent;
+    GLFences fences; // before allocator, which keeps a reference
+    RingAllocator<GLFences> allocator;
+    char* mapped = nullptr;
+    std::size_t uniformAlignment = 1;
+    bool warnedFull = false;
+};
+
+#endif
@@ -0,0 +1,111 @@
+#ifndef THREAD_POOL_H
+#define THREAD_POOL_H
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Persistent worker threads for per-frame data-parallel jobs. Spawning threads every frame costs more than the
+// jobs themselves, so the workers are created once and parked on a condition variable between jobs.
+//
+// parallelFor(count, task) calls task(i) for every i in [0, count) on the workers and the calling thread and
+// returns when all calls have finished. Items are handed out one at a time, so make each one a decent chunk of
+// work (a depth slice, a row of tiles) rather than a single element.
+class ThreadPool {
+public:
+    // nrThreads counts the calling thread, so ThreadPool(1) runs everything inline
+    explicit ThreadPool(unsigned int nrThreads = std::max(1u, std::thread::hardware_concurrency())) {
+        for (unsigned int t = 1; t < std::max(1u, nrThreads); t++)
+            workers.emplace_back(&ThreadPool::run, this);
+    }
+
+    ~ThreadPool() {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            stop = true;
+        }
+        wake.notify_all();
+        for (std::thread& worker : workers)
+            worker.join();
+    }
+
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    unsigned int size() const {
+        return static_cast<unsigned int>(workers.size()) + 1;
+    }
+
+    // not reentrant: call it from one thread at a time, and not from inside a task
+    void parallelFor(std::size_t count, const std::function<void(std::size_t)>& task) {
+        if (count == 0)
+            return;
+        if (workers.empty() || count == 1) {
+            for (std::size_t i = 0; i < count; i++)
+                task(i);
+            return;
+        }
+
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            job = &task;
+            jobSize = count;
+            next = 0;
+            busyWorkers = static_cast<unsigned int>(workers.size());
+            generation++;
+        }
+        wake.notify_all();
+
+        work(task, count);
+
+        std::unique_lock<std::mutex> lock(mutex);
+        done.wait(lock, [this]() { return busyWorkers == 0; });
+        job = nullptr;
+    }
+
+private:
+    std::vector<std::thread> workers;
+    std::mutex mutex;
+    std::condition_variable wake, done;
+    const std::function<void(std::size_t)>* job = nullptr;
+    std::size_t jobSize = 0;
+    std::atomic<std::size_t> next { 0 };
+    unsigned int busyWorkers = 0;
+    unsigned long long generation = 0;
+    bool stop = false;
+
+    void work(const std::function<void(std::size_t)>& task, std::size_t count) {
+        for (std::size_t i = next++; i < count; i = next++)
+            task(i);
+    }
+
+    void run() {
+        unsigned long long seen = 0;
+        for (;;) {
+            const std::function<void(std::size_t)>* task;
+            std::size_t count;
+            {
+                std::unique_lock<std::mutex> lock(mutex);
+                wake.wait(lock, [&]() { return stop || generation != seen; });
+                if (stop)
+                    return;
+                seen = generation;
+                task = job;
+                count = jobSize;
+            }
+
+            work(*task, count);
+
+            std::lock_guard<std::mutex> lock(mutex);
+            if (--busyWorkers == 0)
+                done.notify_one();
+        }
+    }
+};
+
+#endif
@@ -0,0 +1,63 @@
+#ifndef TRANSPARENT_SORTER_H
+#define TRANSPARENT_SORTER_H
+
+#include "learnopengl/radix_sort.h"
+
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+// Back-to-front order for blended draws. Each frame the caller adds its transparent objects by index with their
+// distance from the camera, sorts, and draws them in order():
+//
+//     sorter.clear();
+//     for (i ...) sorter.add(i, glm::length(cameraPos - positions[i]));
+//     sorter.sort();
+//     for (const SortPair& pair : sorter.order()) draw(positions[pair.value]);
+//
+// Unlike a std::map keyed by distance, objects at the same distance are all kept (in the order they were
+// added), and the pairs live in a flat array that is reused, so once it has grown nothing is allocated per frame.
+// Distances are keyed by their float bits, which keeps full precision and takes at most three radix passes (see
+// radixSort()); fewer when the distances in a frame share their sign and high exponent bits.
+class TransparentSorter {
+public:
+    void clear() {
+        pairs.clear();
+    }
+
+    void reserve(std::size_t count) {
+        pairs.reserve(count);
+        scratch.reserve(count);
+    }
+
+    void add(std::uint32_t index, float distance) {
+        pairs.push_back({ farToNearKey(distance), index });
+    }
+
+    void sort() {
+        radixSort(pairs, scratch);
+    }
+
+    // farthest first; value is the index given to add()
+    const std::vector<SortPair>& order() const {
+        return pairs;
+    }
+
+    std::size_t size() const {
+        return pairs.size();
+    }
+
+    // ascending keys for descending distances: IEEE floats order like integers once negative ones have all their
+    // bits flipped and the rest just the sign bit; inverting that reverses the order
+    static std::uint64_t farToNearKey(float distance) {
+        std::uint32_t bits;
+        std::memcpy(&bits, &distance, sizeof(bits));
+        bits = (bits & 0x80000000u) ? ~bits : (bits | 0x80000000u);
+        return ~bits;
+    }
+
+private:
+    std::vector<SortPair> pairs, scratch;
+};
+
+#endif
@@ -0,0 +1,177 @@
+#ifndef UNIFORM_BLOCKS_H
+#define UNIFORM_BLOCKS_H
+
+#include <glad/glad.h>
+
+#include <glm/glm.hpp>
+
+#include <cstddef>
+
+// Per-frame data shared by every program through std140 uniform blocks at fixed binding points.
+//
+// The C++ structs below mirror the GLSL block declarations byte for byte (std140: vec3 is 16-byte aligned and a
+// following float packs into its 4th component; arrays and structs are padded to 16 bytes), so each block is
+// uploaded with a single glBufferSubData. GLSL 330 can't say layout(binding = N), so Shader binds every block
+// it finds by name to the point listed in BLOCK_BINDINGS right after linking.
+//
+//     layout (std140) uniform Camera {
+//         mat4 view;
+//         mat4 projection;
+//         mat4 viewProjection;
+//         vec3 viewPos;
+//     };
+//
+//     layout (std140) uniform Frame {
+//         vec2 resolution;
+//         float time;
+//         float deltaTime;
+//     };
+//
+//     layout (std140) uniform Lights {
+//         DirectionalLight dirLight;
+//         PointLight pointLights[MAX_POINT_LIGHTS];
+//         int nrPointLights;
+//         bool flashLightOn;
+//         SpotLight flashLight;
+//     };
+//
+// Lights keeps the data that changes every frame (the flashlight) at its end, so a chapter whose other lights
+// stay put rewrites just that tail with update(data, offset, size).
+namespace UniformBlocks {
+    enum Binding : unsigned int {
+        CAMERA = 0,
+        FRAME  = 1,
+        LIGHTS = 2
+    };
+
+    struct BlockBinding {
+        const char* name;
+        Binding binding;
+    };
+
+    const BlockBinding BLOCK_BINDINGS[] = {
+        { "Camera", CAMERA },
+        { "Frame",  FRAME  },
+        { "Lights", LIGHTS },
+    };
+
+    // capacity of the pointLights[] array in the Lights block; shaders loop over nrPointLights (or fewer)
+    const int MAX_POINT_LIGHTS = 16;
+
+    // points a freshly linked program's blocks at the shared binding points
+    inline void bindProgram(unsigned int program) {
+        for (const BlockBinding& block : BLOCK_BINDINGS) {
+            unsigned int index = glGetUniformBlockIndex(program, block.name);
+            if (index != GL_INVALID_INDEX)
+                glUniformBlockBinding(program, index, block.binding);
+        }
+    }
+}
+
+struct CameraBlock {
+    glm::mat4 view;
+    glm::mat4 projection;
+    glm::mat4 viewProjection;
+    glm::vec3 viewPos;
+    float     padding0;
+};
+
+struct FrameBlock {
+    glm::vec2 resolution;
+    float     time;
+    float     deltaTime;
+};
+
+// struct DirectionalLight { vec3 direction; vec3 ambient; vec3 diffuse; vec3 specular; };
+struct DirectionalLightStd140 {
+    glm::vec3 direction; float padding0;
+    glm::vec3 ambient;   float padding1;
+    glm::vec3 diffuse;   float padding2;
+    glm::vec3 specular;  float padding3;
+};
+
+// struct PointLight { vec3 position; float constant; vec3 ambient; float linear;
+//                     vec3 diffuse; float quadratic; vec3 specular; };
+struct PointLightStd140 {
+    glm::vec3 position; float constant;
+    glm::vec3 ambient;  float linear;
+    glm::vec3 diffuse;  float quadratic;
+    glm::vec3 specular; float padding0;
+};
+
+// struct SpotLight { vec3 position; float constant; vec3 direction; float linear;
+//                    vec3 diffuse; float quadratic; vec3 specular; float innerAngle; float outerAngle; };
+struct SpotLightStd140 {
+    glm::vec3 position;  float constant;
+    glm::vec3 direction; float linear;
+    glm::vec3 diffuse;   float quadratic;
+    glm::vec3 specular;  float innerAngle;
+    float     outerAngle;
+    float     padding0[3];
+};
+
+struct LightsBlock {
+    DirectionalLightStd140 dirLight;
+    PointLightStd140       pointLights[UniformBlocks::MAX_POINT_LIGHTS];
+    int                    nrPointLights;
+    int                    flashLightOn; // GLSL bool is 4 bytes in std140
+    int                    padding0[2];
+    SpotLightStd140        flashLight;
+};
+
+static_assert(sizeof(CameraBlock) == 208, "CameraBlock must match the std140 Camera block");
+static_assert(sizeof(FrameBlock) == 16, "FrameBlock must match the std140 Frame block");
+static_assert(sizeof(DirectionalLightStd140) == 64, "std140 DirectionalLight is 64 bytes");
+static_assert(sizeof(PointLightStd140) == 64, "std140 PointLight is 64 bytes");
+static_assert(sizeof(SpotLightStd140) == 80, "std140 SpotLight is 80 bytes");
+static_assert(offsetof(LightsBlock, pointLights) == 64, "pointLights[] must start at std140 offset 64");
+static_assert(offsetof(LightsBlock, nrPointLights) == 64 + 64 * UniformBlocks::MAX_POINT_LIGHTS, "nrPointLights follows pointLights[]");
+static_assert(offsetof(LightsBlock, flashLight) == offsetof(LightsBlock, nrPointLights) + 16, "flashLight starts at the next 16-byte boundary");
+static_assert(sizeof(LightsBlock) - offsetof(LightsBlock, flashLightOn) == 92, "the per-frame tail (flashLightOn, flashLight) is 92 bytes");
+
+// one uniform buffer per block, bound once to its binding point and rewritten whole with a single update.
+//
+// Like Mesh, this and the other GL wrappers in learnopengl/ never delete their GL objects on destruction: the
+// chapters keep them alive until glfwTerminate, and a glDelete* from a destructor that runs after it would call
+// into a destroyed context. The wrappers that own several objects have an explicit delete call instead
+// (deleteBuffers() in most of them), to be made while the context is still current.
+template <typename Block>
+class UniformBuffer {
+public:
+    unsigned int UBO;
+
+    explicit UniformBuffer(UniformBlocks::Binding binding) : binding(binding) {
+        glGenBuffers(1, &UBO);
+        glBindBuffer(GL_UNIFORM_BUFFER, UBO);
+        glBufferData(GL_UNIFORM_BUFFER, sizeof(Block), NULL, GL_DYNAMIC_DRAW);
+        bind();
+        glBindBuffer(GL_UNIFORM_BUFFER, 0);
+    }
+
+    // points the binding back at this buffer, after something else (a StreamBuffer) was bound there
+    void bind() {
+        glBindBufferBase(GL_UNIFORM_BUFFER, binding, UBO);
+    }
+
+    UniformBuffer(const UniformBuffer&) = delete;
+    UniformBuffer& operator=(const UniformBuffer&) = delete;
+
+    void update(const Block& data) {
+        glBindBuffer(GL_UNIFORM_BUFFER, UBO);
+        glBufferSubData(GL_UNIFORM_BUFFER, 0, sizeof(Block), &data);
+        glBindBuffer(GL_UNIFORM_BUFFER, 0);
+    }
+
+    // rewrites bytes [offset, offset + size) of the block from the same bytes of data; the rest keeps what the
+    // last full update() wrote
+    void update(const Block& data, std::size_t offset, std::size_t size) {
+        glBindBuffer(GL_UNIFORM_BUFFER, UBO);
+        glBufferSubData(GL_UNIFORM_BUFFER, offset, size, reinterpret_cast<const char*>(&data) + offset);
+        glBindBuffer(GL_UNIFORM_BUFFER, 0);
+    }
+
+private:
+    UniformBlocks::Binding binding;
+};
+
+#endif
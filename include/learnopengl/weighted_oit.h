@@ -0,0 +1,100 @@
+#ifndef WEIGHTED_OIT_H
+#define WEIGHTED_OIT_H
+
+#include <glad/glad.h>
+
+#include "learnopengl/gl_state.h"
+
+#include <iostream>
+
+// Weighted blended order-independent transparency (McGuire and Bavoil) in two extra attachments of an existing
+// framebuffer, depth tested against its opaque scene:
+//
+//     attachment 1  RGBA16F  rgb: sum of color * alpha * weight; a: revealage, the product of (1 - alpha)
+//     attachment 2  R16F     sum of alpha * weight
+//
+// Transparent surfaces are drawn in any order between begin() and end(), writing src/shaders/oit.glsl's outputs,
+// then a fullscreen pass reads both targets and blends the weighted average over attachment 0. No sorting, and
+// surfaces that cut through each other blend as well as any others.
+//
+// Core 3.3 has no per-attachment blend functions (glBlendFunci is 4.0), so both targets share one: color is added
+// and alpha multiplied by (1 - source alpha). That's why revealage sits in attachment 1's alpha rather than in a
+// target of its own.
+//
+// deleteBuffers() frees the accumulation and weight targets; the framebuffer they were attached to is the caller's.
+class WeightedBlendedOIT {
+public:
+    unsigned int framebuffer;
+    unsigned int accumulation, weights;
+    int width, height;
+
+    WeightedBlendedOIT(unsigned int framebuffer, int width, int height) : framebuffer(framebuffer), width(width), height(height) {
+        GLState::bindFramebuffer(GL_FRAMEBUFFER, framebuffer);
+
+        accumulation = makeTarget(GL_RGBA16F, GL_RGBA);
+        weights = makeTarget(GL_R16F, GL_RED);
+        glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT1, GL_TEXTURE_2D, accumulation, 0);
+        glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT2, GL_TEXTURE_2D, weights, 0);
+
+        if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE)
+            std::cout << "\033[1;31m" << "ERROR::WEIGHTED_OIT::FRAMEBUFFER_INCOMPLETE" << "\033[0m" << std::endl;
+        GLState::bindFramebuffer(GL_FRAMEBUFFER, 0);
+    }
+
+    WeightedBlendedOIT(const WeightedBlendedOIT&) = delete;
+    WeightedBlendedOIT& operator=(const WeightedBlendedOIT&) = delete;
+
+    // binds the framebuffer with only the two targets drawn to, clears them, and sets up blending with depth
+    // testing on but depth writes off (the transparent surfaces mustn't hide each other)
+    void begin() const {
+        GLState::bindFramebuffer(GL_FRAMEBUFFER, framebuffer);
+        const GLenum drawBuffers[] = { GL_NONE, GL_COLOR_ATTACHMENT1, GL_COLOR_ATTACHMENT2 };
+        glDrawBuffers(3, drawBuffers);
+        const float clearAccumulation[] = { 0.0f, 0.0f, 0.0f, 1.0f };
+        const float clearWeights[] = { 0.0f, 0.0f, 0.0f, 0.0f };
+        glClearBufferfv(GL_COLOR, 1, clearAccumulation);
+        glClearBufferfv(GL_COLOR, 2, clearWeights);
+
+        GLState::enable(GL_DEPTH_TEST);
+        GLState::enable(GL_BLEND);
+        glDepthMask(GL_FALSE);
+        glBlendFuncSeparate(GL_ONE, GL_ONE, GL_ZERO, GL_ONE_MINUS_SRC_ALPHA);
+    }
+
+    // back to drawing attachment 0 with depth writes and the usual alpha blending, ready for the composite
+    void end() const {
+        const GLenum drawBuffers[] = { GL_COLOR_ATTACHMENT0 };
+        glDrawBuffers(1, drawBuffers);
+        glDepthMask(GL_TRUE);
+        glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+    }
+
+    // accumulation and weights on two consecutive texture units
+    void bindTextures(unsigned int firstUnit) const {
+        GLState::bindTexture(firstUnit, GL_TEXTURE_2D, accumulation);
+        GLState::bindTexture(firstUnit + 1, GL_TEXTURE_2D, weights);
+    }
+
+    void deleteBuffers() {
+        GLState::forgetTexture(accumulation);
+        GLState::forgetTexture(weights);
+        glDeleteTextures(1, &accumulation);
+        glDeleteTextures(1, &weights);
+    }
+
+private:
+    // read with texelFetch at the pixel being composited, so no filtering or mipmaps
+    unsigned int makeTarget(GLenum internalFormat, GLenum format) const {
+        unsigned int texture;
+        glGenTextures(1, &texture);
+        GLState::bindTexture(GL_TEXTURE_2D, texture);
+        glTexImage2D(GL_TEXTURE_2D, 0, internalFormat, width, height, 0, format, GL_FLOAT, NULL);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+        return texture;
+    }
+};
+
+#endif
@@ -1,9 +1,16 @@
 #version 330 core
 out vec4 FragColor;
 
+#ifdef INSTANCED
+in vec3 LampColor;
+#else
 uniform vec3 lightColor;
+#endif
 
 void main()
 {
+#ifdef INSTANCED
+    vec3 lightColor = LampColor;
+#endif
     FragColor = vec4(lightColor, 1.0f);
 }
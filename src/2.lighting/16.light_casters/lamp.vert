@@ -1,11 +1,24 @@
 #version 330 core
 layout(location = 0) in vec3 aPos;
+#ifdef INSTANCED
+// per instance (see InstanceBuffer): the model matrix, and the color in xyz
+layout(location = 1) in mat4 instanceModel;
+layout(location = 5) in vec4 instanceData;
 
+out vec3 LampColor;
+#endif
+
+#include "../../shaders/camera.glsl"
+
+#ifndef INSTANCED
 uniform mat4 model;
-uniform mat4 view;
-uniform mat4 projection;
+#endif
 
 void main() 
 {
-    gl_Position = projection * view * model * vec4(aPos, 1.0f); 
+#ifdef INSTANCED
+    mat4 model = instanceModel;
+    LampColor = instanceData.rgb;
+#endif
+    gl_Position = viewProjection * model * vec4(aPos, 1.0f); 
 }
@@ -1,12 +1,25 @@
 // local includes
 #include "glad/glad.h"
 #include "glfw/glfw3.h"
+#include "learnopengl/gl_extensions.h"
+#include "learnopengl/gl_state.h"
 #include "learnopengl/shader.h"
+#include "learnopengl/shader_variants.h"
 #include "learnopengl/camera.h"
-#include "stb_image/stb_image.h"
+#include "learnopengl/image_decoder.h"
+#include "learnopengl/uniform_blocks.h"
+#include "learnopengl/clustered_lighting.h"
+#include "learnopengl/cascaded_shadows.h"
+#include "learnopengl/light_culling.h"
+#include "learnopengl/lightmap_baker.h"
+#include "learnopengl/irradiance_probes.h"
+#include "learnopengl/instance_buffer.h"
+#include "learnopengl/command_list.h"
+#include "learnopengl/stream_buffer.h"
 
 // global includes
 #include <cstdio>
+#include <cstring>
 #include <iostream>
 #include <filesystem>
 #include <ostream>
@@ -50,7 +63,9 @@ void scroll_callback(GLFWwindow* window, double xoffset, double yoffset);
 void key_callback(GLFWwindow* window, int key, int scancode, int action, int mods);
 float genRandFloat(float min, float max);
 unsigned int loadTexture(std::string texPath);
-void setPointLights(const std::vector<PointLight>& PointLights, const Shader& shaderProgram, const int MAX_POINT_LIGHTS);
+void setDirectionalLight(const DirectionalLight& dirLight, LightsBlock& lights);
+void setPointLights(const std::vector<PointLight>& PointLights, LightsBlock& lights);
+ClusteredPointLight toClusteredLight(const PointLight& pl);
 
 // settings
 const unsigned int SCR_WIDTH    = 1200;
@@ -70,6 +85,36 @@ Camera* camera = new Camera(SCR_WIDTH, SCR_HEIGHT);
 // toggles flashlight state in object fragment
 bool flashLightOn = false;
 
+// toggles clustered shading (the point lights plus NR_CLUSTERED_LIGHTS small ones) in object fragment
+bool clusteredLighting = false;
+
+// toggles CPU light culling: the first NR_CULLING_CANDIDATES clustered lights are culled and ranked each frame,
+// and the most important MAX_POINT_LIGHTS of them go into the Lights block (ignored while clustered shading is on)
+bool lightCulling = false;
+
+// toggles baked lighting: the static cubes read the directional and point lights from a lightmap instead of
+// shading them (the flashlight stays dynamic, the moving cubes are always shaded)
+bool bakedLighting = false;
+
+// toggles the irradiance probes: every shaded cube takes its ambient light from the probe grid instead of the
+// lights' constant ambient terms
+bool irradianceProbes = false;
+
+// toggles instancing: the static cubes, the moving cubes and the lamps each go out as one instanced draw instead
+// of a uniform upload and a draw per object
+bool instancing = false;
+
+// toggles the stress test: NR_STRESS_CUBES more cubes spread far around the scene (shaded, but casting no shadows),
+// to compare CPU submit time with and without instancing
+bool stressTest = false;
+
+// toggles parallel recording: cubes drawn one by one are frustum culled and recorded into command lists on worker
+// threads, and the render thread only replays the lists
+bool parallelRecording = false;
+
+// toggles streaming: the Camera and Lights blocks and the moving cubes' instances are written into a
+// StreamBuffer each frame (persistently mapped when the driver can) instead of through glBufferSubData/orphaning
+bool streamFrameData = false;
 
 int main() {
 //////////////////////////////
@@ -114,6 +159,8 @@ if (!gladLoadGLLoader((GLADloadproc)glfwGetProcAddress)) {
     logError("Failed to initialize GLAD");
     return -1;
 }
+// optional entry points beyond core 3.3 (program binaries, ...)
+GLExtensions::load((GLADloadproc)glfwGetProcAddress);
 
 //////////////////
 ///// OPENGL /////
@@ -124,8 +171,20 @@ glEnable(GL_DEPTH_TEST);
 ///// SHADER /////
 //////////////////
 // build and compile our shader program
-Shader objectShader( (shaderPath + "object.vert").c_str(), (shaderPath + "object.frag").c_str() );
-Shader lampShader( (shaderPath + "lamp.vert").c_str(), (shaderPath + "lamp.frag").c_str() );
+// object.frag is compiled per permutation (light count, flashlight on/off); see the LIGHTING section
+ShaderVariants objectShaders( (shaderPath + "object.vert").c_str(), (shaderPath + "object.frag").c_str() );
+// compiled in the background while the textures load; finished by its first use()
+Shader lampShader( (shaderPath + "lamp.vert").c_str(), (shaderPath + "lamp.frag").c_str(), ShaderDefines(), Shader::COMPILE_ASYNC );
+// the same, with the model matrix and color per instance
+Shader lampInstancedShader( (shaderPath + "lamp.vert").c_str(), (shaderPath + "lamp.frag").c_str(), ShaderDefines{ { "INSTANCED", "" } }, Shader::COMPILE_ASYNC );
+// depth only, for the directional light's shadow cascades
+Shader shadowShader( (shaderPath + "shadow.vert").c_str(), (shaderPath + "shadow.frag").c_str(), ShaderDefines(), Shader::COMPILE_ASYNC );
+
+// recompile edited shaders while the app runs
+objectShaders.enableHotReload();
+lampShader.enableHotReload();
+lampInstancedShader.enableHotReload();
+shadowShader.enableHotReload();
 
 ////////////////////
 ///// VERTICES /////
@@ -194,6 +253,23 @@ for (int i = 0; i < nCubes; i++) {
     cubePos.push_back(pos);
 }
 
+// the cubes never move, so their shadows are cached (see SHADOWS); a few orbiting ones are redrawn every frame
+const int NR_MOVING_CUBES = 3;
+const glm::vec3 cubeMin(-0.5f), cubeMax(0.5f);
+std::vector<ShadowCaster> staticCasters;
+staticCasters.reserve(nCubes);
+
+for (int i = 0; i < nCubes; i++) {
+    glm::mat4 model = glm::mat4(1.0f);
+    model = glm::translate(model, cubePos[i]);
+
+    float angle = 20.0f * i;
+    model = glm::rotate(model, angle, glm::vec3(1.0f, 0.5f, 0.3f));
+    staticCasters.push_back({ model, cubeMin, cubeMax });
+}
+
+std::vector<ShadowCaster> dynamicCasters(NR_MOVING_CUBES, ShadowCaster{ glm::mat4(1.0f), cubeMin, cubeMax });
+
 //////////////////////////
 ///// LIGHTING/THEME /////
 //////////////////////////
@@ -226,6 +302,154 @@ for (int idx = 0; idx < NR_POINT_LIGHTS; ++idx) {
     PointLights.push_back(pl);
 }
 
+// the lights don't move, so the Lights block is filled once; only the flashlight changes per frame.
+// it sits at the end of the block, so each frame rewrites those bytes and nothing else
+LightsBlock lightsData = {};
+setDirectionalLight(dirLight, lightsData);
+setPointLights(PointLights, lightsData);
+
+lightsData.flashLight.diffuse    = glm::vec3(1.0);
+lightsData.flashLight.specular   = glm::vec3(1.0);
+lightsData.flashLight.constant   = 1.0f;
+lightsData.flashLight.linear     = 0.09f;
+lightsData.flashLight.quadratic  = 0.032f;
+lightsData.flashLight.innerAngle = glm::cos(glm::radians(12.0f));
+lightsData.flashLight.outerAngle = glm::cos(glm::radians(17.0f));
+
+// object shader permutations: the point light count is baked in, the flashlight compiled in or out.
+// both are submitted now so they compile alongside the texture loads instead of when F is first pressed.
+const ShaderDefines flashLightOffDefines = { { "NR_POINT_LIGHTS", std::to_string(NR_POINT_LIGHTS) }, { "FLASHLIGHT", "0" } };
+const ShaderDefines flashLightOnDefines  = { { "NR_POINT_LIGHTS", std::to_string(NR_POINT_LIGHTS) }, { "FLASHLIGHT", "1" } };
+objectShaders.prepare(flashLightOffDefines);
+objectShaders.prepare(flashLightOnDefines);
+
+////////////////////////////
+///// CLUSTERED LIGHTS /////
+////////////////////////////
+// with C toggled on, the point lights above plus a swarm of small ones are assigned to view frustum clusters
+// each frame, and object.frag only shades the lights listed for its cluster
+const int NR_CLUSTERED_LIGHTS = 1024;
+const Attenuation smallAtt = { 1.0f, 0.7f, 1.8f };
+std::vector<ClusteredPointLight> clusteredLights;
+clusteredLights.reserve(NR_POINT_LIGHTS + NR_CLUSTERED_LIGHTS);
+
+for (const PointLight& pl : PointLights)
+    clusteredLights.push_back(toClusteredLight(pl));
+
+for (int idx = 0; idx < NR_CLUSTERED_LIGHTS; ++idx) {
+    PointLight pl;
+    pl.position = glm::vec3(genRandFloat(-6, 6), genRandFloat(-6, 6), genRandFloat(-6, 6));
+    pl.baseColor = glm::vec3(genRandFloat(0.1f, 0.5f), genRandFloat(0.1f, 0.5f), genRandFloat(0.1f, 0.5f));
+    pl.phong.ambient = glm::vec3(0.0f);
+    pl.phong.diffuse = pl.baseColor;
+    pl.phong.specular = pl.baseColor;
+    pl.attenuation = smallAtt;
+
+    clusteredLights.push_back(toClusteredLight(pl));
+}
+
+// the cluster lists live in texture buffers on units 2-4 (0 and 1 hold the material maps)
+ClusteredLighting clustered(2);
+
+const ShaderDefines clusteredOffDefines = { { "CLUSTERED_LIGHTING", "" }, { "FLASHLIGHT", "0" } };
+const ShaderDefines clusteredOnDefines  = { { "CLUSTERED_LIGHTING", "" }, { "FLASHLIGHT", "1" } };
+objectShaders.prepare(clusteredOffDefines);
+objectShaders.prepare(clusteredOnDefines);
+
+//////////////////////////
+///// LIGHT CULLING //////
+//////////////////////////
+// candidates: the point lights above and the first of the small ones, more than the Lights block holds
+const int NR_CULLING_CANDIDATES = 64;
+LightCuller culler;
+std::vector<glm::vec4> candidateSpheres(NR_CULLING_CANDIDATES);
+std::vector<float> candidateIntensities(NR_CULLING_CANDIDATES);
+
+for (int idx = 0; idx < NR_CULLING_CANDIDATES; ++idx) {
+    const ClusteredPointLight& light = clusteredLights[idx];
+    candidateSpheres[idx] = glm::vec4(light.position, light.radius);
+    candidateIntensities[idx] = std::max(std::max(light.diffuse.r, light.diffuse.g), light.diffuse.b);
+}
+
+// the surviving count changes per frame, so these read nrPointLights instead of a baked-in count
+const ShaderDefines culledOffDefines = { { "FLASHLIGHT", "0" } };
+const ShaderDefines culledOnDefines  = { { "FLASHLIGHT", "1" } };
+objectShaders.prepare(culledOffDefines);
+objectShaders.prepare(culledOnDefines);
+bool pointLightsCulled = false; // whether the Lights block holds culled lights instead of PointLights
+
+///////////////////
+///// SHADOWS /////
+///////////////////
+// four cascades up to 30 units out, on texture unit 5; the box covers every cube, static or moving
+const float SHADOW_DISTANCE = 30.0f;
+const unsigned int SHADOW_UNIT = 5;
+CascadedShadowMaps shadows(2048);
+shadows.setLight(dirLight.direction, glm::vec3(-7.0f), glm::vec3(7.0f));
+
+////////////////////
+///// LIGHTMAP /////
+////////////////////
+// the static cubes under the Lights block's directional and point lights, with shadows and one bounce, baked on
+// the CPU at startup (or loaded from lightmap_cache/ when this exact layout was baked before)
+std::vector<glm::vec3> cubePositions;
+cubePositions.reserve(36);
+for (int v = 0; v < 36; v++)
+    cubePositions.push_back(glm::vec3(vertices[8 * v], vertices[8 * v + 1], vertices[8 * v + 2]));
+
+BakeScene bakeScene;
+int cubeMesh = bakeScene.addMesh(cubePositions);
+for (const ShadowCaster& cube : staticCasters)
+    bakeScene.addInstance(cubeMesh, cube.model, glm::vec3(0.5f)); // roughly the container's average color
+bakeScene.setLights(lightsData);
+bakeScene.build();
+
+// the same static scene lights a grid of probes over the shadow box, for the ambient light of everything in it
+LightmapBaker lightmaps(bakeScene);
+IrradianceProbes probes(glm::vec3(-7.0f), glm::vec3(7.0f), glm::ivec3(8));
+float bakeStart = static_cast<float>(glfwGetTime());
+bool lightmapCached;
+float probeSeconds;
+{
+    ThreadPool bakePool;
+    lightmapCached = lightmaps.bake(bakePool);
+    float probeStart = static_cast<float>(glfwGetTime());
+    probes.bake(bakeScene, bakePool);
+    probeSeconds = static_cast<float>(glfwGetTime()) - probeStart;
+}
+float bakeSeconds = static_cast<float>(glfwGetTime()) - bakeStart - probeSeconds;
+const unsigned int PROBE_UNIT = 7;
+probes.upload();
+const unsigned int LIGHTMAP_UNIT = 6;
+unsigned int lightmapTexture = lightmaps.createTexture();
+
+const ShaderDefines bakedOffDefines = { { "LIGHTMAP", "" }, { "FLASHLIGHT", "0" } };
+const ShaderDefines bakedOnDefines  = { { "LIGHTMAP", "" }, { "FLASHLIGHT", "1" } };
+objectShaders.prepare(bakedOffDefines);
+objectShaders.prepare(bakedOnDefines);
+
+// any of the permutations, plus one of the defines toggled at runtime (IRRADIANCE_PROBES, INSTANCED)
+auto withDefine = [](ShaderDefines defines, const char* name) {
+    defines.push_back({ name, "" });
+    return defines;
+};
+
+//////////////////////////
+///// UNIFORM BLOCKS /////
+//////////////////////////
+// shared by the object shaders and lampShader through fixed binding points
+UniformBuffer<CameraBlock> cameraBlock(UniformBlocks::CAMERA);
+UniformBuffer<LightsBlock> lightsBlock(UniformBlocks::LIGHTS);
+lightsBlock.update(lightsData);
+// the per-frame tail of the Lights block (flashLightOn and the flashlight, 92 bytes), rewritten every frame
+const std::size_t flashLightOffset = offsetof(LightsBlock, flashLightOn);
+const std::size_t flashLightBytes = sizeof(LightsBlock) - flashLightOffset;
+const std::size_t pointLightsOffset = offsetof(LightsBlock, pointLights);
+
+// the same blocks, and the moving cubes' instances, streamed (see streamFrameData); a few KB a frame
+StreamBuffer frameStream(64 * 1024);
+bool frameDataStreamed = false, movingCubesStreamed = false;
+
 ////////////////////
 ///// TEXTURES /////
 ////////////////////
@@ -243,130 +467,390 @@ glGenBuffers(1, &VBO);
 glBindBuffer(GL_ARRAY_BUFFER, VBO);
 glBufferData(GL_ARRAY_BUFFER, sizeof(vertices), vertices, GL_STATIC_DRAW);
 
+// lightmap UVs, one per cube vertex (the atlas rectangle is picked per cube with lightmapScaleOffset)
+const std::vector<glm::vec2>& lightmapUVs = lightmaps.meshUVs(cubeMesh);
+unsigned int lightmapVBO;
+glGenBuffers(1, &lightmapVBO);
+glBindBuffer(GL_ARRAY_BUFFER, lightmapVBO);
+glBufferData(GL_ARRAY_BUFFER, lightmapUVs.size() * sizeof(glm::vec2), lightmapUVs.data(), GL_STATIC_DRAW);
+
 ///////////////
 ///// VAO /////
 ///////////////
+// the cube's attributes: positions, normals, texture coords from VBO, lightmap UVs from lightmapVBO
+auto setCubeAttributes = [&](unsigned int vertexArray) {
+    glBindVertexArray(vertexArray);
+    glBindBuffer(GL_ARRAY_BUFFER, VBO);
+
+    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 8*sizeof(float), (void*)0);
+    glEnableVertexAttribArray(0);
+    glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, 8*sizeof(float), (void*)(3*sizeof(float)));
+    glEnableVertexAttribArray(1);
+    glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, 8*sizeof(float), (void*)(6*sizeof(float)));
+    glEnableVertexAttribArray(2);
+    glBindBuffer(GL_ARRAY_BUFFER, lightmapVBO);
+    glVertexAttribPointer(3, 2, GL_FLOAT, GL_FALSE, 2*sizeof(float), (void*)0);
+    glEnableVertexAttribArray(3);
+};
+
 // generate VAOs
 unsigned int objectVAO, lampVAO;
 glGenVertexArrays(1, &objectVAO);
 glGenVertexArrays(1, &lampVAO);
 
 // set object VAO
-glBindVertexArray(objectVAO);
-
-glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 8*sizeof(float), (void*)0);
-glEnableVertexAttribArray(0);
-glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, 8*sizeof(float), (void*)(3*sizeof(float)));
-glEnableVertexAttribArray(1);
-glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, 8*sizeof(float), (void*)(6*sizeof(float)));
-glEnableVertexAttribArray(2);
+setCubeAttributes(objectVAO);
 
 // set lamp VAO
 glBindVertexArray(lampVAO);
+glBindBuffer(GL_ARRAY_BUFFER, VBO);
 
 glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 8*sizeof(float), (void*)0);
 glEnableVertexAttribArray(0);
 
+//////////////////////
+///// INSTANCING /////
+//////////////////////
+// with I toggled on, each group of cubes is one instanced draw from its own vertex array: the cube's attributes
+// plus an InstanceBuffer at location 4 (object.vert); the lamps get theirs at location 1 (lamp.vert)
+const int NR_STRESS_CUBES = 1000000;
+unsigned int staticCubesVAO, movingCubesVAO, stressCubesVAO;
+glGenVertexArrays(1, &staticCubesVAO);
+glGenVertexArrays(1, &movingCubesVAO);
+glGenVertexArrays(1, &stressCubesVAO);
+setCubeAttributes(staticCubesVAO);
+setCubeAttributes(movingCubesVAO);
+setCubeAttributes(stressCubesVAO);
+
+InstanceBuffer staticCubeInstances, movingCubeInstances, stressCubeInstances, lampInstances;
+staticCubeInstances.attach(staticCubesVAO, 4);
+movingCubeInstances.attach(movingCubesVAO, 4);
+stressCubeInstances.attach(stressCubesVAO, 4);
+lampInstances.attach(lampVAO, 1);
+
+// the static cubes carry their lightmap rectangle and the lamps their color; neither changes, so both are
+// uploaded once. the moving cubes are streamed every frame, the stress cubes generated on the first M
+std::vector<InstanceData> staticCubes, movingCubes(NR_MOVING_CUBES), stressCubes, lamps;
+for (std::size_t i = 0; i < staticCasters.size(); i++)
+    staticCubes.push_back({ staticCasters[i].model, lightmaps.scaleOffset((int)i) });
+staticCubeInstances.update(staticCubes);
+
+// the point lights' lamps first, then the small ones, in clusteredLights' order
+for (int lampIdx = 0; lampIdx < (int)clusteredLights.size(); ++lampIdx) {
+    bool pointLight = lampIdx < NR_POINT_LIGHTS;
+    glm::mat4 lampModel = glm::translate(glm::mat4(1.0f), clusteredLights[lampIdx].position);
+    lampModel = glm::scale(lampModel, glm::vec3(pointLight ? 0.2f : 0.05f));
+    glm::vec3 color = pointLight ? PointLights[lampIdx].baseColor : clusteredLights[lampIdx].diffuse;
+    lamps.push_back({ lampModel, glm::vec4(color, 1.0f) });
+}
+lampInstances.update(lamps);
+
+/////////////////////////
+///// COMMAND LISTS /////
+/////////////////////////
+// chunks of cubes are culled and recorded by whichever thread picks them up (see CommandRecorder)
+const std::size_t RECORD_CHUNK = 4096;
+const float CUBE_RADIUS = 0.87f; // bounding sphere of a unit cube
+ThreadPool recordPool;
+CommandRecorder cubeRecorder;
+
 // unbind to prevent accidental state changes
 glBindVertexArray(0);
 
 ///////////////////////
 ///// RENDER LOOP /////
 ///////////////////////
+// everything above talked to GL directly; from here on state changes go through GLState
+GLState::invalidate();
+
+// CPU time spent submitting the cubes and lamps, for the title
+float submitMilliseconds = 0.0f;
+
 while (!glfwWindowShouldClose(window)) {
     // update delta time
     float currentFrame = static_cast<float>(glfwGetTime());
     deltaTime = currentFrame - lastFrame;
     lastFrame = currentFrame;
 
+    // state cache / uniform shadow counters for the previous frame, shown in the title once a second
+    GLState::beginFrame();
+    if (static_cast<int>(currentFrame) != static_cast<int>(currentFrame - deltaTime)) {
+        const GLState::Stats& stats = GLState::lastFrame();
+        std::string title = "LearnOpenGL | GL state calls: " + std::to_string(stats.issued) + " issued, " + std::to_string(stats.skipped) + " skipped"
+            + " | uniforms: " + std::to_string(stats.uniformUploads) + " uploaded, " + std::to_string(stats.uniformSkips) + " unchanged";
+        if (clusteredLighting)
+            title += " | clusters: " + std::to_string(clusteredLights.size()) + " lights, " + std::to_string(clustered.clusters.indices().size()) + " assignments";
+        else if (lightCulling) {
+            const LightCuller::Stats& cullStats = culler.stats();
+            title += " | lights: " + std::to_string(cullStats.kept) + " of " + std::to_string(cullStats.candidates)
+                + " (" + std::to_string(cullStats.outsideFrustum) + " outside, " + std::to_string(cullStats.occluded) + " occluded, "
+                + std::to_string(cullStats.dropped) + " over the cap)";
+        }
+        // static + dynamic casters drawn per cascade; "cached" when the static layer was reused
+        title += " | shadow draws:";
+        for (int cascade = 0; cascade < CascadedShadowMaps::NR_CASCADES; cascade++) {
+            const CascadedShadowMaps::Stats& shadowStats = shadows.stats(cascade);
+            title += " " + (shadowStats.staticCached ? std::string("cached") : std::to_string(shadowStats.staticDrawn))
+                + "+" + std::to_string(shadowStats.dynamicDrawn);
+        }
+        if (bakedLighting)
+            title += " | lightmap: " + std::to_string(lightmaps.width()) + "x" + std::to_string(lightmaps.height())
+                + (lightmapCached ? std::string(" from cache") : " baked in " + std::to_string(bakeSeconds) + "s");
+        if (irradianceProbes)
+            title += " | probes: " + std::to_string(probes.nrProbes()) + " baked in " + std::to_string(probeSeconds) + "s";
+        if (instancing || stressTest)
+            title += std::string(" | ") + (instancing ? "instanced" : "one draw per cube")
+                + (stressTest ? ", " + std::to_string(NR_STRESS_CUBES) + " extra cubes" : std::string())
+                + (parallelRecording && !instancing ? ", recorded on " + std::to_string(recordPool.size()) + " threads" : std::string())
+                + ": submit " + std::to_string(submitMilliseconds) + " ms, frame " + std::to_string(deltaTime * 1000.0f) + " ms";
+        if (streamFrameData)
+            title += std::string(" | streamed ") + (frameStream.isPersistent() ? "through a persistent ring" : "through an orphaned buffer")
+                + ": " + std::to_string(frameStream.stats().bytes) + " bytes/frame, " + std::to_string(frameStream.totalWaits()) + " fence waits";
+        glfwSetWindowTitle(window, title.c_str());
+    }
+
     // input
     processInput(window);
 
-    // set background
-    glClearColor(background.x, background.y, background.z, 1.0f);
-    glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+    // pick up shader edits (every uniform is set per frame below, so nothing to redo)
+    objectShaders.reloadIfChanged();
+    lampShader.reloadIfChanged();
+    lampInstancedShader.reloadIfChanged();
+    shadowShader.reloadIfChanged();
+
+    // matrices (one upload for every program that declares the Camera block)
+    glm::mat4 model = glm::mat4(1.0f);
+    CameraBlock cameraData;
+    cameraData.view           = camera->getViewMatrix();
+    cameraData.projection     = camera->getProjectionMatrix();
+    cameraData.viewProjection = cameraData.projection * cameraData.view;
+    cameraData.viewPos        = camera->cameraPos;
+
+    // switching back from streaming: the blocks' own buffers get their bindings back and catch up on the lights
+    if (frameDataStreamed && !streamFrameData) {
+        cameraBlock.bind();
+        lightsBlock.bind();
+        lightsBlock.update(lightsData);
+    }
+    frameDataStreamed = streamFrameData;
+    if (streamFrameData) {
+        frameStream.beginFrame();
+        frameStream.bindUniformBlock(UniformBlocks::CAMERA, cameraData);
+    } else {
+        cameraBlock.update(cameraData);
+    }
+    glm::vec4 frustum[6];
+    frustumPlanes(cameraData.viewProjection, frustum);
 
-    // matrices
-    glm::mat4 model         = glm::mat4(1.0f);
-    glm::mat4 view          = camera->getViewMatrix();
-    glm::mat4 projection    = camera->getProjectionMatrix();
-
-    // use object shader
-    objectShader.use();
-
-    // set directional light properties 
-    objectShader.setVec3("dirLight.direction"   , dirLight.direction);
-    objectShader.setVec3("dirLight.ambient"     , dirLight.phong.ambient);
-    objectShader.setVec3("dirLight.diffuse"     , dirLight.phong.diffuse);
-    objectShader.setVec3("dirLight.specular"    , dirLight.phong.specular);
-
-    // set point light(s) properties
-    setPointLights(PointLights, objectShader, NR_POINT_LIGHTS);
-
-    // set spot light property (flashlight)
-    objectShader.setBool("flashLightOn", flashLightOn);
-
-    if (flashLightOn) {
-        objectShader.setVec3("flashLight.position"    , camera->cameraPos);
-        objectShader.setVec3("flashLight.direction"   , camera->cameraFront);
-        objectShader.setVec3("flashLight.diffuse"     , glm::vec3(1.0));
-        objectShader.setVec3("flashLight.specular"    , glm::vec3(1.0));
-        objectShader.setFloat("flashLight.constant"   , 1.0f);
-        objectShader.setFloat("flashLight.linear"     , 0.09f);
-        objectShader.setFloat("flashLight.quadratic"  , 0.032f);
-        objectShader.setFloat("flashLight.innerAngle" , glm::cos(glm::radians(12.0f)));
-        objectShader.setFloat("flashLight.outerAngle" , glm::cos(glm::radians(17.0f)));
+    // move the orbiting cubes
+    for (int i = 0; i < NR_MOVING_CUBES; i++) {
+        float orbit = currentFrame * 0.5f + i * glm::radians(360.0f / NR_MOVING_CUBES);
+        model = glm::mat4(1.0f);
+        model = glm::translate(model, glm::vec3(3.0f * glm::cos(orbit), 1.5f * (i - 1), 3.0f * glm::sin(orbit)));
+        model = glm::rotate(model, currentFrame, glm::vec3(0.3f, 1.0f, 0.5f));
+        dynamicCasters[i].model = model;
+        movingCubes[i].model = model;
+    }
+    if (instancing) {
+        std::size_t streamOffset = streamFrameData
+            ? frameStream.push(movingCubes.data(), movingCubes.size() * sizeof(InstanceData), sizeof(glm::vec4))
+            : StreamBuffer::NO_SPACE;
+        // streamed instances sit at a new offset every frame, so the attributes follow them
+        if (streamOffset != StreamBuffer::NO_SPACE) {
+            InstanceBuffer::attachBuffer(movingCubesVAO, 4, frameStream.buffer, streamOffset);
+        } else {
+            movingCubeInstances.update(movingCubes);
+            if (movingCubesStreamed)
+                movingCubeInstances.attach(movingCubesVAO, 4);
+        }
+        movingCubesStreamed = streamOffset != StreamBuffer::NO_SPACE;
     }
 
-    // set object material properties
-    objectShader.setInt("material.diffuse", 0);
-    objectShader.setInt("material.specular", 1);
-    objectShader.setFloat("material.shininess", 64.0f);
+    // the stress cubes: random spots and orientations far around the scene, uploaded once
+    if (stressTest && stressCubes.empty()) {
+        stressCubes.reserve(NR_STRESS_CUBES);
+        for (int i = 0; i < NR_STRESS_CUBES; i++) {
+            model = glm::translate(glm::mat4(1.0f), glm::vec3(genRandFloat(-200, 200), genRandFloat(-200, 200), genRandFloat(-200, 200)));
+            model = glm::rotate(model, genRandFloat(0, 6.28f), glm::vec3(1.0f, 0.5f, 0.3f));
+            stressCubes.push_back({ model, glm::vec4(0.0f) });
+        }
+        stressCubeInstances.update(stressCubes);
+    }
 
-    // set object position
-    objectShader.setVec3("viewPos", camera->cameraPos);
-    objectShader.setMat4("view", view);
-    objectShader.setMat4("projection", projection);
+    // shadow cascades: static casters only when a cascade moved, the orbiting cubes every frame
+    shadows.update(cameraData.view, cameraData.projection, SHADOW_DISTANCE);
+    shadows.render(shadowShader, staticCasters, dynamicCasters, [&](const ShadowCaster&) {
+        GLState::bindVertexArray(objectVAO);
+        glDrawArrays(GL_TRIANGLES, 0, 36);
+    });
 
-    // bind texture
-    glActiveTexture(GL_TEXTURE0);
-    glBindTexture(GL_TEXTURE_2D, texture);
-    glActiveTexture(GL_TEXTURE1);
-    glBindTexture(GL_TEXTURE_2D, specularTexture);
+    // back to the window
+    int framebufferWidth, framebufferHeight;
+    glfwGetFramebufferSize(window, &framebufferWidth, &framebufferHeight);
+    GLState::bindFramebuffer(GL_FRAMEBUFFER, 0);
+    glViewport(0, 0, framebufferWidth, framebufferHeight);
 
-    // draw object
-    glBindVertexArray(objectVAO);
-
-    for (int i = 0; i < nCubes; i++) {
-        model = glm::mat4(1.0f);    
-        model = glm::translate(model, cubePos[i]);
-        
-        float angle = 20.0f * i;
-        model = glm::rotate(model, angle, glm::vec3(1.0f, 0.5f, 0.3f));
-        objectShader.setMat4("model", model);
+    // set background
+    glClearColor(background.x, background.y, background.z, 1.0f);
+    glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
 
-        glDrawArrays(GL_TRIANGLES, 0, 36);
+    // set spot light property (flashlight), then upload it (the static lights before it are already on the GPU)
+    lightsData.flashLightOn         = flashLightOn;
+    lightsData.flashLight.position  = camera->cameraPos;
+    lightsData.flashLight.direction = camera->cameraFront;
+    bool cullPointLights = lightCulling && !clusteredLighting;
+    if (cullPointLights) {
+        // frustum + occlusion (cubes as their inscribed spheres), then the brightest on screen up to the block's capacity
+        culler.begin(cameraData.view, cameraData.projection);
+        for (const std::vector<ShadowCaster>* casters : { &staticCasters, &dynamicCasters })
+            for (const ShadowCaster& cube : *casters)
+                culler.addOccluder(glm::vec3(cube.model[3]), 0.5f);
+        const std::vector<unsigned int>& visible = culler.cull(candidateSpheres, candidateIntensities, UniformBlocks::MAX_POINT_LIGHTS);
+
+        // ClusteredPointLight shares PointLightStd140's layout, radius in the padding
+        for (std::size_t i = 0; i < visible.size(); i++)
+            std::memcpy(&lightsData.pointLights[i], &clusteredLights[visible[i]], sizeof(PointLightStd140));
+        lightsData.nrPointLights = (int)visible.size();
+
+        // the surviving lights, then the count and flashlight
+        if (!streamFrameData) {
+            lightsBlock.update(lightsData, pointLightsOffset, visible.size() * sizeof(PointLightStd140));
+            lightsBlock.update(lightsData, offsetof(LightsBlock, nrPointLights), sizeof(LightsBlock) - offsetof(LightsBlock, nrPointLights));
+        }
+    } else if (pointLightsCulled) {
+        // back to the fixed point lights
+        setPointLights(PointLights, lightsData);
+        if (!streamFrameData)
+            lightsBlock.update(lightsData);
+    } else if (!streamFrameData) {
+        lightsBlock.update(lightsData, flashLightOffset, flashLightBytes);
     }
+    // a streamed block is written whole: the region it goes to held some other frame's data
+    if (streamFrameData)
+        frameStream.bindUniformBlock(UniformBlocks::LIGHTS, lightsData);
+    pointLightsCulled = cullPointLights;
+
+    // re-assign the clustered lights to the froxels of this frame's view
+    if (clusteredLighting)
+        clustered.update(clusteredLights, cameraData.view, cameraData.projection);
+
+    // use the object shader specialized for this frame's lights
+    // uniforms are batched: setters only touch the shadow copy, commit() uploads what changed before each draw
+    const ShaderDefines& lightDefines = clusteredLighting
+        ? (flashLightOn ? clusteredOnDefines : clusteredOffDefines)
+        : cullPointLights
+        ? (flashLightOn ? culledOnDefines : culledOffDefines)
+        : (flashLightOn ? flashLightOnDefines : flashLightOffDefines);
+    ShaderDefines objectDefines = irradianceProbes ? withDefine(lightDefines, "IRRADIANCE_PROBES") : lightDefines;
+    ShaderDefines bakedDefines = flashLightOn ? bakedOnDefines : bakedOffDefines;
+    if (instancing) {
+        objectDefines = withDefine(objectDefines, "INSTANCED");
+        bakedDefines = withDefine(bakedDefines, "INSTANCED");
+    }
+    Shader& objectShader = objectShaders.get(objectDefines);
 
-    // update lamp shader
-    lampShader.use();
-
-    for (int lampIdx = 0; lampIdx < NR_POINT_LIGHTS; ++lampIdx) {
-        model = glm::mat4(1.0f);
-        model = glm::translate(model, PointLights[lampIdx].position);
-        model = glm::scale(model, glm::vec3(0.2f));
-
-        lampShader.setMat4("model", model);
-        lampShader.setMat4("view", view);
-        lampShader.setMat4("projection", projection);
-        lampShader.setVec3("lightColor", PointLights[lampIdx].baseColor);
+    // bind texture
+    GLState::bindTexture(0, GL_TEXTURE_2D, texture);
+    GLState::bindTexture(1, GL_TEXTURE_2D, specularTexture);
+    if (bakedLighting)
+        GLState::bindTexture(LIGHTMAP_UNIT, GL_TEXTURE_2D, lightmapTexture);
 
-        glBindVertexArray(lampVAO);
-        glDrawArrays(GL_TRIANGLES, 0, 36);
+    // draw object
+    double submitStart = glfwGetTime();
+
+    // baked: only the lightmap and the flashlight; otherwise the lights above and the shadow cascades.
+    // instanced: one draw from the group's vertex array; otherwise the model (and lightmap rectangle) per cube in
+    // view, recorded on the worker threads with K
+    auto drawCubes = [&](Shader& shader, const std::vector<InstanceData>& cubes, unsigned int instancedVAO, bool baked) {
+        shader.use();
+        shader.setBatched(true);
+
+        if (baked)
+            shader.setInt("lightmap", LIGHTMAP_UNIT);
+        else {
+            if (clusteredLighting)
+                clustered.bind(shader, framebufferWidth, framebufferHeight);
+            shadows.bind(shader, SHADOW_UNIT);
+            if (irradianceProbes)
+                probes.bind(shader, PROBE_UNIT);
+        }
+
+        // set object material properties (unchanged after the first frame, so never uploaded again)
+        shader.setInt("material.diffuse", 0);
+        shader.setInt("material.specular", 1);
+        shader.setFloat("material.shininess", 64.0f);
+
+        if (instancing) {
+            shader.commit();
+            GLState::bindVertexArray(instancedVAO);
+            glDrawArraysInstanced(GL_TRIANGLES, 0, 36, (GLsizei)cubes.size());
+            return;
+        }
+
+        if (parallelRecording) {
+            cubeRecorder.record(recordPool, cubes.size(), RECORD_CHUNK, [&](CommandList& list, std::size_t first, std::size_t last) {
+                list.useProgram(&shader);
+                list.bindVertexArray(objectVAO);
+                for (std::size_t i = first; i < last; i++) {
+                    if (!sphereInFrustum(frustum, glm::vec3(cubes[i].model[3]), CUBE_RADIUS))
+                        continue;
+                    list.setMat4("model", cubes[i].model);
+                    if (baked)
+                        list.setVec4("lightmapScaleOffset", cubes[i].data);
+                    list.drawArrays(GL_TRIANGLES, 0, 36);
+                }
+            });
+            cubeRecorder.execute();
+            return;
+        }
+
+        GLState::bindVertexArray(objectVAO);
+        for (const InstanceData& cube : cubes) {
+            if (!sphereInFrustum(frustum, glm::vec3(cube.model[3]), CUBE_RADIUS))
+                continue;
+            shader.setMat4("model", cube.model);
+            if (baked)
+                shader.setVec4("lightmapScaleOffset", cube.data.x, cube.data.y, cube.data.z, cube.data.w);
+            shader.commit();
+
+            glDrawArrays(GL_TRIANGLES, 0, 36);
+        }
+    };
+
+    if (bakedLighting)
+        drawCubes(objectShaders.get(bakedDefines), staticCubes, staticCubesVAO, true);
+    else
+        drawCubes(objectShader, staticCubes, staticCubesVAO, false);
+    drawCubes(objectShader, movingCubes, movingCubesVAO, false);
+    if (stressTest)
+        drawCubes(objectShader, stressCubes, stressCubesVAO, false);
+
+    // the point lights' lamps, plus small ones for the small lights (clustered, or culling candidates)
+    int nrLamps = clusteredLighting ? (int)clusteredLights.size() : cullPointLights ? NR_CULLING_CANDIDATES : NR_POINT_LIGHTS;
+    if (instancing) {
+        // the first nrLamps of lamps, already in lampInstances
+        lampInstancedShader.use();
+        GLState::bindVertexArray(lampVAO);
+        glDrawArraysInstanced(GL_TRIANGLES, 0, 36, nrLamps);
+    } else {
+        // update lamp shader
+        lampShader.use();
+        lampShader.setBatched(true);
+        GLState::bindVertexArray(lampVAO);
+
+        for (int lampIdx = 0; lampIdx < nrLamps; ++lampIdx) {
+            lampShader.setMat4("model", lamps[lampIdx].model);
+            lampShader.setVec3("lightColor", glm::vec3(lamps[lampIdx].data));
+            lampShader.commit();
+
+            glDrawArrays(GL_TRIANGLES, 0, 36);
+        }
     }
+    submitMilliseconds = static_cast<float>((glfwGetTime() - submitStart) * 1000.0);
 
-    // unbind vaos to prevent accidental state changes
-    glBindVertexArray(0);
+    // nothing after this reads the stream, so its region can be fenced
+    if (streamFrameData)
+        frameStream.endFrame();
 
     // glfw: swap buffers and poll IO events (keys pressed/released, mouse moved etc.)
     // -------------------------------------------------------------------------------
@@ -377,8 +861,23 @@ while (!glfwWindowShouldClose(window)) {
 // de-allocate all resources once they've outlived their purpose:
 // ------------------------------------------------------------------------
 glDeleteBuffers(1, &VBO);
+glDeleteBuffers(1, &lightmapVBO);
+glDeleteTextures(1, &lightmapTexture);
+probes.deleteBuffers();
 glDeleteVertexArrays(1, &objectVAO);
 glDeleteVertexArrays(1, &lampVAO);
+glDeleteVertexArrays(1, &staticCubesVAO);
+glDeleteVertexArrays(1, &movingCubesVAO);
+glDeleteVertexArrays(1, &stressCubesVAO);
+staticCubeInstances.deleteBuffers();
+movingCubeInstances.deleteBuffers();
+stressCubeInstances.deleteBuffers();
+lampInstances.deleteBuffers();
+glDeleteBuffers(1, &cameraBlock.UBO);
+glDeleteBuffers(1, &lightsBlock.UBO);
+frameStream.deleteBuffers();
+clustered.deleteBuffers();
+shadows.deleteBuffers();
 
 
 // glfw: terminate, clearing all previously allocated GLFW resources.
@@ -439,20 +938,51 @@ void key_callback(GLFWwindow* window, int key, int scancode, int action, int mod
     if (key == GLFW_KEY_F) {
         flashLightOn = !flashLightOn;
     }
+
+    if (key == GLFW_KEY_C) {
+        clusteredLighting = !clusteredLighting;
+    }
+
+    if (key == GLFW_KEY_L) {
+        lightCulling = !lightCulling;
+    }
+
+    if (key == GLFW_KEY_B) {
+        bakedLighting = !bakedLighting;
+    }
+
+    if (key == GLFW_KEY_P) {
+        irradianceProbes = !irradianceProbes;
+    }
+
+    if (key == GLFW_KEY_I) {
+        instancing = !instancing;
+    }
+
+    if (key == GLFW_KEY_M) {
+        stressTest = !stressTest;
+    }
+
+    if (key == GLFW_KEY_K) {
+        parallelRecording = !parallelRecording;
+    }
+
+    if (key == GLFW_KEY_U) {
+        streamFrameData = !streamFrameData;
+    }
 }
 
 unsigned int loadTexture(std::string texPath) {
     // read in texture image
-    int texWidth, texHeight, nChannels;
-    unsigned char* data = stbi_load(texPath.c_str(), &texWidth, &texHeight, &nChannels, 0);
+    DecodedImage image;
 
-    if (!data) {
+    if (!ImageDecoders::load(texPath, image)) {
         std::cout << "STBI_LOAD::ERROR: Unable to load texture" << std::endl;
         exit(1);
     }
 
     int format;
-    switch (nChannels) {
+    switch (image.nrComponents) {
         case 3: 
             format = GL_RGB;
         case 4: 
@@ -473,11 +1003,10 @@ unsigned int loadTexture(std::string texPath) {
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
 
     // load image
-    glTexImage2D(GL_TEXTURE_2D, 0, format, texWidth, texHeight, 0, format, GL_UNSIGNED_BYTE, data);
+    glTexImage2D(GL_TEXTURE_2D, 0, format, image.width, image.height, 0, format, GL_UNSIGNED_BYTE, image.pixels.get());
     glGenerateMipmap(GL_TEXTURE_2D);
 
     // clean-up
-    stbi_image_free(data);
     glBindTexture(GL_TEXTURE_2D, 0);
 
     return texture;
@@ -488,28 +1017,43 @@ float genRandFloat(float min, float max) {
     return min + (max - min) * rand() / RAND_MAX;
 }
 
-void setPointLights(const std::vector<PointLight>& PointLights, const Shader& shaderProgram, const int MAX_POINT_LIGHTS) {
-    // NOTE: this is super restrictive, but i can't imagine myself adding more than 10 point lights for the
-    //  scope of this project anyways
-    if (MAX_POINT_LIGHTS > 9) {
+void setDirectionalLight(const DirectionalLight& dirLight, LightsBlock& lights) {
+    lights.dirLight.direction = dirLight.direction;
+    lights.dirLight.ambient   = dirLight.phong.ambient;
+    lights.dirLight.diffuse   = dirLight.phong.diffuse;
+    lights.dirLight.specular  = dirLight.phong.specular;
+}
+
+void setPointLights(const std::vector<PointLight>& PointLights, LightsBlock& lights) {
+    if (PointLights.size() > UniformBlocks::MAX_POINT_LIGHTS) {
         logError("SETPOINTLIGHTS::ERROR::MAX_POINT_LIGHTS_EXCEEDED");
         exit(1);
     }
 
-    const int sz = (std::string("pointLights[n]")).size() + 1; // golly i love strings
-    char plChArr[sz];
     int idx = 0;
-
     for (const PointLight& pl : PointLights) {
-        snprintf(plChArr, sz, "pointLights[%d]", idx++);
-        const std::string plStr(plChArr);
-
-        shaderProgram.setVec3 (plStr + ".position" , pl.position);
-        shaderProgram.setVec3 (plStr + ".ambient"  , pl.phong.ambient);
-        shaderProgram.setVec3 (plStr + ".diffuse"  , pl.phong.diffuse);
-        shaderProgram.setVec3 (plStr + ".specular" , pl.phong.specular);
-        shaderProgram.setFloat(plStr + ".constant" , pl.attenuation.constant);
-        shaderProgram.setFloat(plStr + ".linear"   , pl.attenuation.linear);
-        shaderProgram.setFloat(plStr + ".quadratic", pl.attenuation.quadratic);
+        PointLightStd140& dst = lights.pointLights[idx++];
+
+        dst.position  = pl.position;
+        dst.ambient   = pl.phong.ambient;
+        dst.diffuse   = pl.phong.diffuse;
+        dst.specular  = pl.phong.specular;
+        dst.constant  = pl.attenuation.constant;
+        dst.linear    = pl.attenuation.linear;
+        dst.quadratic = pl.attenuation.quadratic;
     }
+    lights.nrPointLights = idx;
+}
+
+ClusteredPointLight toClusteredLight(const PointLight& pl) {
+    ClusteredPointLight light;
+    light.position  = pl.position;
+    light.ambient   = pl.phong.ambient;
+    light.diffuse   = pl.phong.diffuse;
+    light.specular  = pl.phong.specular;
+    light.constant  = pl.attenuation.constant;
+    light.linear    = pl.attenuation.linear;
+    light.quadratic = pl.attenuation.quadratic;
+    light.radius    = ClusteredLighting::attenuationRadius(light.constant, light.linear, light.quadratic, light.diffuse);
+    return light;
 }
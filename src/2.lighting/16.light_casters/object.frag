@@ -1,5 +1,19 @@
 #version 330 core
-#define NR_POINT_LIGHTS 4
+// NR_POINT_LIGHTS and FLASHLIGHT may be injected per permutation (see ShaderVariants). Without them the
+// shader falls back to the counts/toggles in the Lights block. CLUSTERED_LIGHTING replaces the Lights block's
+// point lights with the ones assigned to this fragment's cluster (see ClusteredLighting). LIGHTMAP replaces the
+// directional and point lights with their baked diffuse irradiance (see LightmapBaker); only the flashlight
+// stays dynamic. IRRADIANCE_PROBES replaces every light's constant ambient term with the light the probe grid
+// baked around this point (see IrradianceProbes).
+#include "../../shaders/camera.glsl"
+#include "../../shaders/lights.glsl"
+#include "../../shaders/shadows.glsl"
+#ifdef CLUSTERED_LIGHTING
+#include "../../shaders/clustered.glsl"
+#endif
+#ifdef IRRADIANCE_PROBES
+#include "../../shaders/probes.glsl"
+#endif
 
 out vec4 FragColor;
 
@@ -7,6 +21,11 @@ out vec4 FragColor;
 in vec3 FragPos;
 in vec3 Normal;
 in vec2 TexCoord;
+#ifdef LIGHTMAP
+in vec2 LightmapUV;
+
+uniform sampler2D lightmap;
+#endif
 
 // Structs
 struct Material {
@@ -15,81 +34,71 @@ struct Material {
     float shininess;
 };
 
-struct DirectionalLight {
-    vec3 direction;
-    vec3 ambient;
-    vec3 diffuse;
-    vec3 specular;
-};
-
-struct PointLight {
-    vec3 position;
-    vec3 ambient;
-    vec3 diffuse;
-    vec3 specular;
-    float constant;
-    float linear;
-    float quadratic;
-};
-
-struct SpotLight {
-    vec3 position;
-    vec3 direction;
-
-    vec3 diffuse;
-    vec3 specular;
-
-    float constant;
-    float linear;
-    float quadratic;
-
-    float innerAngle;
-    float outerAngle;
-};
-
 // Declarations
-vec3 CalcDirLight(DirectionalLight light, vec3 normal, vec3 viewDir);
+vec3 CalcDirLight(DirectionalLight light, vec3 normal, vec3 viewDir, float viewDepth);
 vec3 CalcPointLight(PointLight light, vec3 normal, vec3 viewDir);
 vec3 CalcSpotLight(SpotLight light, vec3 normal, vec3 viewDir);
 
-// View position
-uniform vec3 viewPos;
-
 // Material
 uniform Material material;
 
-// Lighting
-uniform DirectionalLight dirLight;
-uniform PointLight pointLights[NR_POINT_LIGHTS];
-uniform SpotLight flashLight; // attached to the player
-uniform bool flashLightOn = false;
-
 // ----- FRAGMENT SHADER MAIN ----- 
 void main() {
     // properties
     vec3 normal = normalize(Normal);
     vec3 viewDir = normalize(viewPos - FragPos);
+#ifdef LIGHTMAP
+    // phases 1 and 2: baked
+    vec3 result = texture(lightmap, LightmapUV).rgb * vec3(texture(material.diffuse, TexCoord));
+#else
+    float viewDepth = -(view * vec4(FragPos, 1.0)).z;
 
-    // phase 1: direction light 
-    vec3 result = CalcDirLight(dirLight, normal, viewDir);
+    // phase 1: direction light (shadowed)
+    vec3 result = CalcDirLight(dirLight, normal, viewDir, viewDepth);
 
     // phase 2: point lights
+#ifdef CLUSTERED_LIGHTING
+    // only the lights whose radius reaches this fragment's cluster
+    int cluster = clusterIndex(gl_FragCoord.xy, viewDepth);
+    uvec2 range = texelFetch(clusterRanges, cluster).xy;
+    for (uint i = 0u; i < range.y; ++i) {
+        float radius;
+        PointLight light = clusterLight(int(texelFetch(clusterIndices, int(range.x + i)).x), radius);
+        result += CalcPointLight(light, normal, viewDir) * clusterLightWindow(length(light.position - FragPos), radius);
+    }
+#else
+    // a constant count lets the compiler unroll the loop
+#ifdef NR_POINT_LIGHTS
     for (int plIdx = 0; plIdx < NR_POINT_LIGHTS; ++plIdx) {
+#else
+    for (int plIdx = 0; plIdx < nrPointLights; ++plIdx) {
+#endif
         result += CalcPointLight(pointLights[plIdx], normal, viewDir);
     }
+#endif
+#endif
 
     // TODO: phase 3: spot lights
+#if !defined(FLASHLIGHT)
     if (flashLightOn) {
         result += CalcSpotLight(flashLight, normal, viewDir);
     }
+#elif FLASHLIGHT
+    result += CalcSpotLight(flashLight, normal, viewDir);
+#endif
 
     FragColor = vec4(result, 1.0);
 } 
 
 // Function Definitions
-vec3 CalcDirLight(DirectionalLight light, vec3 normal, vec3 viewDir) {
+vec3 CalcDirLight(DirectionalLight light, vec3 normal, vec3 viewDir, float viewDepth) {
     // ambient 
+#ifdef IRRADIANCE_PROBES
+    // the probes stand in for every light's ambient term
+    vec3 ambient = probeIrradiance(FragPos, normal) * vec3(texture(material.diffuse, TexCoord));
+#else
     vec3 ambient = light.ambient * vec3(texture(material.diffuse, TexCoord));
+#endif
 
     // diffuse 
     vec3 lightDir = normalize(-light.direction);
@@ -102,12 +111,19 @@ vec3 CalcDirLight(DirectionalLight light, vec3 normal, vec3 viewDir) {
     vec3 specular = light.specular * spec * 
                         vec3(texture(material.specular, TexCoord));
 
-    return (ambient + diffuse + specular);
+    // shadow (ambient stays)
+    float shadow = directionalShadow(FragPos, normal, lightDir, viewDepth);
+
+    return (ambient + (diffuse + specular) * shadow);
 }
 
 vec3 CalcPointLight(PointLight light, vec3 normal, vec3 viewDir) {
     // ambient 
+#ifdef IRRADIANCE_PROBES
+    vec3 ambient = vec3(0.0); // in the probes
+#else
     vec3 ambient = light.ambient * vec3(texture(material.diffuse, TexCoord));
+#endif
 
     // diffuse 
     vec3 lightDir = normalize(light.position - FragPos);
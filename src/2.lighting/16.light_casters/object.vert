@@ -2,20 +2,45 @@
 layout (location = 0) in vec3 inFragPos;
 layout (location = 1) in vec3 inNormal;
 layout (location = 2) in vec2 inTexCoord;
+#ifdef LIGHTMAP
+layout (location = 3) in vec2 inLightmapUV;
+#endif
+#ifdef INSTANCED
+// per instance (see InstanceBuffer): the model matrix, and the lightmap rectangle
+layout (location = 4) in mat4 instanceModel;
+layout (location = 8) in vec4 instanceData;
+#endif
 
 out vec3 FragPos;
 out vec3 Normal;
 out vec2 TexCoord;
+#ifdef LIGHTMAP
+out vec2 LightmapUV;
 
+// this instance's rectangle in the atlas: xy scale, zw offset (see LightmapBaker); instanceData when INSTANCED
+#ifndef INSTANCED
+uniform vec4 lightmapScaleOffset;
+#endif
+#endif
+
+#include "../../shaders/camera.glsl"
+
+#ifndef INSTANCED
 uniform mat4 model;
-uniform mat4 view;
-uniform mat4 projection;
+#endif
 
 void main()
 {
+#ifdef INSTANCED
+    mat4 model = instanceModel;
+    vec4 lightmapScaleOffset = instanceData;
+#endif
     FragPos     = vec3(model * vec4(inFragPos, 1.0));
     Normal      = mat3(transpose(inverse(model))) * inNormal;
     TexCoord    = inTexCoord;
+#ifdef LIGHTMAP
+    LightmapUV  = inLightmapUV * lightmapScaleOffset.xy + lightmapScaleOffset.zw;
+#endif
 
-    gl_Position = projection * view * vec4(FragPos, 1.0);
+    gl_Position = viewProjection * vec4(FragPos, 1.0);
 }
@@ -0,0 +1,6 @@
+#version 330 core
+// depth only; the cascade's depth attachment is all that gets written
+
+void main()
+{
+}
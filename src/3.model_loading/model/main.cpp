@@ -6,13 +6,18 @@
 #include "glm/gtc/type_ptr.hpp"
 
 #include "learnopengl/camera.h"
+#include "learnopengl/gl_extensions.h"
+#include "learnopengl/indirect_draws.h"
+#include "learnopengl/light_culling.h"
 #include "learnopengl/model.h"
 
 #include <iostream>
+#include <memory>
 
 void framebuffer_size_callback(GLFWwindow* window, int width, int height);
 void mouse_callback(GLFWwindow* window, double xpos, double ypos);
 void scroll_callback(GLFWwindow* window, double xoffset, double yoffset);
+void key_callback(GLFWwindow* window, int key, int scancode, int action, int mods);
 void processInput(GLFWwindow *window);
 
 // settings
@@ -31,6 +36,15 @@ bool firstMouse = true;
 float deltaTime = 0.0f;
 float lastFrame = 0.0f;
 
+// a grid of backpacks, so there are enough draws for their submission to cost something. every SPIN_EVERY-th
+// one spins (its model matrix changes every frame); the others only change when they go in or out of view
+const int GRID_SIZE = 16;
+const float GRID_SPACING = 4.0f;
+const int SPIN_EVERY = 8;
+
+// I: the whole grid in one indirect pass per mesh (IndirectDrawBuffer), or a model uniform and Model::Draw per copy
+bool indirectDraws = true;
+
 int main()
 {
     // glfw: initialize and configure
@@ -57,6 +71,7 @@ int main()
     glfwSetFramebufferSizeCallback(window, framebuffer_size_callback);
     glfwSetCursorPosCallback(window, mouse_callback);
     glfwSetScrollCallback(window, scroll_callback);
+    glfwSetKeyCallback(window, key_callback);
 
     // tell GLFW to capture our mouse
     glfwSetInputMode(window, GLFW_CURSOR, GLFW_CURSOR_DISABLED);
@@ -68,9 +83,11 @@ int main()
         std::cout << "Failed to initialize GLAD" << std::endl;
         return -1;
     }
+    // optional entry points beyond core 3.3 (program binaries, ...)
+    GLExtensions::load((GLADloadproc)glfwGetProcAddress);
 
-    // tell stb_image.h to flip loaded texture's on the y-axis (before loading model).
-    stbi_set_flip_vertically_on_load(true);
+    // tell the image decoders to flip loaded texture's on the y-axis (before loading model).
+    ImageDecoders::setFlipVerticallyOnLoad(true);
 
     // configure global opengl state
     // -----------------------------
@@ -79,11 +96,35 @@ int main()
     // build and compile shaders
     // -------------------------
     Shader ourShader((shaderPath + "object.vert").c_str(), (shaderPath + "object.frag").c_str());
+    // the same shader reading its model matrix from the indirect passes' per-draw data
+    ShaderDefines indirectDefines = IndirectDrawBuffer::shaderDefines();
+    indirectDefines.push_back({ "INDIRECT", "" });
+    Shader indirectShader((shaderPath + "object.vert").c_str(), (shaderPath + "object.frag").c_str(), indirectDefines);
 
     // load models
     // -----------
     Model ourModel((modelPath + "backpack/backpack.obj"));
 
+    // the backpack's meshes in one vertex array, and a pass per mesh (each has its own textures) holding a draw
+    // per copy: draw i of every pass is copy i
+    MergedMeshes mergedModel(ourModel.meshes);
+    const unsigned int DRAW_DATA_UNIT = 8; // past the meshes' own textures
+    std::vector<std::unique_ptr<IndirectDrawBuffer>> passes;
+    for (std::size_t mesh = 0; mesh < mergedModel.size(); mesh++)
+        passes.push_back(std::make_unique<IndirectDrawBuffer>(mergedModel.VAO, DRAW_DATA_UNIT));
+
+    std::vector<glm::vec3> copies;
+    for (int row = 0; row < GRID_SIZE; row++)
+        for (int column = 0; column < GRID_SIZE; column++)
+            copies.push_back(glm::vec3((column - GRID_SIZE / 2) * GRID_SPACING, 0.0f, -row * GRID_SPACING));
+    for (std::size_t copy = 0; copy < copies.size(); copy++)
+        for (std::size_t mesh = 0; mesh < passes.size(); mesh++)
+            passes[mesh]->add(mergedModel.range(mesh), glm::translate(glm::mat4(1.0f), copies[copy]));
+
+    // CPU time spent submitting the grid, for the title
+    float submitMilliseconds = 0.0f;
+    float lastTitleUpdate = 0.0f;
+
     // draw in wireframe
     //glPolygonMode(GL_FRONT_AND_BACK, GL_LINE);
 
@@ -115,12 +156,60 @@ int main()
         ourShader.setMat4("projection", projection);
         ourShader.setMat4("view", view);
 
-        // render the loaded model
-        glm::mat4 model = glm::mat4(1.0f);
-        model = glm::translate(model, glm::vec3(0.0f, 0.0f, 0.0f)); // translate it down so it's at the center of the scene
-        model = glm::scale(model, glm::vec3(1.0f, 1.0f, 1.0f));	// it's a bit too big for our scene, so scale it down
-        ourShader.setMat4("model", model);
-        ourModel.Draw(ourShader);
+        // render the loaded model, once per copy in view
+        float submitStart = static_cast<float>(glfwGetTime());
+        glm::vec4 frustum[6];
+        frustumPlanes(projection * view, frustum);
+        for (std::size_t copy = 0; copy < copies.size(); copy++) {
+            glm::mat4 model = glm::translate(glm::mat4(1.0f), copies[copy]);
+            if (copy % SPIN_EVERY == 0)
+                model = glm::rotate(model, currentFrame, glm::vec3(0.0f, 1.0f, 0.0f));
+            bool visible = sphereInFrustum(frustum, copies[copy], mergedModel.boundingRadius());
+
+            if (indirectDraws) {
+                // only what differs from last frame ends up patched in upload()
+                for (std::unique_ptr<IndirectDrawBuffer>& pass : passes) {
+                    pass->setModel(copy, model);
+                    pass->setVisible(copy, visible);
+                }
+            } else if (visible) {
+                ourShader.setMat4("model", model);
+                ourModel.Draw(ourShader);
+            }
+        }
+
+        // the indirect passes: one upload and one draw each, however many copies
+        std::size_t drawCalls = 0, patchedCommands = 0, patchedModels = 0, bufferUpdates = 0;
+        if (indirectDraws) {
+            indirectShader.use();
+            indirectShader.setMat4("projection", projection);
+            indirectShader.setMat4("view", view);
+            for (std::size_t mesh = 0; mesh < passes.size(); mesh++) {
+                passes[mesh]->upload();
+                ourModel.meshes[mesh].bindTextures(indirectShader);
+                passes[mesh]->draw(indirectShader);
+
+                const IndirectDrawBuffer::Stats& stats = passes[mesh]->stats();
+                drawCalls += stats.drawCalls;
+                patchedCommands += stats.patchedCommands;
+                patchedModels += stats.patchedModels;
+                bufferUpdates += stats.bufferUpdates;
+            }
+        }
+        submitMilliseconds = (static_cast<float>(glfwGetTime()) - submitStart) * 1000.0f;
+
+        if (currentFrame - lastTitleUpdate >= 0.5f) {
+            lastTitleUpdate = currentFrame;
+            std::string title = "LearnOpenGL | " + std::to_string(copies.size()) + " backpacks";
+            if (indirectDraws)
+                title += std::string(" | ") + (GLExtensions::support().multiDrawIndirect ? "multi-draw indirect" : "indirect, drawn one by one")
+                    + ": " + std::to_string(drawCalls) + " draw calls, patched " + std::to_string(patchedCommands) + " commands and "
+                    + std::to_string(patchedModels) + " matrices in " + std::to_string(bufferUpdates) + " updates";
+            else
+                title += " | one draw per mesh and copy";
+            title += " | submit " + std::to_string(submitMilliseconds) + " ms";
+            glfwSetWindowTitle(window, title.c_str());
+        }
 
 
         // glfw: swap buffers and poll IO events (keys pressed/released, mouse moved etc.)
@@ -129,6 +218,10 @@ int main()
         glfwPollEvents();
     }
 
+    for (std::unique_ptr<IndirectDrawBuffer>& pass : passes)
+        pass->deleteBuffers();
+    mergedModel.deleteBuffers();
+
     // glfw: terminate, clearing all previously allocated GLFW resources.
     // ------------------------------------------------------------------
     glfwTerminate();
@@ -152,6 +245,12 @@ void processInput(GLFWwindow *window)
         camera.ProcessKeyboard(RIGHT, deltaTime);
 }
 
+void key_callback(GLFWwindow* window, int key, int scancode, int action, int mods)
+{
+    if (action == GLFW_PRESS && key == GLFW_KEY_I)
+        indirectDraws = !indirectDraws;
+}
+
 // glfw: whenever the window size changed (by OS or user resize) this callback function executes
 // ---------------------------------------------------------------------------------------------
 void framebuffer_size_callback(GLFWwindow* window, int width, int height)
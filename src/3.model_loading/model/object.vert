@@ -1,16 +1,24 @@
 #version 330 core
+#ifdef INDIRECT
+#include "../../shaders/indirect_draws.glsl"
+#endif
 layout (location = 0) in vec3 aPos;
 layout (location = 1) in vec3 aNormal;
 layout (location = 2) in vec2 aTexCoords;
 
 out vec2 TexCoords;
 
+#ifndef INDIRECT
 uniform mat4 model;
+#endif
 uniform mat4 view;
 uniform mat4 projection;
 
 void main()
 {
+#ifdef INDIRECT
+    mat4 model = drawModel();
+#endif
     TexCoords = aTexCoords;    
     gl_Position = projection * view * model * vec4(aPos, 1.0);
 }
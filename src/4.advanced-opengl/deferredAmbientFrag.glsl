@@ -0,0 +1,16 @@
+#version 330 core
+// deferred lighting, first pass: ambient term for every covered pixel (drawn with screenVert.glsl)
+out vec4 FragColor;
+
+uniform sampler2D gAlbedoSpecular;
+uniform sampler2D gDepth;
+uniform vec3 ambient;
+
+void main()
+{
+    ivec2 pixel = ivec2(gl_FragCoord.xy);
+    if (texelFetch(gDepth, pixel, 0).r == 1.0)
+        discard; // background keeps the clear color
+
+    FragColor = vec4(ambient * texelFetch(gAlbedoSpecular, pixel, 0).rgb, 1.0);
+}
@@ -0,0 +1,25 @@
+#version 330 core
+// shades the G-buffer pixels under one light volume; the results of all volumes are added up
+out vec4 FragColor;
+
+flat in vec4 LightPositionRadius;
+flat in vec3 LightColor;
+
+#include "../shaders/camera.glsl"
+#include "../shaders/frame.glsl"
+#include "../shaders/gbuffer.glsl"
+#include "../shaders/point_light.glsl"
+
+uniform sampler2D gAlbedoSpecular;
+uniform sampler2D gNormal;
+uniform sampler2D gDepth;
+
+void main()
+{
+    ivec2 pixel = ivec2(gl_FragCoord.xy);
+    vec3 position = viewPositionFromDepth(gl_FragCoord.xy / resolution, texelFetch(gDepth, pixel, 0).r);
+    vec3 normal = decodeNormal(texelFetch(gNormal, pixel, 0).rg);
+    vec4 albedoSpecular = texelFetch(gAlbedoSpecular, pixel, 0);
+
+    FragColor = vec4(shadePointLight(position, normal, albedoSpecular.rgb, albedoSpecular.a, LightPositionRadius, LightColor), 1.0);
+}
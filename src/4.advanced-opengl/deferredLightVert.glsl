@@ -0,0 +1,17 @@
+#version 330 core
+// deferred lighting, second pass: one sphere per light, scaled to its radius (see LightVolumes)
+layout (location = 0) in vec3 aPos;
+layout (location = 1) in vec4 aLightPositionRadius; // view space
+layout (location = 2) in vec4 aLightColor;
+
+flat out vec4 LightPositionRadius;
+flat out vec3 LightColor;
+
+#include "../shaders/camera.glsl"
+
+void main()
+{
+    LightPositionRadius = aLightPositionRadius;
+    LightColor = aLightColor.rgb;
+    gl_Position = projection * vec4(aLightPositionRadius.xyz + aPos * aLightPositionRadius.w, 1.0);
+}
@@ -0,0 +1,22 @@
+#version 330 core
+// deferred geometry pass: material attributes only, lighting happens in deferredLightFrag.glsl
+layout (location = 0) out vec4 gAlbedoSpecular;
+layout (location = 1) out vec2 gNormal;
+
+in vec2 TexCoords;
+in vec3 ViewPos;
+
+#include "../shaders/camera.glsl"
+#include "../shaders/gbuffer.glsl"
+
+uniform sampler2D texture1;
+uniform float specularStrength;
+
+void main()
+{
+    // the chapter's meshes carry no normals; flat ones from the screen-space derivatives suit cubes and planes
+    vec3 normal = normalize(cross(dFdx(ViewPos), dFdy(ViewPos)));
+
+    gAlbedoSpecular = vec4(texture(texture1, TexCoords).rgb, specularStrength);
+    gNormal = encodeNormal(normal);
+}
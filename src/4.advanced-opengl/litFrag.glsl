@@ -0,0 +1,25 @@
+#version 330 core
+// forward shading: every light is evaluated for every fragment, including the ones later drawn over
+out vec4 FragColor;
+
+in vec2 TexCoords;
+in vec3 ViewPos;
+
+#include "../shaders/point_light.glsl"
+
+uniform sampler2D texture1;
+uniform float specularStrength;
+uniform samplerBuffer lights; // two texels per light: view-space position + radius, color
+uniform int nrLights;
+uniform vec3 ambient;
+
+void main()
+{
+    vec3 normal = normalize(cross(dFdx(ViewPos), dFdy(ViewPos)));
+    vec3 albedo = texture(texture1, TexCoords).rgb;
+
+    vec3 color = ambient * albedo;
+    for (int i = 0; i < nrLights; ++i)
+        color += shadePointLight(ViewPos, normal, albedo, specularStrength, texelFetch(lights, 2 * i), texelFetch(lights, 2 * i + 1).rgb);
+    FragColor = vec4(color, 1.0);
+}
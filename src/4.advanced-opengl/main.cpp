@@ -6,18 +6,30 @@
 #include <glm/gtc/matrix_transform.hpp>
 #include <glm/gtc/type_ptr.hpp>
 
+#include <learnopengl/gbuffer.h>
+#include <learnopengl/gl_extensions.h>
+#include <learnopengl/gl_state.h>
+#include <learnopengl/gpu_timer.h>
+#include <learnopengl/light_volumes.h>
+#include <learnopengl/render_queue.h>
 #include <learnopengl/shader.h>
+#include <learnopengl/transparent_sorter.h>
 #include <learnopengl/camera.h>
+#include <learnopengl/frame_pipeline.h>
 #include <learnopengl/model.h>
+#include <learnopengl/occlusion_culler.h>
+#include <learnopengl/image_decoder.h>
+#include <learnopengl/uniform_blocks.h>
+#include <learnopengl/weighted_oit.h>
 
 #include <iostream>
 #include <filesystem>
-#include <map>
 
 void framebuffer_size_callback(GLFWwindow* window, int width, int height);
 void mouse_callback(GLFWwindow* window, double xpos, double ypos);
 void scroll_callback(GLFWwindow* window, double xoffset, double yoffset);
 void processInput(GLFWwindow *window);
+void key_callback(GLFWwindow* window, int key, int scancode, int action, int mods);
 unsigned int loadTexture(char const *path, bool cull_transparent);
 
 // settings
@@ -34,6 +46,36 @@ bool firstMouse = true;
 float deltaTime = 0.0f;
 float lastFrame = 0.0f;
 
+// lighting: R switches between forward and deferred shading, O adds a stack of cubes drawn back to front
+bool deferredShading = true;
+bool overdraw = false;
+
+// Q replays the opaque draws in submission order instead of sorted by state and front to back
+bool sortedQueue = true;
+
+// T blends the windows with weighted blended order-independent transparency instead of sorting them; G adds a
+// field of crossed windows (two through the same spot at right angles), which no per-window order blends right
+bool orderIndependent = false;
+bool windowField = false;
+
+// P simulates the scene (the orbiting lights) on the render thread each frame instead of a frame ahead on a worker
+bool pipelinedSimulation = true;
+
+// C skips the cubes hidden behind the occluders (the marble cubes and the overdraw stack) rasterized on the CPU
+bool occlusionCulling = true;
+
+const unsigned int NR_LIGHTS = 256;
+const unsigned int NR_OVERDRAW_CUBES = 32;
+const unsigned int NR_CROSSED_WINDOWS = 5000;
+const glm::vec3 AMBIENT(0.08f);
+
+struct OrbitingLight {
+    glm::vec3 position; // at time 0; circles the y axis
+    glm::vec3 color;
+    float radius;
+    float speed;        // radians per second
+};
+
 int main() {
     // glfw: initialize and configure
     // ------------------------------
@@ -58,6 +100,7 @@ int main() {
     glfwSetFramebufferSizeCallback(window, framebuffer_size_callback);
     glfwSetCursorPosCallback(window, mouse_callback);
     glfwSetScrollCallback(window, scroll_callback);
+    glfwSetKeyCallback(window, key_callback);
 
     // tell GLFW to capture our mouse
     glfwSetInputMode(window, GLFW_CURSOR, GLFW_CURSOR_DISABLED);
@@ -68,6 +111,8 @@ int main() {
         std::cout << "Failed to initialize GLAD" << std::endl;
         return -1;
     }
+    // optional entry points beyond core 3.3 (program binaries, ...)
+    GLExtensions::load((GLADloadproc)glfwGetProcAddress);
 
     // global states
     glEnable(GL_DEPTH_TEST);
@@ -81,9 +126,29 @@ int main() {
     // build and compile shaders
     // -------------------------
     std::string shaderPath = std::string(std::filesystem::current_path()) + "/../src/4.advanced-opengl/";
-    Shader shader((shaderPath + "vert.glsl").c_str(), (shaderPath + "frag.glsl").c_str());
-    Shader borderShader((shaderPath + "vert.glsl").c_str(), (shaderPath + "borderFrag.glsl").c_str());
-    Shader screenShader((shaderPath + "screenVert.glsl").c_str(), (shaderPath + "screenFrag.glsl").c_str());
+    // submitted without waiting: the driver compiles them while the geometry and textures below load, and each
+    // one is finished (errors reported) by its first use()
+    Shader shader((shaderPath + "vert.glsl").c_str(), (shaderPath + "frag.glsl").c_str(), ShaderDefines(), Shader::COMPILE_ASYNC);
+    Shader borderShader((shaderPath + "vert.glsl").c_str(), (shaderPath + "borderFrag.glsl").c_str(), ShaderDefines(), Shader::COMPILE_ASYNC);
+    Shader screenShader((shaderPath + "screenVert.glsl").c_str(), (shaderPath + "screenFrag.glsl").c_str(), ShaderDefines(), Shader::COMPILE_ASYNC);
+    // lit opaque geometry: forward, or deferred (G-buffer, then ambient + light volume passes)
+    Shader litShader((shaderPath + "vert.glsl").c_str(), (shaderPath + "litFrag.glsl").c_str(), ShaderDefines(), Shader::COMPILE_ASYNC);
+    Shader gBufferShader((shaderPath + "vert.glsl").c_str(), (shaderPath + "gBufferFrag.glsl").c_str(), ShaderDefines(), Shader::COMPILE_ASYNC);
+    Shader ambientShader((shaderPath + "screenVert.glsl").c_str(), (shaderPath + "deferredAmbientFrag.glsl").c_str(), ShaderDefines(), Shader::COMPILE_ASYNC);
+    Shader lightShader((shaderPath + "deferredLightVert.glsl").c_str(), (shaderPath + "deferredLightFrag.glsl").c_str(), ShaderDefines(), Shader::COMPILE_ASYNC);
+    // windows with weighted blended OIT: accumulated in any order, then composited over the scene
+    Shader oitShader((shaderPath + "vert.glsl").c_str(), (shaderPath + "oitFrag.glsl").c_str(), ShaderDefines(), Shader::COMPILE_ASYNC);
+    Shader compositeShader((shaderPath + "screenVert.glsl").c_str(), (shaderPath + "oitCompositeFrag.glsl").c_str(), ShaderDefines(), Shader::COMPILE_ASYNC);
+    // edit the glsl files while the app runs; changes are recompiled at the start of the next frame
+    shader.enableHotReload();
+    borderShader.enableHotReload();
+    screenShader.enableHotReload();
+    litShader.enableHotReload();
+    gBufferShader.enableHotReload();
+    ambientShader.enableHotReload();
+    lightShader.enableHotReload();
+    oitShader.enableHotReload();
+    compositeShader.enableHotReload();
 
     // set up vertex data (and buffer(s)) and configure vertex attributes
     // ------------------------------------------------------------------
@@ -221,6 +286,19 @@ int main() {
     vegetation.push_back(glm::vec3(-0.3f,  0.0f, -2.3f));
     vegetation.push_back(glm::vec3( 0.5f,  0.0f, -0.6f));
 
+    // WINDOWS: the ones above, then (G) a field of crossed pairs behind the scene; the two of a pair cut through
+    // each other, so each covers the other in part whichever of them is drawn first
+    std::vector<glm::mat4> windows;
+    for (const glm::vec3& position : vegetation)
+        windows.push_back(glm::translate(glm::mat4(1.0f), position));
+    for (unsigned int i = 0; i < NR_CROSSED_WINDOWS; i++) {
+        glm::vec3 position(-25.0f + 50.0f * rand() / RAND_MAX, 0.0f, -4.0f - 45.0f * rand() / RAND_MAX);
+        // the quad spans x 0..1, so both turn about its middle
+        glm::mat4 center = glm::translate(glm::mat4(1.0f), position + glm::vec3(0.5f, 0.0f, 0.0f));
+        windows.push_back(glm::translate(center, glm::vec3(-0.5f, 0.0f, 0.0f)));
+        windows.push_back(glm::translate(glm::rotate(center, glm::radians(90.0f), glm::vec3(0.0f, 1.0f, 0.0f)), glm::vec3(-0.5f, 0.0f, 0.0f)));
+    }
+
     // FRAMEBUFFER OBJECT
     unsigned int framebuffer;
     glGenFramebuffers(1, &framebuffer);
@@ -247,6 +325,57 @@ int main() {
     }
     glBindFramebuffer(GL_FRAMEBUFFER, 0); // unbind to prevent accidentally rendering to the wrong framebuffer
 
+    // OIT targets (attachments 1 and 2 of the framebuffer above; only drawn to while the windows accumulate)
+    WeightedBlendedOIT oit(framebuffer, SCR_WIDTH*2, SCR_HEIGHT*2);
+
+    // G-BUFFER (same size as the framebuffer above, whose depth/stencil format it shares)
+    GBuffer gBuffer(SCR_WIDTH*2, SCR_HEIGHT*2);
+
+    // POINT LIGHTS
+    // scattered over the floor, circling the y axis; uploaded in view space every frame for both renderers
+    std::vector<OrbitingLight> orbitingLights;
+    for (unsigned int i = 0; i < NR_LIGHTS; i++) {
+        OrbitingLight light;
+        light.position = glm::vec3(-5.0f + 10.0f * rand() / RAND_MAX, -0.4f + 1.5f * rand() / RAND_MAX, -5.0f + 10.0f * rand() / RAND_MAX);
+        light.color = glm::vec3(rand(), rand(), rand()) / (float)RAND_MAX;
+        light.radius = 1.0f + 1.5f * rand() / RAND_MAX;
+        light.speed = 0.2f + 0.6f * rand() / RAND_MAX;
+        orbitingLights.push_back(light);
+    }
+    std::vector<ViewSpacePointLight> viewSpaceLights(NR_LIGHTS);
+
+    // the scene as simulated for one frame: the lights' world-space positions. the pipeline works on the next
+    // frame's copy while this frame's is submitted, and the camera stays out of it (latched at submission)
+    struct SceneSnapshot {
+        std::vector<glm::vec3> lightPositions;
+    };
+    FramePipeline<SceneSnapshot> pipeline([&](SceneSnapshot& scene, double time) {
+        scene.lightPositions.resize(NR_LIGHTS);
+        for (unsigned int i = 0; i < NR_LIGHTS; i++) {
+            const OrbitingLight& light = orbitingLights[i];
+            glm::mat4 orbit = glm::rotate(glm::mat4(1.0f), (float)time * light.speed, glm::vec3(0.0f, 1.0f, 0.0f));
+            scene.lightPositions[i] = glm::vec3(orbit * glm::vec4(light.position, 1.0f));
+        }
+    });
+    LightVolumes lightVolumes(NR_LIGHTS);
+
+    // GPU time of the opaque scene + lighting, shown in the title to compare the renderers
+    GpuTimer sceneTimer;
+
+    // opaque draws are queued each frame and sorted by program, material and vertex array, then front to back
+    RenderQueue opaqueQueue;
+    opaqueQueue.setDepthRange(0.1f, 100.0f);
+
+    // cubes are tested against a small CPU depth buffer of the big ones before they're queued
+    OcclusionCuller occlusionCuller;
+
+    // the windows, drawn back to front after the opaque scene (or unsorted with OIT); CPU sort and GPU window
+    // pass times are shown in the title to compare the two
+    TransparentSorter windowSorter;
+    windowSorter.reserve(windows.size());
+    GpuTimer windowTimer;
+    float windowSortMilliseconds = 0.0f;
+
 
     // load textures
     // -------------
@@ -257,6 +386,14 @@ int main() {
     unsigned int grassTexture = loadTexture((texturePath + "/../resources/textures/blending_transparent_window.png").c_str(), true);
     unsigned int containerTexture = loadTexture((texturePath + "/../resources/textures/container.jpg").c_str(), false);
 
+    // materials of the opaque draws, indexed by RenderQueue::Item::material
+    struct Material {
+        unsigned int texture;
+        float specularStrength;
+    };
+    enum { FLOOR_MATERIAL, MARBLE_MATERIAL, CONTAINER_MATERIAL };
+    const Material materials[] = { { floorTexture, 1.0f }, { cubeTexture, 0.3f }, { containerTexture, 0.3f } };
+
     // shader configuration
     // --------------------
     shader.use();
@@ -265,6 +402,21 @@ int main() {
     screenShader.use();
     screenShader.setInt("screenTexture", 0);
 
+    oitShader.use();
+    oitShader.setInt("texture1", 0);
+
+    compositeShader.use();
+    compositeShader.setInt("accumulation", 1);
+    compositeShader.setInt("weights", 2);
+
+    // per-frame uniform blocks, shared by every program through fixed binding points
+    // ------------------------------------------------------------------------------
+    UniformBuffer<CameraBlock> cameraBlock(UniformBlocks::CAMERA);
+    UniformBuffer<FrameBlock> frameBlock(UniformBlocks::FRAME);
+
+
+    // everything above talked to GL directly; from here on state changes go through GLState
+    GLState::invalidate();
 
     // render loop
     // -----------
@@ -275,129 +427,270 @@ int main() {
         deltaTime = currentFrame - lastFrame;
         lastFrame = currentFrame;
 
-        // input
-        // -----
-        processInput(window);
+        // this frame's scene (simulated a frame ago when pipelined); the next one starts on the worker now
+        pipeline.setPipelined(pipelinedSimulation);
+        const SceneSnapshot& scene = pipeline.beginFrame(currentFrame, currentFrame + deltaTime);
+
+        // state cache / uniform shadow counters for the previous frame, shown in the title once a second
+        // ----------------------------------------------------------------------------------
+        GLState::beginFrame();
+        if (static_cast<int>(currentFrame) != static_cast<int>(currentFrame - deltaTime)) {
+            const GLState::Stats& stats = GLState::lastFrame();
+            std::string title = "LearnOpenGL | GL state calls: " + std::to_string(stats.issued) + " issued, " + std::to_string(stats.skipped) + " skipped"
+                + " | uniforms: " + std::to_string(stats.uniformUploads) + " uploaded, " + std::to_string(stats.uniformSkips) + " unchanged"
+                + " | " + (deferredShading ? "deferred" : "forward") + (overdraw ? " + overdraw" : "") + ": "
+                + std::to_string(sceneTimer.milliseconds()) + " ms GPU"
+                + " | queue (" + (sortedQueue ? "sorted" : "unsorted") + "): " + std::to_string(opaqueQueue.stats().items) + " draws, "
+                + std::to_string(opaqueQueue.stats().programChanges) + " programs, " + std::to_string(opaqueQueue.stats().vertexArrayChanges)
+                + " VAOs, " + std::to_string(opaqueQueue.stats().textureChanges) + " textures"
+                + " | occlusion culling" + (occlusionCulling ? ": " + std::to_string(occlusionCuller.stats().occluded) + " of "
+                    + std::to_string(occlusionCuller.stats().tested) + " cubes culled, " + std::to_string(occlusionCuller.stats().rasterizedTriangles)
+                    + " occluder triangles" : std::string(" off"))
+                + " | windows (" + (orderIndependent ? "weighted blended" : "sorted") + "): "
+                + std::to_string(windowField ? windows.size() : vegetation.size()) + ", "
+                + (orderIndependent ? std::string() : std::to_string(windowSortMilliseconds) + " ms sort, ")
+                + std::to_string(windowTimer.milliseconds()) + " ms GPU";
+            FramePipeline<SceneSnapshot>::Timings timings = pipeline.averages();
+            title += std::string(" | simulation (") + (pipelinedSimulation ? "pipelined" : "inline") + "): "
+                + std::to_string(timings.simulate) + " ms, " + std::to_string(timings.wait) + " ms waited"
+                + " | frame " + std::to_string(timings.frame) + " ms, input to present " + std::to_string(timings.latency) + " ms";
+            glfwSetWindowTitle(window, title.c_str());
+        }
+
+        // shader hot-reload (a reloaded program starts with default uniform values, so redo the one-off setup)
+        // -----------------------------------------------------------------------------------------------------
+        if (shader.reloadIfChanged()) {
+            shader.use();
+            shader.setInt("texture1", 0);
+        }
+        borderShader.reloadIfChanged();
+        if (screenShader.reloadIfChanged()) {
+            screenShader.use();
+            screenShader.setInt("screenTexture", 0);
+        }
+        if (oitShader.reloadIfChanged()) {
+            oitShader.use();
+            oitShader.setInt("texture1", 0);
+        }
+        if (compositeShader.reloadIfChanged()) {
+            compositeShader.use();
+            compositeShader.setInt("accumulation", 1);
+            compositeShader.setInt("weights", 2);
+        }
+        // these set all their uniforms every frame (unchanged ones are skipped), so a reload needs nothing else
+        litShader.reloadIfChanged();
+        gBufferShader.reloadIfChanged();
+        ambientShader.reloadIfChanged();
+        lightShader.reloadIfChanged();
 
         // render
         // ------
-        // render to a framebuffer 
-        glBindFramebuffer(GL_FRAMEBUFFER, framebuffer);
-        glEnable(GL_DEPTH_TEST);
+        // everything up to the screen quad renders offscreen at the framebuffer's size
+        glViewport(0, 0, SCR_WIDTH*2, SCR_HEIGHT*2);
         glClearColor(0.1f, 0.1f, 0.1f, 1.0f);
-        glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT | GL_STENCIL_BUFFER_BIT);
-
-        //glStencilOp(GL_KEEP, GL_KEEP, GL_REPLACE); // ensures all fragments pass the stencil test
-
-        // set uniforms
-        glm::mat4 model;
-        glm::mat4 view = camera.GetViewMatrix();
-        glm::mat4 projection = glm::perspective(glm::radians(camera.Zoom), (float)SCR_WIDTH / (float)SCR_HEIGHT, 0.1f, 100.0f);
-
-        borderShader.use();
-        borderShader.setMat4("view", view);
-        borderShader.setMat4("projection", projection);
-
-        shader.use();
-        shader.setMat4("view", view);
-        shader.setMat4("projection", projection);
-
-        // floor
-        //glStencilMask(0x00);
-        glDisable(GL_CULL_FACE);
-        glBindVertexArray(planeVAO);
-        glBindTexture(GL_TEXTURE_2D, floorTexture);
-        model = glm::mat4(1.0f);
-        shader.setMat4("model", model);
-        glDrawArrays(GL_TRIANGLES, 0, 6);
 
-        // vegetation
-        //glBindVertexArray(vegetationVAO);
-        //glBindTexture(GL_TEXTURE_2D, grassTexture);
-        //for (unsigned int i = 0; i < vegetation.size(); i++) {
-        //    model = glm::mat4(1.0f);
-        //    model = glm::translate(model, vegetation[i]);
-        //    shader.setMat4("model", model);
-        //    glDrawArrays(GL_TRIANGLES, 0, 6);
-        //}
-        //
-
-        // cubes
-        //glStencilFunc(GL_ALWAYS, 1, 0xFF); // enable writing to stencil buffer
-        //glStencilMask(0xFF);
-
-        glEnable(GL_CULL_FACE);
-        glBindVertexArray(cubeVAO);
-        glActiveTexture(GL_TEXTURE0);
-        glBindTexture(GL_TEXTURE_2D, cubeTexture);
-        model = glm::mat4(1.0f);
-        model = glm::translate(model, glm::vec3(-1.0f, 0.0f, -1.0f));
-        shader.setMat4("model", model);
-        glDrawArrays(GL_TRIANGLES, 0, 36); // first cube
-        model = glm::mat4(1.0f);
-        model = glm::translate(model, glm::vec3(2.0f, 0.0f, 0.0f));
-        shader.setMat4("model", model);
-        glDrawArrays(GL_TRIANGLES, 0, 36); // second cube
-
-        // scaled-cubes (FOR STENCIL OUTLINING)
-        //glStencilFunc(GL_NOTEQUAL, 1, 0xFF); // draw parts of the container outside of the previously drawn cube
-        //glStencilMask(0x00); // disable writing to stencil buffer
-        //glDisable(GL_DEPTH_TEST);
-
-        //borderShader.use();
-        //glBindVertexArray(cubeVAO);
-        //glActiveTexture(GL_TEXTURE0);
-        //glBindTexture(GL_TEXTURE_2D, cubeTexture);
-        //model = glm::mat4(1.0f);
-        //model = glm::translate(model, glm::vec3(-1.0f, 0.0f, -1.0f));
-        //model = glm::scale(model, glm::vec3(1.1f));
-        //borderShader.setMat4("model", model);
-        //glDrawArrays(GL_TRIANGLES, 0, 36); // first cube
-        //model = glm::mat4(1.0f);
-        //model = glm::translate(model, glm::vec3(2.0f, 0.0f, 0.0f));
-        //model = glm::scale(model, glm::vec3(1.1f));
-        //borderShader.setMat4("model", model);
-        //glDrawArrays(GL_TRIANGLES, 0, 36); // second cube
-        //glBindVertexArray(0);
-
-        //glStencilMask(0xFF);
-        //glStencilFunc(GL_ALWAYS, 0, 0xFF);
-        //glEnable(GL_DEPTH_TEST);
-
-        // draw windows
-        glDisable(GL_CULL_FACE);
-        // ensures that background windows are rendered
-        std::map<float, glm::vec3> sortedWindows;
-        for (unsigned int i = 0; i < vegetation.size(); i++) {
-            float distance = glm::length(camera.Position - vegetation[i]);
-            sortedWindows[distance] = vegetation[i];
+        // input, as late as possible: the camera is latched from it right before the frame is submitted
+        // -----------------------------------------------------------------------------------------------
+        glfwPollEvents();
+        processInput(window);
+
+        // set uniforms: view/projection go out once for every program
+        CameraBlock cameraData;
+        cameraData.view = camera.GetViewMatrix();
+        cameraData.projection = glm::perspective(glm::radians(camera.Zoom), (float)SCR_WIDTH / (float)SCR_HEIGHT, 0.1f, 100.0f);
+        cameraData.viewProjection = cameraData.projection * cameraData.view;
+        cameraData.viewPos = camera.Position;
+        cameraBlock.update(cameraData);
+        pipeline.latch();
+
+        FrameBlock frameData;
+        frameData.resolution = glm::vec2(SCR_WIDTH * 2, SCR_HEIGHT * 2); // the offscreen framebuffer
+        frameData.time = currentFrame;
+        frameData.deltaTime = deltaTime;
+        frameBlock.update(frameData);
+
+        // upload the lights in view space (one buffer write serves both renderers)
+        for (unsigned int i = 0; i < NR_LIGHTS; i++) {
+            const OrbitingLight& light = orbitingLights[i];
+            viewSpaceLights[i].position = glm::vec3(cameraData.view * glm::vec4(scene.lightPositions[i], 1.0f));
+            viewSpaceLights[i].radius = light.radius;
+            viewSpaceLights[i].color = light.color;
+        }
+        lightVolumes.update(viewSpaceLights);
+
+        // the overdraw stack, far to near
+        auto overdrawCube = [](unsigned int i) {
+            glm::mat4 model = glm::mat4(1.0f);
+            model = glm::translate(model, glm::vec3(0.5f, 0.5f, -4.0f - 0.25f * (NR_OVERDRAW_CUBES - 1 - i)));
+            return glm::scale(model, glm::vec3(3.0f, 2.0f, 0.1f));
+        };
+
+        // occluders: the cubes themselves (each hides the ones behind it, none hides itself)
+        if (occlusionCulling) {
+            occlusionCuller.begin(cameraData.viewProjection);
+            occlusionCuller.addBoxOccluder(glm::translate(glm::mat4(1.0f), glm::vec3(-1.0f, 0.0f, -1.0f)));
+            occlusionCuller.addBoxOccluder(glm::translate(glm::mat4(1.0f), glm::vec3(2.0f, 0.0f, 0.0f)));
+            if (overdraw)
+                for (unsigned int i = 0; i < NR_OVERDRAW_CUBES; i++)
+                    occlusionCuller.addBoxOccluder(overdrawCube(i));
+            occlusionCuller.rasterize();
         }
-        glBindVertexArray(vegetationVAO);
-        glBindTexture(GL_TEXTURE_2D, grassTexture);
-        for (std::map<float, glm::vec3>::reverse_iterator it = sortedWindows.rbegin(); it != sortedWindows.rend(); it++) {
-            model = glm::mat4(1.0f);
-            model = glm::translate(model, it->second);
-            shader.setMat4("model", model);
+
+        // floor and cubes (plus the overdraw stack), drawn with whichever program the renderer uses
+        auto drawOpaque = [&](Shader& opaqueShader) {
+            opaqueShader.setInt("texture1", 0);
+            opaqueQueue.clear();
+
+            auto submit = [&](unsigned int vertexArray, int material, bool cullFace, const glm::mat4& transform, GLsizei count) {
+                // only the cubes have the unit box as their bounds
+                if (occlusionCulling && vertexArray == cubeVAO && occlusionCuller.isBoxOccluded(transform))
+                    return;
+                RenderQueue::Item item;
+                item.shader = &opaqueShader;
+                item.vertexArray = vertexArray;
+                item.textures[0] = materials[material].texture;
+                item.material = material;
+                item.cullFace = cullFace;
+                item.count = count;
+                opaqueQueue.submit(item, transform, 0, false, -(cameraData.view * transform[3]).z);
+            };
+
+            // floor
+            submit(planeVAO, FLOOR_MATERIAL, false, glm::mat4(1.0f), 6);
+
+            // cubes
+            submit(cubeVAO, MARBLE_MATERIAL, true, glm::translate(glm::mat4(1.0f), glm::vec3(-1.0f, 0.0f, -1.0f)), 36);
+            submit(cubeVAO, MARBLE_MATERIAL, true, glm::translate(glm::mat4(1.0f), glm::vec3(2.0f, 0.0f, 0.0f)), 36);
+
+            // submitted far to near: unsorted, every layer passes the depth test and gets shaded; sorted, early-Z
+            // rejects all but the nearest. with occlusion culling, the layers behind the first few never get queued
+            if (overdraw) {
+                for (unsigned int i = 0; i < NR_OVERDRAW_CUBES; i++)
+                    submit(cubeVAO, CONTAINER_MATERIAL, true, overdrawCube(i), 36);
+            }
+
+            if (sortedQueue)
+                opaqueQueue.sort();
+            opaqueQueue.execute([&](Shader& shader, const RenderQueue::Item& item) {
+                shader.setFloat("specularStrength", materials[item.material].specularStrength);
+            });
+        };
+
+        sceneTimer.begin();
+        if (deferredShading) {
+            // geometry pass: albedo/specular and normals into the G-buffer, no lighting
+            GLState::bindFramebuffer(GL_FRAMEBUFFER, gBuffer.FBO);
+            GLState::enable(GL_DEPTH_TEST);
+            GLState::disable(GL_BLEND);
+            glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT | GL_STENCIL_BUFFER_BIT);
+            gBufferShader.use();
+            drawOpaque(gBufferShader);
+
+            // lighting passes go to the framebuffer, which gets the scene depth so the windows below sort against it
+            gBuffer.blitDepthTo(framebuffer);
+            glClear(GL_COLOR_BUFFER_BIT);
+            gBuffer.bindTextures(0);
+
+            // ambient for every covered pixel
+            GLState::disable(GL_DEPTH_TEST);
+            ambientShader.use();
+            ambientShader.setInt("gAlbedoSpecular", 0);
+            ambientShader.setInt("gDepth", 2);
+            ambientShader.setVec3("ambient", AMBIENT);
+            GLState::bindVertexArray(quadVAO);
+            glDrawArrays(GL_TRIANGLES, 0, 6);
+
+            // light volumes: back faces behind the surface mark the pixels inside a light's sphere (also works with
+            // the camera inside it); each one's light is added on top
+            GLState::enable(GL_DEPTH_TEST);
+            GLState::enable(GL_CULL_FACE);
+            GLState::enable(GL_BLEND);
+            glDepthFunc(GL_GEQUAL);
+            glDepthMask(GL_FALSE);
+            glCullFace(GL_FRONT);
+            glBlendFunc(GL_ONE, GL_ONE);
+            lightShader.use();
+            lightShader.setInt("gAlbedoSpecular", 0);
+            lightShader.setInt("gNormal", 1);
+            lightShader.setInt("gDepth", 2);
+            lightVolumes.draw();
+            glDepthFunc(GL_LESS);
+            glDepthMask(GL_TRUE);
+            glCullFace(GL_BACK);
+            glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+        } else {
+            // render to a framebuffer, every light shaded for every fragment
+            GLState::bindFramebuffer(GL_FRAMEBUFFER, framebuffer);
+            GLState::enable(GL_DEPTH_TEST);
+            glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT | GL_STENCIL_BUFFER_BIT);
+            litShader.use();
+            litShader.setInt("lights", 1);
+            litShader.setInt("nrLights", (int)lightVolumes.size());
+            litShader.setVec3("ambient", AMBIENT);
+            lightVolumes.bindBuffer(1);
+            drawOpaque(litShader);
+        }
+        sceneTimer.end();
+
+        // windows stay unlit and forward rendered in both modes
+        std::size_t nrWindows = windowField ? windows.size() : vegetation.size();
+        GLState::disable(GL_CULL_FACE);
+        GLState::bindVertexArray(vegetationVAO);
+        GLState::bindTexture(0, GL_TEXTURE_2D, grassTexture);
+        windowTimer.begin();
+        if (orderIndependent) {
+            // accumulated in whatever order, then the weighted average is blended over the scene
+            oit.begin();
+            oitShader.use();
+            for (std::size_t i = 0; i < nrWindows; i++) {
+                oitShader.setMat4("model", windows[i]);
+                glDrawArrays(GL_TRIANGLES, 0, 6);
+            }
+            oit.end();
+
+            GLState::disable(GL_DEPTH_TEST);
+            compositeShader.use();
+            oit.bindTextures(1);
+            GLState::bindVertexArray(quadVAO);
             glDrawArrays(GL_TRIANGLES, 0, 6);
+        } else {
+            // farthest first, so the windows behind show through the ones in front
+            double sortStart = glfwGetTime();
+            windowSorter.clear();
+            for (std::size_t i = 0; i < nrWindows; i++)
+                windowSorter.add((std::uint32_t)i, glm::length(camera.Position - glm::vec3(windows[i][3])));
+            windowSorter.sort();
+            windowSortMilliseconds = static_cast<float>((glfwGetTime() - sortStart) * 1000.0);
+
+            shader.use();
+            GLState::enable(GL_BLEND);
+            for (const SortPair& sorted : windowSorter.order()) {
+                shader.setMat4("model", windows[sorted.value]);
+                glDrawArrays(GL_TRIANGLES, 0, 6);
+            }
         }
+        windowTimer.end();
 
         // swap back to default framebuffer and draw a quad with the framebuffer texture
-        glBindFramebuffer(GL_FRAMEBUFFER, 0);
-        glDisable(GL_DEPTH_TEST); // prevents quad from being disabled due to depth testing
+        GLState::bindFramebuffer(GL_FRAMEBUFFER, 0);
+        int windowWidth, windowHeight;
+        glfwGetFramebufferSize(window, &windowWidth, &windowHeight);
+        glViewport(0, 0, windowWidth, windowHeight);
+        GLState::disable(GL_DEPTH_TEST); // prevents quad from being disabled due to depth testing
         // clear relevant buffers
         glClear(GL_COLOR_BUFFER_BIT);
 
         // render the quad
         screenShader.use();
-        glBindVertexArray(quadVAO);
-        glBindTexture(GL_TEXTURE_2D, textureColorbuffer);
+        GLState::bindVertexArray(quadVAO);
+        GLState::bindTexture(0, GL_TEXTURE_2D, textureColorbuffer);
         glDrawArrays(GL_TRIANGLES, 0, 6);
 
 
-        // glfw: swap buffers and poll IO events (keys pressed/released, mouse moved etc.)
-        // -------------------------------------------------------------------------------
+        // glfw: swap buffers (IO events are polled at the latch above)
+        // -------------------------------------------------------------
         glfwSwapBuffers(window);
-        glfwPollEvents();
+        pipeline.endFrame();
     }
 
     // optional: de-allocate all resources once they've outlived their purpose:
@@ -407,6 +700,13 @@ int main() {
     glDeleteBuffers(1, &cubeVBO);
     glDeleteBuffers(1, &planeVBO);
     glDeleteFramebuffers(1, &framebuffer);
+    glDeleteBuffers(1, &cameraBlock.UBO);
+    glDeleteBuffers(1, &frameBlock.UBO);
+    gBuffer.deleteBuffers();
+    lightVolumes.deleteBuffers();
+    sceneTimer.deleteQueries();
+    windowTimer.deleteQueries();
+    oit.deleteBuffers();
 
     glfwTerminate();
     return 0;
@@ -429,6 +729,27 @@ void processInput(GLFWwindow *window)
         camera.ProcessKeyboard(RIGHT, deltaTime);
 }
 
+void key_callback(GLFWwindow* window, int key, int scancode, int action, int mods)
+{
+    if (action != GLFW_PRESS)
+        return;
+
+    if (key == GLFW_KEY_R)
+        deferredShading = !deferredShading;
+    if (key == GLFW_KEY_O)
+        overdraw = !overdraw;
+    if (key == GLFW_KEY_Q)
+        sortedQueue = !sortedQueue;
+    if (key == GLFW_KEY_T)
+        orderIndependent = !orderIndependent;
+    if (key == GLFW_KEY_G)
+        windowField = !windowField;
+    if (key == GLFW_KEY_P)
+        pipelinedSimulation = !pipelinedSimulation;
+    if (key == GLFW_KEY_C)
+        occlusionCulling = !occlusionCulling;
+}
+
 // glfw: whenever the window size changed (by OS or user resize) this callback function executes
 // ---------------------------------------------------------------------------------------------
 void framebuffer_size_callback(GLFWwindow* window, int width, int height)
@@ -474,20 +795,19 @@ unsigned int loadTexture(char const *path, bool cull_transparent) {
     unsigned int textureID;
     glGenTextures(1, &textureID);
 
-    int width, height, nrComponents;
-    unsigned char *data = stbi_load(path, &width, &height, &nrComponents, 0);
-    if (data)
+    DecodedImage image;
+    if (ImageDecoders::load(path, image))
     {
         GLenum format;
-        if (nrComponents == 1)
+        if (image.nrComponents == 1)
             format = GL_RED;
-        else if (nrComponents == 3)
+        else if (image.nrComponents == 3)
             format = GL_RGB;
-        else if (nrComponents == 4)
+        else if (image.nrComponents == 4)
             format = GL_RGBA;
 
         glBindTexture(GL_TEXTURE_2D, textureID);
-        glTexImage2D(GL_TEXTURE_2D, 0, format, width, height, 0, format, GL_UNSIGNED_BYTE, data);
+        glTexImage2D(GL_TEXTURE_2D, 0, format, image.width, image.height, 0, format, GL_UNSIGNED_BYTE, image.pixels.get());
         glGenerateMipmap(GL_TEXTURE_2D);
 
         if (cull_transparent) {
@@ -499,13 +819,10 @@ unsigned int loadTexture(char const *path, bool cull_transparent) {
         }
         glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
         glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-
-        stbi_image_free(data);
     }
     else
     {
         std::cout << "Texture failed to load at path: " << path << std::endl;
-        stbi_image_free(data);
     }
 
     return textureID;
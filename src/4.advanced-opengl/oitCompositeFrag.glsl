@@ -0,0 +1,19 @@
+#version 330 core
+// resolves weighted blended OIT over the opaque scene: the weighted average color, covering 1 - revealage of it
+out vec4 FragColor;
+
+uniform sampler2D accumulation;
+uniform sampler2D weights;
+
+void main()
+{
+    ivec2 pixel = ivec2(gl_FragCoord.xy);
+    vec4 accumulated = texelFetch(accumulation, pixel, 0);
+    float revealage = accumulated.a;
+    // nothing transparent here
+    if (revealage == 1.0)
+        discard;
+
+    vec3 average = accumulated.rgb / max(texelFetch(weights, pixel, 0).r, 1.0e-5);
+    FragColor = vec4(average, 1.0 - revealage);
+}
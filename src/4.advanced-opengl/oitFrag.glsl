@@ -0,0 +1,13 @@
+#version 330 core
+// the windows for weighted blended OIT: frag.glsl's texture lookup, accumulated instead of blended
+
+in vec2 TexCoords;
+
+uniform sampler2D texture1;
+
+#include "../shaders/oit.glsl"
+
+void main()
+{
+    writeTransparent(texture(texture1, TexCoords));
+}
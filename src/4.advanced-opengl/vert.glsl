@@ -3,13 +3,15 @@ layout (location = 0) in vec3 aPos;
 layout (location = 1) in vec2 aTexCoords;
 
 out vec2 TexCoords;
+out vec3 ViewPos;
+
+#include "../shaders/camera.glsl"
 
 uniform mat4 model;
-uniform mat4 view;
-uniform mat4 projection;
 
 void main()
 {
     TexCoords = aTexCoords;    
-    gl_Position = projection * view * model * vec4(aPos, 1.0);
+    ViewPos = vec3(view * model * vec4(aPos, 1.0));
+    gl_Position = viewProjection * model * vec4(aPos, 1.0);
 }
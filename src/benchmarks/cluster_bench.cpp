@@ -0,0 +1,88 @@
+// Clustered light assignment benchmark (CPU only, no GL context needed).
+//
+// usage: cluster_bench [iterations]
+//
+// Scatters point lights through the view frustum of a 45 degree, 16:9, 0.1-100 camera and times
+// LightClusters::assign() for several light counts, single- vs multithreaded and scalar vs SSE2 kernel.
+// Every configuration has to produce the same light/cluster pairs as the single-threaded scalar one.
+#include "learnopengl/light_clusters.h"
+
+#include <glm/glm.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <memory>
+#include <random>
+#include <thread>
+#include <vector>
+
+const int LIGHT_COUNTS[] = { 1000, 10000, 50000 };
+
+// view-space spheres spread evenly over the frustum's volume between depth 1 and 90
+std::vector<glm::vec4> makeLights(int count, const glm::mat4& projection) {
+    std::mt19937 rng(1234);
+    std::uniform_real_distribution<float> unit(0.0f, 1.0f);
+    std::vector<glm::vec4> lights(count);
+    for (glm::vec4& light : lights) {
+        float depth = 1.0f + 89.0f * std::cbrt(unit(rng));
+        float x = (unit(rng) * 2.0f - 1.0f) * depth / projection[0][0];
+        float y = (unit(rng) * 2.0f - 1.0f) * depth / projection[1][1];
+        light = glm::vec4(x, y, -depth, 0.5f + 2.5f * unit(rng));
+    }
+    return lights;
+}
+
+int main(int argc, char** argv) {
+    int iterations = argc > 1 ? std::max(1, std::atoi(argv[1])) : 20;
+    unsigned int nrThreads = std::max(1u, std::thread::hardware_concurrency());
+    glm::mat4 projection = glm::perspective(glm::radians(45.0f), 16.0f / 9.0f, 0.1f, 100.0f);
+
+#ifdef LIGHT_CLUSTERS_SSE
+    const bool haveSimd = true;
+#else
+    const bool haveSimd = false;
+#endif
+    std::printf("%dx%dx%d clusters, %d iterations, SSE2 %s, %u hardware threads\n\n", LightClusters::TILES_X, LightClusters::TILES_Y,
+                LightClusters::SLICES, iterations, haveSimd ? "available" : "not available", nrThreads);
+    std::printf("%-8s %-8s %-8s %10s %14s\n", "lights", "threads", "kernel", "ms", "assignments");
+
+    std::unique_ptr<LightClusters> serial(new LightClusters(1));
+    std::unique_ptr<LightClusters> parallel(new LightClusters(nrThreads));
+    serial->setProjection(projection);
+    parallel->setProjection(projection);
+
+    bool mismatch = false;
+    for (int count : LIGHT_COUNTS) {
+        std::vector<glm::vec4> lights = makeLights(count, projection);
+
+        serial->useSimd = false;
+        serial->assign(lights);
+        const std::vector<unsigned int> reference = serial->indices();
+
+        for (LightClusters* clusters : { serial.get(), parallel.get() }) {
+            for (int simd = 0; simd <= (haveSimd ? 1 : 0); simd++) {
+                clusters->useSimd = simd != 0;
+                clusters->assign(lights); // warm up
+
+                auto start = std::chrono::steady_clock::now();
+                for (int i = 0; i < iterations; i++)
+                    clusters->assign(lights);
+                double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count() / iterations;
+
+                if (clusters->indices() != reference)
+                    mismatch = true;
+                std::printf("%-8d %-8u %-8s %10.3f %14zu\n", count, clusters->nrThreads(), simd ? "sse2" : "scalar", ms,
+                            clusters->indices().size());
+            }
+        }
+    }
+
+    if (mismatch) {
+        std::printf("\nERROR: configurations disagree on the light assignment\n");
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,101 @@
+// Command list recording benchmark (CPU only, no GL context needed).
+//
+// usage: command_list_bench [iterations]
+//
+// Frustum culls 1M cubes and records a model matrix and a draw for each visible one, like the light casters
+// chapter does with K, on 1, 2, 4, ... threads up to the machine's core count. The merged lists have to come out
+// the same whatever the thread count: same commands in the same order, same uniform values. Nothing is replayed,
+// so the program pointer recorded is never used.
+#include "learnopengl/command_list.h"
+#include "learnopengl/light_culling.h"
+
+#include <glm/gtc/matrix_transform.hpp>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <thread>
+#include <vector>
+
+const int NR_CUBES = 1000000;
+const std::size_t RECORD_CHUNK = 4096;
+
+bool sameCommands(const CommandList& a, const CommandList& b) {
+    if (a.size() != b.size())
+        return false;
+    for (std::size_t i = 0; i < a.size(); i++) {
+        const CommandList::Command& x = a.commands()[i];
+        const CommandList::Command& y = b.commands()[i];
+        if (x.type != y.type)
+            return false;
+        if (x.type == CommandList::SET_MAT4 && (x.uniform.name != y.uniform.name || !std::equal(a.values(x), a.values(x) + 16, b.values(y))))
+            return false;
+        if (x.type == CommandList::DRAW_ARRAYS && (x.draw.count != y.draw.count || x.draw.first != y.draw.first))
+            return false;
+    }
+    return true;
+}
+
+int main(int argc, char** argv) {
+    int iterations = argc > 1 ? std::max(1, std::atoi(argv[1])) : 20;
+
+    std::mt19937 rng(1234);
+    std::uniform_real_distribution<float> spread(-200.0f, 200.0f);
+    std::vector<glm::mat4> cubes(NR_CUBES);
+    for (glm::mat4& cube : cubes)
+        cube = glm::translate(glm::mat4(1.0f), glm::vec3(spread(rng), spread(rng), spread(rng)));
+
+    glm::mat4 view = glm::lookAt(glm::vec3(0.0f), glm::vec3(0.0f, 0.0f, -1.0f), glm::vec3(0.0f, 1.0f, 0.0f));
+    glm::mat4 projection = glm::perspective(glm::radians(45.0f), 1.5f, 0.1f, 400.0f);
+    glm::vec4 frustum[6];
+    frustumPlanes(projection * view, frustum);
+
+    auto recordChunk = [&](CommandList& list, std::size_t first, std::size_t last) {
+        list.useProgram(nullptr);
+        list.bindVertexArray(1);
+        for (std::size_t i = first; i < last; i++) {
+            if (!sphereInFrustum(frustum, glm::vec3(cubes[i][3]), 0.87f))
+                continue;
+            list.setMat4("model", cubes[i]);
+            list.drawArrays(GL_TRIANGLES, 0, 36);
+        }
+    };
+
+    unsigned int maxThreads = std::max(1u, std::thread::hardware_concurrency());
+    std::printf("%d cubes, %d iterations, %u hardware threads\n\n", NR_CUBES, iterations, maxThreads);
+    std::printf("%-8s %12s %12s %14s\n", "threads", "record ms", "commands", "Mcubes/s");
+
+    CommandList reference, merged;
+    bool mismatch = false;
+    for (unsigned int threads = 1; ; threads = std::min(threads * 2, maxThreads)) {
+        ThreadPool pool(threads);
+        CommandRecorder recorder;
+        recorder.record(pool, cubes.size(), RECORD_CHUNK, recordChunk); // warm up, grows the lists
+
+        double recordMs = 0.0;
+        for (int i = 0; i < iterations; i++) {
+            auto start = std::chrono::steady_clock::now();
+            recorder.record(pool, cubes.size(), RECORD_CHUNK, recordChunk);
+            recordMs += std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+        }
+        recordMs /= iterations;
+
+        recorder.merge(merged);
+        if (threads == 1)
+            reference = merged;
+        else if (!sameCommands(reference, merged))
+            mismatch = true;
+        std::printf("%-8u %12.3f %12zu %14.1f\n", threads, recordMs, merged.size(), NR_CUBES / recordMs / 1000.0);
+
+        if (threads == maxThreads)
+            break;
+    }
+
+    if (mismatch) {
+        std::printf("\nERROR: the merged lists depend on the thread count\n");
+        return 1;
+    }
+    return 0;
+}
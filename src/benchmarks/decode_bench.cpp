@@ -0,0 +1,229 @@
+// Decode throughput benchmark for the image decoder backends.
+//
+// usage: decode_bench [textures dir] [iterations]
+//
+// Decodes every image in the textures directory plus a few synthetic 8K images with each backend that
+// accepts the format and reports throughput in MB/s of encoded input and megapixels/s of output.
+// JPEGs that carry restart markers are also decoded in parallel strips (see JpegRestart).
+#include "learnopengl/image_decoder.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <filesystem>
+#include <map>
+#include <string>
+#include <vector>
+
+struct BenchInput {
+    std::string name;
+    std::vector<unsigned char> bytes;
+};
+
+struct Throughput {
+    double encodedBytes = 0.0;
+    double pixels = 0.0;
+    double seconds = 0.0;
+};
+
+const int SYNTHETIC_WIDTH  = 7680;
+const int SYNTHETIC_HEIGHT = 4320;
+
+// smooth gradients plus some hash noise so the encoders can't collapse the image to nothing
+std::vector<unsigned char> makeSyntheticPixels(int width, int height) {
+    std::vector<unsigned char> pixels(static_cast<std::size_t>(width) * height * 3);
+    for (int y = 0; y < height; y++) {
+        for (int x = 0; x < width; x++) {
+            unsigned int noise = (x * 73856093u) ^ (y * 19349663u);
+            unsigned char* p = &pixels[(static_cast<std::size_t>(y) * width + x) * 3];
+            p[0] = static_cast<unsigned char>((x * 255) / width);
+            p[1] = static_cast<unsigned char>((y * 255) / height);
+            p[2] = static_cast<unsigned char>(((x + y) & 0xFF) ^ (noise & 0x1F));
+        }
+    }
+    return pixels;
+}
+
+// 24-bit bottom-up BMP; always available since it needs no encoder library
+std::vector<unsigned char> encodeBmp(const std::vector<unsigned char>& rgb, int width, int height) {
+    const std::size_t stride = (static_cast<std::size_t>(width) * 3 + 3) & ~static_cast<std::size_t>(3);
+    const std::size_t fileSize = 54 + stride * height;
+    std::vector<unsigned char> bmp(fileSize, 0);
+    auto put32 = [&](std::size_t offset, unsigned int value) {
+        for (int i = 0; i < 4; i++)
+            bmp[offset + i] = static_cast<unsigned char>(value >> (8 * i));
+    };
+    bmp[0] = 'B';
+    bmp[1] = 'M';
+    put32(2, static_cast<unsigned int>(fileSize));
+    put32(10, 54);
+    put32(14, 40);
+    put32(18, static_cast<unsigned int>(width));
+    put32(22, static_cast<unsigned int>(height));
+    bmp[26] = 1;
+    bmp[28] = 24;
+    for (int y = 0; y < height; y++) {
+        const unsigned char* src = &rgb[static_cast<std::size_t>(height - 1 - y) * width * 3];
+        unsigned char* dst = &bmp[54 + y * stride];
+        for (int x = 0; x < width; x++) {
+            dst[x * 3 + 0] = src[x * 3 + 2];
+            dst[x * 3 + 1] = src[x * 3 + 1];
+            dst[x * 3 + 2] = src[x * 3 + 0];
+        }
+    }
+    return bmp;
+}
+
+#ifdef LEARNOPENGL_WITH_LIBJPEG
+// baseline JPEG with a restart marker after every MCU row so the parallel path has something to split
+std::vector<unsigned char> encodeJpeg(const std::vector<unsigned char>& rgb, int width, int height) {
+    jpeg_compress_struct cinfo;
+    jpeg_error_mgr jerr;
+    cinfo.err = jpeg_std_error(&jerr);
+    jpeg_create_compress(&cinfo);
+
+    unsigned char* out = nullptr;
+    unsigned long outSize = 0;
+    jpeg_mem_dest(&cinfo, &out, &outSize);
+    cinfo.image_width = width;
+    cinfo.image_height = height;
+    cinfo.input_components = 3;
+    cinfo.in_color_space = JCS_RGB;
+    jpeg_set_defaults(&cinfo);
+    jpeg_set_quality(&cinfo, 90, TRUE);
+    cinfo.restart_in_rows = 1;
+    jpeg_start_compress(&cinfo, TRUE);
+    while (cinfo.next_scanline < cinfo.image_height) {
+        JSAMPROW row = const_cast<unsigned char*>(&rgb[static_cast<std::size_t>(cinfo.next_scanline) * width * 3]);
+        jpeg_write_scanlines(&cinfo, &row, 1);
+    }
+    jpeg_finish_compress(&cinfo);
+    jpeg_destroy_compress(&cinfo);
+
+    std::vector<unsigned char> jpeg(out, out + outSize);
+    std::free(out);
+    return jpeg;
+}
+#endif
+
+#ifdef LEARNOPENGL_WITH_LIBPNG
+std::vector<unsigned char> encodePng(const std::vector<unsigned char>& rgb, int width, int height) {
+    png_image png;
+    std::memset(&png, 0, sizeof(png));
+    png.version = PNG_IMAGE_VERSION;
+    png.width = width;
+    png.height = height;
+    png.format = PNG_FORMAT_RGB;
+
+    png_alloc_size_t size = 0;
+    png_image_write_to_memory(&png, nullptr, &size, 0, rgb.data(), 0, nullptr);
+    std::vector<unsigned char> encoded(size);
+    if (!png_image_write_to_memory(&png, encoded.data(), &size, 0, rgb.data(), 0, nullptr))
+        encoded.clear();
+    encoded.resize(size);
+    return encoded;
+}
+#endif
+
+const char* formatName(const std::string& name) {
+    std::string ext = std::filesystem::path(name).extension().string();
+    if (ext == ".jpg" || ext == ".jpeg")
+        return "jpeg";
+    if (ext == ".png")
+        return "png";
+    if (ext == ".bmp")
+        return "bmp";
+    return "other";
+}
+
+template <typename DecodeFn>
+bool measure(const BenchInput& input, int iterations, DecodeFn decode, Throughput& total, double& mbPerSec) {
+    DecodedImage image;
+    if (!decode(input, image)) // warm-up, and skip anything this backend rejects
+        return false;
+
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < iterations; i++) {
+        DecodedImage iterationImage;
+        decode(input, iterationImage);
+    }
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    total.encodedBytes += static_cast<double>(input.bytes.size()) * iterations;
+    total.pixels += static_cast<double>(image.width) * image.height * iterations;
+    total.seconds += seconds;
+    mbPerSec = input.bytes.size() * iterations / seconds / (1024.0 * 1024.0);
+    return true;
+}
+
+int main(int argc, char** argv) {
+    const std::string texturesDir = (argc > 1) ? argv[1] : "../resources/textures";
+    const int iterations = (argc > 2) ? std::max(1, std::atoi(argv[2])) : 5;
+    const unsigned int nrThreads = ImageDecoders::settings().nrThreads;
+
+    // gather inputs
+    std::vector<BenchInput> inputs;
+    std::error_code ec;
+    for (const auto& entry : std::filesystem::directory_iterator(texturesDir, ec)) {
+        BenchInput input;
+        input.name = entry.path().filename().string();
+        if (ImageDecoders::readFile(entry.path().string(), input.bytes))
+            inputs.push_back(std::move(input));
+    }
+    if (ec)
+        std::printf("warning: could not read %s (%s)\n", texturesDir.c_str(), ec.message().c_str());
+
+    std::vector<unsigned char> synthetic = makeSyntheticPixels(SYNTHETIC_WIDTH, SYNTHETIC_HEIGHT);
+    inputs.push_back({ "synthetic_8k.bmp", encodeBmp(synthetic, SYNTHETIC_WIDTH, SYNTHETIC_HEIGHT) });
+#ifdef LEARNOPENGL_WITH_LIBJPEG
+    inputs.push_back({ "synthetic_8k.jpg", encodeJpeg(synthetic, SYNTHETIC_WIDTH, SYNTHETIC_HEIGHT) });
+#endif
+#ifdef LEARNOPENGL_WITH_LIBPNG
+    inputs.push_back({ "synthetic_8k.png", encodePng(synthetic, SYNTHETIC_WIDTH, SYNTHETIC_HEIGHT) });
+#endif
+
+    std::printf("%d iterations per image, %u threads for parallel JPEG\n\n", iterations, nrThreads);
+    std::printf("%-36s %-12s %-10s %10s\n", "image", "backend", "mode", "MB/s");
+
+    // per (format, backend, mode) totals
+    std::map<std::string, Throughput> totals;
+    for (const BenchInput& input : inputs) {
+        const char* format = formatName(input.name);
+        for (const std::unique_ptr<ImageDecoder>& decoder : ImageDecoders::registry()) {
+            if (!decoder->canDecode(detectImageFormat(input.bytes.data(), input.bytes.size())))
+                continue;
+
+            double mbPerSec = 0.0;
+            std::string key = std::string(format) + " " + decoder->name();
+            bool ok = measure(input, iterations, [&](const BenchInput& in, DecodedImage& image) {
+                return decoder->decode(in.bytes.data(), in.bytes.size(), image);
+            }, totals[key + " serial"], mbPerSec);
+            if (ok)
+                std::printf("%-36s %-12s %-10s %10.1f\n", input.name.c_str(), decoder->name(), "serial", mbPerSec);
+
+            if (std::string(format) != "jpeg")
+                continue;
+            Throughput parallel;
+            ok = measure(input, iterations, [&](const BenchInput& in, DecodedImage& image) {
+                return JpegRestart::decodeParallel(in.bytes.data(), in.bytes.size(), *decoder, nrThreads, image);
+            }, parallel, mbPerSec);
+            if (ok) {
+                Throughput& t = totals[key + " parallel"];
+                t.encodedBytes += parallel.encodedBytes;
+                t.pixels += parallel.pixels;
+                t.seconds += parallel.seconds;
+                std::printf("%-36s %-12s %-10s %10.1f\n", input.name.c_str(), decoder->name(), "parallel", mbPerSec);
+            }
+        }
+    }
+
+    std::printf("\n%-32s %10s %12s\n", "format backend mode", "MB/s", "Mpixels/s");
+    for (const auto& [key, t] : totals) {
+        if (t.seconds <= 0.0)
+            continue;
+        std::printf("%-32s %10.1f %12.1f\n", key.c_str(),
+                    t.encodedBytes / t.seconds / (1024.0 * 1024.0), t.pixels / t.seconds / 1e6);
+    }
+    return 0;
+}
@@ -0,0 +1,203 @@
+// Occlusion culler benchmark (CPU only, no GL context needed).
+//
+// usage: occlusion_bench [iterations]
+//
+// A synthetic city: a grid of box buildings of random heights along streets, with small props (cars, kiosks,
+// benches) on the streets, looked at from street level in several directions. Each view rasterizes the buildings
+// near the camera as occluders and tests every building and prop in the view frustum against them. Reports the
+// occluder rasterization rate (triangles per second, setup and binning included), the test rate and the share of
+// in-frustum boxes culled, for the scalar and SIMD kernels and for 1 up to all hardware threads. The program fails
+// if any configuration culls a different set of boxes than the scalar single-threaded one.
+#include "learnopengl/occlusion_culler.h"
+
+#include <glm/glm.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <thread>
+#include <vector>
+
+const int BLOCKS = 40;              // buildings per side
+const float BLOCK_SIZE = 20.0f;     // building footprint plus street
+const float STREET_WIDTH = 8.0f;
+const int PROPS_PER_BLOCK = 12;
+const float OCCLUDER_DISTANCE = 120.0f; // buildings closer than this occlude
+const int NR_VIEWS = 8;
+
+struct Box {
+    glm::vec3 min, max;
+};
+
+struct City {
+    std::vector<Box> buildings;
+    std::vector<Box> props;
+};
+
+City buildCity() {
+    std::mt19937 rng(1234);
+    std::uniform_real_distribution<float> height(8.0f, 60.0f), unit(0.0f, 1.0f);
+    City city;
+    float lot = BLOCK_SIZE - STREET_WIDTH;
+    for (int z = 0; z < BLOCKS; z++) {
+        for (int x = 0; x < BLOCKS; x++) {
+            glm::vec3 corner(x * BLOCK_SIZE, 0.0f, z * BLOCK_SIZE);
+            city.buildings.push_back({ corner, corner + glm::vec3(lot, height(rng), lot) });
+
+            // props on the street along the lot's +x and +z sides
+            for (int i = 0; i < PROPS_PER_BLOCK; i++) {
+                float along = unit(rng) * BLOCK_SIZE, across = lot + 1.0f + unit(rng) * (STREET_WIDTH - 2.0f);
+                glm::vec3 size(1.0f + unit(rng) * 3.0f, 0.8f + unit(rng) * 1.5f, 1.0f + unit(rng) * 1.5f);
+                glm::vec3 position = (i % 2) ? corner + glm::vec3(along, 0.0f, across) : corner + glm::vec3(across, 0.0f, along);
+                city.props.push_back({ position, position + size });
+            }
+        }
+    }
+    return city;
+}
+
+glm::mat4 boxModel(const Box& box) {
+    return glm::scale(glm::translate(glm::mat4(1.0f), (box.min + box.max) * 0.5f), box.max - box.min);
+}
+
+// entirely outside one of the frustum's planes
+bool outsideFrustum(const glm::mat4& viewProjection, const Box& box) {
+    glm::vec4 corners[8];
+    for (int i = 0; i < 8; i++)
+        corners[i] = viewProjection * glm::vec4((i & 4) ? box.max.x : box.min.x, (i & 2) ? box.max.y : box.min.y, (i & 1) ? box.max.z : box.min.z, 1.0f);
+    for (int axis = 0; axis < 3; axis++) {
+        bool allBelow = true, allAbove = true;
+        for (const glm::vec4& corner : corners) {
+            allBelow = allBelow && corner[axis] < -corner.w;
+            allAbove = allAbove && corner[axis] > corner.w;
+        }
+        if (allBelow || allAbove)
+            return true;
+    }
+    return false;
+}
+
+struct View {
+    glm::mat4 viewProjection;
+    std::vector<glm::mat4> occluders;
+    std::vector<Box> occludees; // in the frustum
+};
+
+std::vector<View> buildViews(const City& city) {
+    std::vector<View> views;
+    glm::mat4 projection = glm::perspective(glm::radians(60.0f), 16.0f / 9.0f, 0.1f, 1000.0f);
+    // standing in the middle of a street crossing near the city center, turning around
+    float street = (BLOCKS / 2) * BLOCK_SIZE - STREET_WIDTH * 0.5f;
+    glm::vec3 eye(street, 1.7f, street);
+    for (int i = 0; i < NR_VIEWS; i++) {
+        float angle = glm::radians(360.0f * i / NR_VIEWS + 10.0f);
+        glm::vec3 direction(std::cos(angle), 0.0f, std::sin(angle));
+        View view;
+        view.viewProjection = projection * glm::lookAt(eye, eye + direction, glm::vec3(0.0f, 1.0f, 0.0f));
+        for (const Box& building : city.buildings) {
+            if (outsideFrustum(view.viewProjection, building))
+                continue;
+            glm::vec3 closest = glm::clamp(eye, building.min, building.max);
+            if (glm::length(closest - eye) < OCCLUDER_DISTANCE)
+                view.occluders.push_back(boxModel(building));
+            view.occludees.push_back(building);
+        }
+        for (const Box& prop : city.props)
+            if (!outsideFrustum(view.viewProjection, prop))
+                view.occludees.push_back(prop);
+        views.push_back(view);
+    }
+    return views;
+}
+
+struct Result {
+    double rasterizeMs = 0.0, testMs = 0.0;
+    long triangles = 0, tested = 0, occluded = 0;
+    std::vector<char> culled; // per view and occludee, from the last iteration
+};
+
+Result run(const std::vector<View>& views, bool simd, unsigned int nrThreads, int iterations) {
+    OcclusionCuller culler(256, 144, nrThreads);
+    culler.useSimd = simd;
+    Result result;
+    for (int iteration = 0; iteration < iterations; iteration++) {
+        result.culled.clear();
+        for (const View& view : views) {
+            auto start = std::chrono::steady_clock::now();
+            culler.begin(view.viewProjection);
+            for (const glm::mat4& model : view.occluders)
+                culler.addBoxOccluder(model);
+            culler.rasterize();
+            auto rasterized = std::chrono::steady_clock::now();
+            for (const Box& box : view.occludees)
+                result.culled.push_back(culler.isOccluded(box.min, box.max));
+            auto tested = std::chrono::steady_clock::now();
+
+            result.rasterizeMs += std::chrono::duration<double, std::milli>(rasterized - start).count();
+            result.testMs += std::chrono::duration<double, std::milli>(tested - rasterized).count();
+            result.triangles += culler.stats().rasterizedTriangles;
+            result.tested += culler.stats().tested;
+            result.occluded += culler.stats().occluded;
+        }
+    }
+    return result;
+}
+
+int main(int argc, char** argv) {
+    int iterations = argc > 1 ? std::max(1, std::atoi(argv[1])) : 50;
+
+    City city = buildCity();
+    std::vector<View> views = buildViews(city);
+    std::size_t occluders = 0, occludees = 0;
+    for (const View& view : views) {
+        occluders += view.occluders.size();
+        occludees += view.occludees.size();
+    }
+    std::printf("%zu buildings, %zu props; %d views with %zu occluders and %zu boxes in the frustum on average; "
+                "256x144 depth buffer, %d iterations\n\n", city.buildings.size(), city.props.size(), NR_VIEWS,
+                occluders / views.size(), occludees / views.size(), iterations);
+
+    std::vector<unsigned int> threadCounts = { 1 };
+    unsigned int hardwareThreads = std::max(1u, std::thread::hardware_concurrency());
+    for (unsigned int threads = 2; threads < hardwareThreads; threads *= 2)
+        threadCounts.push_back(threads);
+    if (hardwareThreads > 1)
+        threadCounts.push_back(hardwareThreads);
+
+#if defined(OCCLUSION_CULLER_AVX2)
+    const char* simdName = "AVX2";
+    const int simdKernels = 1;
+#elif defined(OCCLUSION_CULLER_SSE)
+    const char* simdName = "SSE2";
+    const int simdKernels = 1;
+#else
+    const char* simdName = "";
+    const int simdKernels = 0; // the culler only has the scalar ones here
+#endif
+#if defined(__GNUC__) && !defined(__OPTIMIZE__)
+    std::printf("note: built without optimization, the timings below don't reflect the kernels' real speed\n\n");
+#endif
+    std::printf("%-8s %8s %14s %12s %14s %10s\n", "kernels", "threads", "Mtris/s", "ms/view", "Mtests/s", "culled");
+
+    Result reference = run(views, false, 1, iterations);
+    bool mismatch = false;
+    for (int simd = 0; simd <= simdKernels; simd++) {
+        for (unsigned int threads : threadCounts) {
+            Result result = (!simd && threads == 1) ? reference : run(views, simd != 0, threads, iterations);
+            bool same = result.culled == reference.culled;
+            mismatch = mismatch || !same;
+            std::printf("%-8s %8u %14.2f %12.3f %14.2f %9.1f%%%s\n", simd ? simdName : "scalar", threads,
+                        result.triangles / result.rasterizeMs / 1000.0, (result.rasterizeMs + result.testMs) / (iterations * views.size()),
+                        result.tested / result.testMs / 1000.0, 100.0 * result.occluded / result.tested, same ? "" : "  MISMATCH");
+        }
+    }
+
+    if (mismatch) {
+        std::printf("\nERROR: a configuration culled different boxes than the scalar single-threaded one\n");
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,106 @@
+// Render queue sort benchmark (CPU only, no GL context needed).
+//
+// usage: render_queue_bench [iterations]
+//
+// Fills a RenderQueue with draws and times submission and the radix sort against std::stable_sort on the same
+// pairs, for two scenes: a mixed one spread over 32 programs, 256 materials, 64 vertex arrays and random depths,
+// 10% of them translucent, and an opaque one with 8 programs, 32 materials and 16 vertex arrays, whose keys leave
+// more bits constant for the sort to skip. Both sorts have to produce the same order: ascending keys, submission
+// order within equal keys.
+#include "learnopengl/render_queue.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <vector>
+
+const int ITEM_COUNTS[] = { 1000, 10000, 100000 };
+
+struct Draw {
+    unsigned int program, material, vertexArray;
+    bool translucent;
+    float depth;
+};
+
+struct Scene {
+    const char* name;
+    unsigned int programs, materials, vertexArrays;
+    float translucentShare;
+};
+
+const Scene SCENES[] = { { "mixed", 32, 256, 64, 0.1f }, { "opaque", 8, 32, 16, 0.0f } };
+
+std::vector<Draw> makeDraws(const Scene& scene, int count) {
+    std::mt19937 rng(1234);
+    std::uniform_int_distribution<unsigned int> program(1, scene.programs), material(1, scene.materials), vertexArray(1, scene.vertexArrays);
+    std::uniform_real_distribution<float> unit(0.0f, 1.0f);
+    std::vector<Draw> draws(count);
+    for (Draw& draw : draws)
+        draw = { program(rng), material(rng), vertexArray(rng), unit(rng) < scene.translucentShare, unit(rng) };
+    return draws;
+}
+
+void fill(RenderQueue& queue, const std::vector<Draw>& draws) {
+    queue.clear();
+    RenderQueue::Item item;
+    item.count = 36;
+    glm::mat4 model(1.0f);
+    for (const Draw& draw : draws) {
+        item.material = draw.material;
+        item.vertexArray = draw.vertexArray;
+        model[3].z = -draw.depth;
+        queue.submit(item, model, draw.translucent ? RenderKey::translucent(0, draw.program, draw.material, draw.vertexArray, draw.depth)
+                                            : RenderKey::opaque(0, draw.program, draw.material, draw.vertexArray, draw.depth));
+    }
+}
+
+int main(int argc, char** argv) {
+    int iterations = argc > 1 ? std::max(1, std::atoi(argv[1])) : 50;
+    std::printf("%d iterations\n\n", iterations);
+    std::printf("%-8s %-8s %12s %12s %16s %14s\n", "scene", "items", "submit ms", "radix ms", "stable_sort ms", "Mitems/s");
+
+    RenderQueue queue;
+    bool mismatch = false;
+    for (const Scene& scene : SCENES) {
+        for (int count : ITEM_COUNTS) {
+            std::vector<Draw> draws = makeDraws(scene, count);
+            fill(queue, draws); // warm up, grows the buffers
+            queue.sort();
+
+            double submitMs = 0.0, radixMs = 0.0, stableMs = 0.0;
+            std::vector<SortPair> reference;
+            for (int i = 0; i < iterations; i++) {
+                auto start = std::chrono::steady_clock::now();
+                fill(queue, draws);
+                auto filled = std::chrono::steady_clock::now();
+                reference = queue.order();
+                auto copied = std::chrono::steady_clock::now();
+                queue.sort();
+                auto sorted = std::chrono::steady_clock::now();
+                std::stable_sort(reference.begin(), reference.end(), [](const SortPair& a, const SortPair& b) { return a.key < b.key; });
+                auto referenceSorted = std::chrono::steady_clock::now();
+
+                submitMs += std::chrono::duration<double, std::milli>(filled - start).count();
+                radixMs += std::chrono::duration<double, std::milli>(sorted - copied).count();
+                stableMs += std::chrono::duration<double, std::milli>(referenceSorted - sorted).count();
+            }
+            submitMs /= iterations;
+            radixMs /= iterations;
+            stableMs /= iterations;
+
+            const std::vector<SortPair>& order = queue.order();
+            for (std::size_t i = 0; i < order.size(); i++)
+                if (order[i].key != reference[i].key || order[i].value != reference[i].value)
+                    mismatch = true;
+            std::printf("%-8s %-8d %12.3f %12.3f %16.3f %14.1f\n", scene.name, count, submitMs, radixMs, stableMs, count / radixMs / 1000.0);
+        }
+    }
+
+    if (mismatch) {
+        std::printf("\nERROR: radix and stable sort disagree on the order\n");
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,120 @@
+// Ring allocator benchmark (CPU only, no GL context needed).
+//
+// usage: ring_allocator_bench [frames]
+//
+// Streams a frame's worth of uniform blocks and vertex data (random sizes, 4 to 256 byte alignments) through a
+// triple-buffered RingAllocator whose fences come from a simulated GPU running 0 to 4 frames behind the CPU.
+// With 3 regions the CPU only has to wait once the GPU is 3 or more frames behind. Every frame checks that the
+// region handed out was finished by the GPU, that allocations are aligned, inside the region and don't overlap;
+// the program fails if any check does.
+#include "learnopengl/ring_allocator.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <vector>
+
+const std::size_t REGION_SIZE = 4 * 1024 * 1024;
+const int ALLOCATIONS_PER_FRAME = 2000;
+
+// fences are frame numbers; the GPU completes frames on its own schedule, lag frames after they were submitted
+struct SimulatedGpu {
+    typedef long Fence;
+
+    long submitted = 0;
+    long completed = 0;
+    int lag = 0;
+    int errors = 0;
+
+    Fence insert() {
+        return ++submitted;
+    }
+
+    bool signaled(Fence fence) {
+        return completed >= fence;
+    }
+
+    void wait(Fence fence) {
+        completed = std::max(completed, fence);
+    }
+
+    void remove(Fence fence) {
+        if (completed < fence)
+            errors++; // dropped before the GPU was done with it
+    }
+
+    void advance() {
+        completed = std::max(completed, submitted - lag);
+    }
+};
+
+int main(int argc, char** argv) {
+    int frames = argc > 1 ? std::max(1, std::atoi(argv[1])) : 2000;
+
+    // the same allocations every frame and every run
+    std::mt19937 rng(1234);
+    std::uniform_int_distribution<std::size_t> sizes(16, 1024);
+    const std::size_t alignments[] = { 4, 16, 256 };
+    std::vector<std::size_t> requestSizes(ALLOCATIONS_PER_FRAME), requestAlignments(ALLOCATIONS_PER_FRAME);
+    for (int i = 0; i < ALLOCATIONS_PER_FRAME; i++) {
+        requestSizes[i] = sizes(rng);
+        requestAlignments[i] = alignments[rng() % 3];
+    }
+
+    std::printf("%d frames of %d allocations, %zu KB regions\n\n", frames, ALLOCATIONS_PER_FRAME, REGION_SIZE / 1024);
+    std::printf("%-6s %10s %12s %14s %8s\n", "lag", "waits", "bytes/frame", "Mallocs/s", "errors");
+
+    bool failed = false;
+    for (int lag = 0; lag <= 4; lag++) {
+        SimulatedGpu gpu;
+        gpu.lag = lag;
+        RingAllocator<SimulatedGpu> allocator(gpu, REGION_SIZE);
+        std::vector<long> lastWriter(allocator.nrRegions(), 0); // fence of the frame that last wrote each region
+        std::vector<std::size_t> offsets(ALLOCATIONS_PER_FRAME);
+        std::size_t bytes = 0;
+        double allocateMs = 0.0;
+
+        for (int frame = 0; frame < frames; frame++) {
+            allocator.beginFrame();
+            int region = allocator.currentRegion();
+            if (gpu.completed < lastWriter[region])
+                gpu.errors++; // handed out while the GPU could still be reading it
+
+            auto start = std::chrono::steady_clock::now();
+            for (int i = 0; i < ALLOCATIONS_PER_FRAME; i++)
+                offsets[i] = allocator.allocate(requestSizes[i], requestAlignments[i]);
+            allocateMs += std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+            // allocations come out in order, so each has to start past the previous one's end
+            std::size_t regionStart = allocator.regionOffset(region), end = regionStart;
+            for (int i = 0; i < ALLOCATIONS_PER_FRAME; i++) {
+                if (offsets[i] == RingAllocator<SimulatedGpu>::NO_SPACE || offsets[i] % requestAlignments[i] != 0 ||
+                    offsets[i] < end || offsets[i] + requestSizes[i] > regionStart + allocator.regionSize()) {
+                    gpu.errors++;
+                    break;
+                }
+                end = offsets[i] + requestSizes[i];
+            }
+            bytes += allocator.stats().bytes;
+
+            allocator.endFrame();
+            lastWriter[region] = gpu.submitted;
+            gpu.advance();
+        }
+        // the GPU drains before the buffer goes away, so the last fences are dropped signalled too
+        gpu.completed = gpu.submitted;
+        allocator.release();
+
+        std::printf("%-6d %10zu %12zu %14.1f %8d\n", lag, allocator.totalWaits(), bytes / frames,
+                    (double)frames * ALLOCATIONS_PER_FRAME / allocateMs / 1000.0, gpu.errors);
+        failed = failed || gpu.errors > 0;
+    }
+
+    if (failed) {
+        std::printf("\nERROR: a region was reused too early or an allocation was misplaced\n");
+        return 1;
+    }
+    return 0;
+}
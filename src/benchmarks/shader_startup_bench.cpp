@@ -0,0 +1,123 @@
+// Shader startup benchmark: program creation time with a cold and a warm program binary cache.
+//
+// usage: shader_startup_bench [src dir] [runs]
+//
+// Builds every chapter's shader programs in a hidden window. "cold" clears the cache first (compile, link and
+// store), "warm" loads the binaries stored by the cold pass, "no cache" compiles with the cache disabled.
+// The "async" rows submit every program first and only then finish them (Shader::COMPILE_ASYNC), which lets a
+// driver with KHR_parallel_shader_compile spread the work over its compiler threads.
+// Drivers keep caches of their own (e.g. Mesa's shader disk cache, MESA_SHADER_CACHE_DISABLE=1 turns it off),
+// so compare the numbers against each other rather than as absolute compile costs.
+#include <glad/glad.h>
+#include <glfw/glfw3.h>
+
+#include "learnopengl/gl_extensions.h"
+#include "learnopengl/shader.h"
+#include "learnopengl/shader_cache.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <memory>
+#include <string>
+#include <vector>
+
+struct ProgramSources {
+    std::string vertex;
+    std::string fragment;
+};
+
+const std::vector<ProgramSources> PROGRAMS = {
+    { "4.advanced-opengl/vert.glsl", "4.advanced-opengl/frag.glsl" },
+    { "4.advanced-opengl/vert.glsl", "4.advanced-opengl/borderFrag.glsl" },
+    { "4.advanced-opengl/screenVert.glsl", "4.advanced-opengl/screenFrag.glsl" },
+    { "3.model_loading/model/object.vert", "3.model_loading/model/object.frag" },
+    { "2.lighting/16.light_casters/object.vert", "2.lighting/16.light_casters/object.frag" },
+    { "2.lighting/16.light_casters/lamp.vert", "2.lighting/16.light_casters/lamp.frag" },
+    { "2.lighting/15.lighting_maps/object.vert", "2.lighting/15.lighting_maps/object.frag" },
+    { "2.lighting/15.lighting_maps/lamp.vert", "2.lighting/15.lighting_maps/lamp.frag" },
+};
+
+// creates every program and returns the wall time in milliseconds
+double buildAll(const std::string& srcDir, Shader::CompileMode mode) {
+    auto start = std::chrono::steady_clock::now();
+    std::vector<std::unique_ptr<Shader>> shaders;
+    for (const ProgramSources& sources : PROGRAMS)
+        shaders.emplace_back(new Shader((srcDir + sources.vertex).c_str(), (srcDir + sources.fragment).c_str(), ShaderDefines(), mode));
+    std::vector<unsigned int> programs;
+    for (std::unique_ptr<Shader>& shader : shaders) {
+        shader->finish();
+        programs.push_back(shader->ID);
+    }
+    glFinish();
+    double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    for (unsigned int program : programs)
+        glDeleteProgram(program);
+    return ms;
+}
+
+double median(std::vector<double> values) {
+    std::sort(values.begin(), values.end());
+    return values[values.size() / 2];
+}
+
+int main(int argc, char** argv) {
+    std::string srcDir = (argc > 1) ? argv[1] : "../src";
+    if (srcDir.back() != '/')
+        srcDir += '/';
+    const int runs = (argc > 2) ? std::max(1, std::atoi(argv[2])) : 5;
+
+    glfwInit();
+    glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
+    glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
+    glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
+    glfwWindowHint(GLFW_VISIBLE, GLFW_FALSE);
+#ifdef __APPLE__
+    glfwWindowHint(GLFW_OPENGL_FORWARD_COMPAT, GL_TRUE);
+#endif
+    GLFWwindow* window = glfwCreateWindow(64, 64, "shader_startup_bench", NULL, NULL);
+    if (window == NULL) {
+        std::printf("Failed to create GLFW window\n");
+        glfwTerminate();
+        return -1;
+    }
+    glfwMakeContextCurrent(window);
+    if (!gladLoadGLLoader((GLADloadproc)glfwGetProcAddress)) {
+        std::printf("Failed to initialize GLAD\n");
+        return -1;
+    }
+    GLExtensions::load((GLADloadproc)glfwGetProcAddress);
+
+    std::printf("%s / %s\n", glGetString(GL_RENDERER), glGetString(GL_VERSION));
+    if (!GLExtensions::support().programBinary)
+        std::printf("program binaries are not supported by this driver; every run compiles from source\n");
+    ShaderCache::setDirectory(std::filesystem::current_path() / "shader_cache_bench");
+
+    std::printf("parallel shader compile: %s\n", GLExtensions::support().parallelShaderCompile ? "yes" : "no");
+
+    std::vector<double> noCache, noCacheAsync, cold, coldAsync, warm;
+    for (int run = 0; run < runs; run++) {
+        ShaderCache::setEnabled(false);
+        noCache.push_back(buildAll(srcDir, Shader::COMPILE_BLOCKING));
+        noCacheAsync.push_back(buildAll(srcDir, Shader::COMPILE_ASYNC));
+
+        ShaderCache::setEnabled(true);
+        ShaderCache::clear();
+        cold.push_back(buildAll(srcDir, Shader::COMPILE_BLOCKING));
+        warm.push_back(buildAll(srcDir, Shader::COMPILE_BLOCKING));
+        ShaderCache::clear();
+        coldAsync.push_back(buildAll(srcDir, Shader::COMPILE_ASYNC));
+    }
+    ShaderCache::clear();
+
+    std::printf("%zu programs, median of %d runs\n", PROGRAMS.size(), runs);
+    std::printf("  no cache:        %8.2f ms\n", median(noCache));
+    std::printf("  no cache, async: %8.2f ms\n", median(noCacheAsync));
+    std::printf("  cold:            %8.2f ms\n", median(cold));
+    std::printf("  cold, async:     %8.2f ms\n", median(coldAsync));
+    std::printf("  warm:            %8.2f ms\n", median(warm));
+
+    glfwTerminate();
+    return 0;
+}
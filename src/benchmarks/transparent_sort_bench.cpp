@@ -0,0 +1,84 @@
+// Transparent sort benchmark (CPU only, no GL context needed).
+//
+// usage: transparent_sort_bench [iterations]
+//
+// Sorts quads on a grid in front of a camera back to front, the way chapter 4 sorts its windows: with the
+// std::map<float, glm::vec3> it used to rebuild every frame, and with TransparentSorter. The grid puts many quads
+// at exactly the same distance, which the map collapses into one; the sorter has to keep every quad, farthest
+// first, in the order they were added within equal distances (checked against std::stable_sort).
+#include "learnopengl/transparent_sorter.h"
+
+#include <glm/glm.hpp>
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <map>
+#include <vector>
+
+const int QUAD_COUNTS[] = { 1000, 10000, 50000 };
+
+std::vector<glm::vec3> makeQuads(int count) {
+    std::vector<glm::vec3> quads;
+    quads.reserve(count);
+    int side = (int)std::ceil(std::sqrt((float)count));
+    for (int i = 0; i < count; i++)
+        quads.push_back(glm::vec3(0.5f * (i % side - side / 2), 0.0f, -0.5f * (i / side)));
+    return quads;
+}
+
+int main(int argc, char** argv) {
+    int iterations = argc > 1 ? std::max(1, std::atoi(argv[1])) : 50;
+    std::printf("%d iterations\n\n", iterations);
+    std::printf("%-8s %10s %12s %10s %14s %14s\n", "quads", "map ms", "map kept", "radix ms", "radix kept", "Mquads/s");
+
+    const glm::vec3 cameraPos(0.0f, 1.0f, 3.0f);
+    TransparentSorter sorter;
+    bool mismatch = false;
+    for (int count : QUAD_COUNTS) {
+        std::vector<glm::vec3> quads = makeQuads(count);
+        std::vector<float> distances(count);
+        for (int i = 0; i < count; i++)
+            distances[i] = glm::length(cameraPos - quads[i]);
+
+        double mapMs = 0.0, radixMs = 0.0;
+        std::size_t mapKept = 0;
+        for (int i = 0; i < iterations; i++) {
+            auto start = std::chrono::steady_clock::now();
+            std::map<float, glm::vec3> sorted;
+            for (int quad = 0; quad < count; quad++)
+                sorted[glm::length(cameraPos - quads[quad])] = quads[quad];
+            mapKept = sorted.size();
+            auto mapped = std::chrono::steady_clock::now();
+
+            sorter.clear();
+            for (int quad = 0; quad < count; quad++)
+                sorter.add(quad, glm::length(cameraPos - quads[quad]));
+            sorter.sort();
+            auto radixSorted = std::chrono::steady_clock::now();
+
+            mapMs += std::chrono::duration<double, std::milli>(mapped - start).count();
+            radixMs += std::chrono::duration<double, std::milli>(radixSorted - mapped).count();
+        }
+        mapMs /= iterations;
+        radixMs /= iterations;
+
+        std::vector<std::uint32_t> reference(count);
+        for (int i = 0; i < count; i++)
+            reference[i] = i;
+        std::stable_sort(reference.begin(), reference.end(), [&](std::uint32_t a, std::uint32_t b) { return distances[a] > distances[b]; });
+        const std::vector<SortPair>& order = sorter.order();
+        for (int i = 0; i < count; i++)
+            if (order[i].value != reference[i])
+                mismatch = true;
+        std::printf("%-8d %10.3f %12zu %10.3f %14zu %14.1f\n", count, mapMs, mapKept, radixMs, order.size(), count / radixMs / 1000.0);
+    }
+
+    if (mismatch) {
+        std::printf("\nERROR: radix sort and stable sort disagree on the order\n");
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,7 @@
+// per-frame camera data shared by every program (CameraBlock in include/learnopengl/uniform_blocks.h)
+layout (std140) uniform Camera {
+    mat4 view;
+    mat4 projection;
+    mat4 viewProjection;
+    vec3 viewPos;
+};
@@ -0,0 +1,33 @@
+// clustered point lights (ClusteredLighting in include/learnopengl/clustered_lighting.h). needs lights.glsl for
+// the PointLight struct. the grid size must match LightClusters::TILES_X / TILES_Y / SLICES.
+#define CLUSTER_TILES_X 16
+#define CLUSTER_TILES_Y 9
+#define CLUSTER_SLICES  24
+
+uniform samplerBuffer  clusterLights;  // 4 texels per light: PointLight with the radius in the last slot
+uniform usamplerBuffer clusterRanges;  // (offset, count) per cluster
+uniform usamplerBuffer clusterIndices; // light indices
+// xy: tiles per pixel, z/w: depth slice scale/bias (slice = log(depth) * z + w)
+uniform vec4 clusterParams;
+
+// the cluster gl_FragCoord falls in; depth is the positive view-space distance
+int clusterIndex(vec2 fragCoord, float depth) {
+    ivec2 tile = min(ivec2(fragCoord * clusterParams.xy), ivec2(CLUSTER_TILES_X - 1, CLUSTER_TILES_Y - 1));
+    int slice = clamp(int(floor(log(depth) * clusterParams.z + clusterParams.w)), 0, CLUSTER_SLICES - 1);
+    return (slice * CLUSTER_TILES_Y + tile.y) * CLUSTER_TILES_X + tile.x;
+}
+
+PointLight clusterLight(int index, out float radius) {
+    vec4 texel0 = texelFetch(clusterLights, index * 4);
+    vec4 texel1 = texelFetch(clusterLights, index * 4 + 1);
+    vec4 texel2 = texelFetch(clusterLights, index * 4 + 2);
+    vec4 texel3 = texelFetch(clusterLights, index * 4 + 3);
+    radius = texel3.w;
+    return PointLight(texel0.xyz, texel0.w, texel1.xyz, texel1.w, texel2.xyz, texel2.w, texel3.xyz);
+}
+
+// smooth fade to zero at the radius, so the cutoff at the cluster boundary isn't visible
+float clusterLightWindow(float distance, float radius) {
+    float x = clamp(1.0 - pow(distance / radius, 4.0), 0.0, 1.0);
+    return x * x;
+}
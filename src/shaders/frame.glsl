@@ -0,0 +1,6 @@
+// per-frame timing/resolution shared by every program (FrameBlock in include/learnopengl/uniform_blocks.h)
+layout (std140) uniform Frame {
+    vec2 resolution;
+    float time;
+    float deltaTime;
+};
@@ -0,0 +1,30 @@
+// G-buffer encoding shared by the geometry and lighting passes (GBuffer in include/learnopengl/gbuffer.h).
+// needs camera.glsl for the projection used to rebuild positions from depth.
+
+// octahedral normal encoding: the unit sphere folded onto a square, two channels with an even error over all
+// directions. returns [0, 1] for an unsigned normalized target.
+vec2 octWrap(vec2 v) {
+    return (1.0 - abs(v.yx)) * vec2(v.x >= 0.0 ? 1.0 : -1.0, v.y >= 0.0 ? 1.0 : -1.0);
+}
+
+vec2 encodeNormal(vec3 n) {
+    n /= abs(n.x) + abs(n.y) + abs(n.z);
+    vec2 folded = n.z >= 0.0 ? n.xy : octWrap(n.xy);
+    return folded * 0.5 + 0.5;
+}
+
+vec3 decodeNormal(vec2 encoded) {
+    vec2 f = encoded * 2.0 - 1.0;
+    vec3 n = vec3(f, 1.0 - abs(f.x) - abs(f.y));
+    float t = clamp(-n.z, 0.0, 1.0);
+    n.xy += vec2(n.x >= 0.0 ? -t : t, n.y >= 0.0 ? -t : t);
+    return normalize(n);
+}
+
+// view-space position from a depth buffer value; uv is the pixel's position on screen in [0, 1].
+// assumes a symmetric perspective projection (glm::perspective).
+vec3 viewPositionFromDepth(vec2 uv, float depth) {
+    float z = -projection[3][2] / (depth * 2.0 - 1.0 + projection[2][2]);
+    vec2 ndc = uv * 2.0 - 1.0;
+    return vec3(ndc.x * -z / projection[0][0], ndc.y * -z / projection[1][1], z);
+}
@@ -0,0 +1,19 @@
+// per-draw data of an IndirectDrawBuffer (include/learnopengl/indirect_draws.h). include it before any other
+// declaration: with MULTI_DRAW_INDIRECT it enables an extension, which has to come first.
+#ifdef MULTI_DRAW_INDIRECT
+#extension GL_ARB_shader_draw_parameters : require
+#define DRAW_ID gl_DrawIDARB
+#else
+// set per draw when the draws are issued one by one
+uniform int drawID;
+#define DRAW_ID drawID
+#endif
+
+// a model matrix per draw, four RGBA32F texels (columns) each
+uniform samplerBuffer drawData;
+
+mat4 drawModel() {
+    int first = DRAW_ID * 4;
+    return mat4(texelFetch(drawData, first), texelFetch(drawData, first + 1),
+                texelFetch(drawData, first + 2), texelFetch(drawData, first + 3));
+}
@@ -0,0 +1,36 @@
+// per-frame light data shared by every program (LightsBlock in include/learnopengl/uniform_blocks.h)
+#define MAX_POINT_LIGHTS 16 // capacity of the Lights block; must match UniformBlocks::MAX_POINT_LIGHTS
+
+// the light structs live in a std140 block, so every float is packed into the tail of the vec3 before it
+struct DirectionalLight {
+    vec3 direction;
+    vec3 ambient;
+    vec3 diffuse;
+    vec3 specular;
+};
+
+struct PointLight {
+    vec3 position;  float constant;
+    vec3 ambient;   float linear;
+    vec3 diffuse;   float quadratic;
+    vec3 specular;
+};
+
+struct SpotLight {
+    vec3 position;  float constant;
+    vec3 direction; float linear;
+
+    vec3 diffuse;   float quadratic;
+    vec3 specular;  float innerAngle;
+
+    float outerAngle;
+};
+
+// per-frame members last, so they can be rewritten without the rest
+layout (std140) uniform Lights {
+    DirectionalLight dirLight;
+    PointLight pointLights[MAX_POINT_LIGHTS];
+    int nrPointLights;
+    bool flashLightOn;
+    SpotLight flashLight; // attached to the player
+};
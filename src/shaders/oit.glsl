@@ -0,0 +1,12 @@
+// weighted blended order-independent transparency (WeightedBlendedOIT in include/learnopengl/weighted_oit.h).
+// a transparent fragment shader includes this and ends with writeTransparent(color) instead of writing a color.
+layout (location = 1) out vec4 accumulation;
+layout (location = 2) out float weights;
+
+// straight (not premultiplied) color. the weight favors near surfaces, so the nearest layers dominate the average
+// like they would in a sorted blend; it's kept small enough for 16-bit float targets over many layers.
+void writeTransparent(vec4 color) {
+    float weight = clamp(3.0e3 * pow(1.0 - gl_FragCoord.z, 3.0), 1.0e-2, 3.0e3);
+    accumulation = vec4(color.rgb * color.a * weight, color.a);
+    weights = color.a * weight;
+}
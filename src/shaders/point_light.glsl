@@ -0,0 +1,20 @@
+// point light shading shared by the forward and deferred renderers (ViewSpacePointLight in
+// include/learnopengl/light_volumes.h). everything is in view space, so the viewer sits at the origin.
+#define POINT_LIGHT_SHININESS 32.0
+
+// inverse square falloff, windowed to reach zero at the radius the light volume covers
+float pointLightAttenuation(float distance, float radius) {
+    float window = clamp(1.0 - pow(distance / radius, 4.0), 0.0, 1.0);
+    return window * window / (distance * distance + 1.0);
+}
+
+vec3 shadePointLight(vec3 position, vec3 normal, vec3 albedo, float specular, vec4 lightPositionRadius, vec3 lightColor) {
+    vec3 toLight = lightPositionRadius.xyz - position;
+    float distance = length(toLight);
+    vec3 lightDir = toLight / distance;
+    vec3 halfway = normalize(lightDir + normalize(-position));
+
+    vec3 diffuse = max(dot(normal, lightDir), 0.0) * albedo;
+    vec3 highlight = vec3(pow(max(dot(normal, halfway), 0.0), POINT_LIGHT_SHININESS) * specular);
+    return (diffuse + highlight) * lightColor * pointLightAttenuation(distance, lightPositionRadius.w);
+}
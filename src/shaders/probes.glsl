@@ -0,0 +1,33 @@
+// L2 spherical-harmonic irradiance probes on a grid (IrradianceProbes in include/learnopengl/irradiance_probes.h).
+// each probe's 9 RGB coefficients, already convolved with the cosine lobe, fill 7 RGBA texels; slab k of the 3D
+// texture (along z) holds texel k of every probe, so hardware trilinear filtering blends the 8 nearest probes.
+#define PROBE_SLABS 7
+
+uniform sampler3D probeCoefficients;
+uniform vec3 probeGridMin; // first probe
+uniform vec3 probeGridMax; // last probe
+
+// diffuse irradiance arriving at worldPos on a surface facing normal; clamped to the grid's box
+vec3 probeIrradiance(vec3 worldPos, vec3 normal) {
+    ivec3 size = textureSize(probeCoefficients, 0);
+    vec3 counts = vec3(size.xy, size.z / PROBE_SLABS);
+
+    // probes sit on texel centers; staying inside the outer ones keeps filtering within one slab
+    vec3 cell = clamp((worldPos - probeGridMin) / (probeGridMax - probeGridMin), 0.0, 1.0) * (counts - 1.0) + 0.5;
+    vec2 uv = cell.xy / counts.xy;
+    vec4 t[PROBE_SLABS];
+    for (int k = 0; k < PROBE_SLABS; ++k)
+        t[k] = texture(probeCoefficients, vec3(uv, (cell.z + float(k) * counts.z) / float(size.z)));
+
+    vec3 n = normal;
+    vec3 result = t[0].rgb                      * 0.282095
+                + vec3(t[0].a, t[1].rg)         * 0.488603 * n.y
+                + vec3(t[1].ba, t[2].r)         * 0.488603 * n.z
+                + t[2].gba                      * 0.488603 * n.x
+                + t[3].rgb                      * 1.092548 * n.x * n.y
+                + vec3(t[3].a, t[4].rg)         * 1.092548 * n.y * n.z
+                + vec3(t[4].ba, t[5].r)         * 0.315392 * (3.0 * n.z * n.z - 1.0)
+                + t[5].gba                      * 1.092548 * n.x * n.z
+                + t[6].rgb                      * 0.546274 * (n.x * n.x - n.y * n.y);
+    return max(result, vec3(0.0));
+}
@@ -0,0 +1,36 @@
+// cascaded shadow maps for the directional light (CascadedShadowMaps in include/learnopengl/cascaded_shadows.h).
+// the cascade count must match CascadedShadowMaps::NR_CASCADES.
+#define NR_CASCADES 4
+
+uniform sampler2DArrayShadow cascadeShadowMaps;
+uniform mat4 cascadeMatrices[NR_CASCADES]; // world to light clip space
+uniform vec4 cascadeSplits;                // view-space distance at which each cascade ends
+
+// first cascade that reaches depth (the positive view-space distance), NR_CASCADES past the last one
+int shadowCascade(float depth) {
+    for (int i = 0; i < NR_CASCADES; ++i)
+        if (depth < cascadeSplits[i])
+            return i;
+    return NR_CASCADES;
+}
+
+// fraction of the light that reaches worldPos, 3x3 PCF on top of the hardware's 2x2 compare filter. normal and
+// lightDir (towards the light) push the lookup off the surface, more so at grazing angles, against acne.
+float directionalShadow(vec3 worldPos, vec3 normal, vec3 lightDir, float depth) {
+    int cascade = shadowCascade(depth);
+    if (cascade == NR_CASCADES)
+        return 1.0;
+
+    vec2 texelSize = 1.0 / vec2(textureSize(cascadeShadowMaps, 0).xy);
+    // one texel in world units: the cascade's ortho projection maps its width to 2 in clip space
+    float worldTexel = 2.0 * texelSize.x / length(vec3(cascadeMatrices[cascade][0][0], cascadeMatrices[cascade][1][0], cascadeMatrices[cascade][2][0]));
+    float grazing = 1.0 - max(dot(normal, lightDir), 0.0);
+    vec3 offsetPos = worldPos + normal * worldTexel * (1.0 + 2.0 * grazing);
+
+    vec3 coords = (cascadeMatrices[cascade] * vec4(offsetPos, 1.0)).xyz * 0.5 + 0.5;
+    float lit = 0.0;
+    for (int x = -1; x <= 1; ++x)
+        for (int y = -1; y <= 1; ++y)
+            lit += texture(cascadeShadowMaps, vec4(coords.xy + vec2(x, y) * texelSize, float(cascade), coords.z));
+    return lit / 9.0;
+}
@@ -0,0 +1,131 @@
+// CommandList / CommandRecorder test (no GL context needed: recording makes no GL calls).
+//
+// usage: command_list_test
+//
+// Records a frame of draws in chunks on a ThreadPool, the way the chapters do, and checks the merged stream
+// against the same chunks recorded one after the other on this thread: same commands in chunk order whatever
+// thread recorded which chunk, uniform values found at the right offsets after merging, and every draw preceded
+// by the uniforms set for it. Fails (exit code 1) on the first difference.
+#include "learnopengl/command_list.h"
+
+#include <glm/gtc/matrix_transform.hpp>
+
+#include <cstdio>
+#include <cstring>
+#include <thread>
+#include <vector>
+
+const std::size_t NR_ITEMS = 1000;
+const std::size_t CHUNK_SIZE = 64;
+const int ROUNDS = 20;
+
+int failures = 0;
+
+void check(bool condition, const char* what, std::size_t where) {
+    if (!condition && failures++ < 10)
+        std::printf("ERROR: %s (command %zu)\n", what, where);
+}
+
+// a chunk of the frame: every item gets an "index", most a "color" and every fifth a "model" before its draw;
+// items with i % 7 == 3 are skipped, so chunks push different numbers of values
+void recordChunk(CommandList& list, std::size_t first, std::size_t last) {
+    list.useProgram(nullptr); // never executed
+    list.bindVertexArray((unsigned int)(first / CHUNK_SIZE % 3 + 1));
+    for (std::size_t i = first; i < last; i++) {
+        if (i % 7 == 3)
+            continue;
+        list.setInt("index", (int)i);
+        list.setVec4("color", glm::vec4((float)i, i + 0.25f, i + 0.5f, i + 0.75f));
+        if (i % 5 == 0)
+            list.setMat4("model", glm::translate(glm::mat4(1.0f), glm::vec3((float)i, 0.0f, 0.0f)));
+        list.drawArrays(GL_TRIANGLES, (GLint)i, 36);
+        if (i % 3 == 0)
+            std::this_thread::yield(); // shuffle which thread gets which chunk
+    }
+}
+
+std::size_t valueCount(CommandList::Type type) {
+    return type == CommandList::SET_FLOAT ? 1 : type == CommandList::SET_VEC4 ? 4 : type == CommandList::SET_MAT4 ? 16 : 0;
+}
+
+int main() {
+    // the reference: every chunk in order on this thread
+    CommandList expected;
+    for (std::size_t first = 0; first < NR_ITEMS; first += CHUNK_SIZE) {
+        CommandList chunk;
+        recordChunk(chunk, first, std::min(NR_ITEMS, first + CHUNK_SIZE));
+        expected.append(chunk);
+    }
+
+    ThreadPool pool(4);
+    CommandRecorder recorder;
+    CommandList merged;
+    for (int round = 0; round < ROUNDS && failures == 0; round++) {
+        recorder.record(pool, NR_ITEMS, CHUNK_SIZE, recordChunk);
+        recorder.merge(merged);
+        check(recorder.nrLists() == (NR_ITEMS + CHUNK_SIZE - 1) / CHUNK_SIZE, "wrong number of chunk lists", 0);
+        check(recorder.size() == merged.size(), "merged size differs from the chunk lists'", 0);
+        check(merged.size() == expected.size(), "merged size differs from the serial recording", 0);
+        if (merged.size() != expected.size())
+            break;
+
+        // chunk order: the same commands and the same values as the serial recording
+        for (std::size_t i = 0; i < merged.size(); i++) {
+            const CommandList::Command& command = merged.commands()[i];
+            const CommandList::Command& reference = expected.commands()[i];
+            check(std::memcmp(&command, &reference, sizeof(command)) == 0, "command differs from the serial recording", i);
+            std::size_t count = valueCount(command.type);
+            if (count)
+                check(std::memcmp(merged.values(command), expected.values(reference), count * sizeof(float)) == 0,
+                      "uniform value differs from the serial recording", i);
+        }
+
+        // payload offsets: values follow each other without gaps or overlaps across the merged chunks
+        std::uint32_t nextOffset = 0;
+        for (std::size_t i = 0; i < merged.size(); i++) {
+            const CommandList::Command& command = merged.commands()[i];
+            if (!valueCount(command.type))
+                continue;
+            check(command.uniform.offset == nextOffset, "uniform value offset out of sequence", i);
+            nextOffset = command.uniform.offset + (std::uint32_t)valueCount(command.type);
+        }
+
+        // each draw's uniforms come right before it and carry its item's values
+        int index = -1;
+        const float* color = nullptr;
+        const float* model = nullptr;
+        for (std::size_t i = 0; i < merged.size(); i++) {
+            const CommandList::Command& command = merged.commands()[i];
+            switch (command.type) {
+                case CommandList::SET_INT:
+                    index = command.intUniform.value;
+                    color = model = nullptr;
+                    break;
+                case CommandList::SET_VEC4:
+                    color = merged.values(command);
+                    break;
+                case CommandList::SET_MAT4:
+                    model = merged.values(command);
+                    break;
+                case CommandList::DRAW_ARRAYS:
+                    check(index == command.draw.first, "draw without its index set right before it", i);
+                    check(color && color[0] == (float)index && color[3] == index + 0.75f, "draw with another item's color", i);
+                    check((index % 5 == 0) == (model != nullptr), "model set for the wrong draws", i);
+                    check(!model || model[12] == (float)index, "draw with another item's model", i);
+                    index = -1;
+                    color = model = nullptr;
+                    break;
+                default:
+                    break;
+            }
+        }
+    }
+
+    if (failures) {
+        std::printf("ERROR: %d check(s) failed\n", failures);
+        return 1;
+    }
+    std::printf("%d rounds of %zu items in %zu chunks on %u threads: merged streams match\n", ROUNDS, NR_ITEMS,
+                (NR_ITEMS + CHUNK_SIZE - 1) / CHUNK_SIZE, pool.size());
+    return 0;
+}
@@ -0,0 +1,159 @@
+// RingAllocator test (no GL context needed: fences come from a mock).
+//
+// usage: ring_allocator_test
+//
+// Walks a three-region RingAllocator through the cases StreamBuffer relies on: regions handed out in turn and
+// wrapping back to the first, an allocation that doesn't fit at a region's tail failing rather than spilling into
+// the next region, beginFrame() waiting on the oldest fence once every region is in flight (and only then),
+// alignment padding, and release() dropping the outstanding fences. Fails (exit code 1) if any check does.
+#include "learnopengl/ring_allocator.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <vector>
+
+int failures = 0;
+
+#define CHECK(condition) check(condition, #condition, __LINE__)
+
+void check(bool condition, const char* what, int line) {
+    if (!condition) {
+        std::printf("ERROR: line %d: %s\n", line, what);
+        failures++;
+    }
+}
+
+// fences are numbered in insertion order and only signal when the test says so (or something waits on them)
+struct MockFences {
+    typedef int Fence;
+
+    int inserted = 0;
+    std::vector<Fence> signaledFences, waits, removed;
+
+    Fence insert() {
+        return ++inserted;
+    }
+
+    bool signaled(Fence fence) {
+        return std::find(signaledFences.begin(), signaledFences.end(), fence) != signaledFences.end();
+    }
+
+    void wait(Fence fence) {
+        waits.push_back(fence);
+        signaledFences.push_back(fence);
+    }
+
+    void remove(Fence fence) {
+        removed.push_back(fence);
+    }
+};
+
+typedef RingAllocator<MockFences> Allocator;
+
+void testAlignment() {
+    MockFences fences;
+    Allocator allocator(fences, 1000);
+    CHECK(allocator.regionSize() == 1024); // rounded up to MAX_ALIGNMENT
+    CHECK(allocator.nrRegions() == 3);
+
+    allocator.beginFrame();
+    CHECK(allocator.currentRegion() == 0);
+    CHECK(allocator.allocate(1, 4) == 0);
+    CHECK(allocator.allocate(4, 4) == 4);     // 3 bytes of padding
+    CHECK(allocator.allocate(8, 256) == 256); // padded to the next 256
+    CHECK(allocator.allocate(16, 16) == 272);
+    CHECK(allocator.allocate(3, 1) == 288);
+    CHECK(allocator.stats().allocations == 5);
+    CHECK(allocator.stats().bytes == 291);    // padding included
+    allocator.endFrame();
+
+    // later regions start aligned for any allocation too
+    allocator.beginFrame();
+    CHECK(allocator.currentRegion() == 1);
+    CHECK(allocator.allocate(1, 1) == 1024);
+    CHECK(allocator.allocate(64, 256) == 1024 + 256);
+    allocator.endFrame();
+    allocator.release();
+}
+
+void testTail() {
+    MockFences fences;
+    Allocator allocator(fences, 1024);
+    allocator.beginFrame();
+    CHECK(allocator.allocate(1000, 4) == 0);
+
+    // doesn't fit at the tail: fails instead of running into the next region, which the GPU may still be reading
+    CHECK(allocator.allocate(32, 4) == Allocator::NO_SPACE);
+    CHECK(allocator.allocate(24, 16) == Allocator::NO_SPACE); // fits only without the padding
+    CHECK(allocator.stats().failed == 2);
+    // a failed allocation takes nothing: what still fits at the tail is handed out
+    CHECK(allocator.allocate(24, 4) == 1000);
+    CHECK(allocator.allocate(1, 1) == Allocator::NO_SPACE);
+    CHECK(allocator.stats().bytes == 1024);
+    allocator.endFrame();
+
+    // the next frame starts empty in the next region
+    allocator.beginFrame();
+    CHECK(allocator.currentRegion() == 1);
+    CHECK(allocator.stats().failed == 0);
+    CHECK(allocator.allocate(1024, 256) == 1024);
+    allocator.endFrame();
+    allocator.release();
+}
+
+void testWrapAndWait() {
+    MockFences fences;
+    Allocator allocator(fences, 256);
+
+    // the first three frames get a region each, no waiting: nothing is in flight yet
+    for (int frame = 0; frame < 3; frame++) {
+        allocator.beginFrame();
+        CHECK(allocator.currentRegion() == frame);
+        CHECK(!allocator.stats().waited);
+        CHECK(allocator.allocate(16, 16) == allocator.regionOffset(frame));
+        allocator.endFrame();
+    }
+    CHECK(fences.inserted == 3);
+    CHECK(fences.waits.empty());
+
+    // every region in flight and the GPU done with none: the fourth frame wraps back to region 0 and waits on the
+    // oldest fence, the one behind frame 0, and no other
+    allocator.beginFrame();
+    CHECK(allocator.currentRegion() == 0);
+    CHECK(allocator.stats().waited);
+    CHECK(fences.waits == std::vector<int>({ 1 }));
+    CHECK(fences.removed == std::vector<int>({ 1 }));
+    CHECK(allocator.allocate(16, 16) == 0); // the region starts over
+    allocator.endFrame();
+
+    // the GPU caught up with frame 1 on its own: region 1 is reused without waiting
+    fences.signaledFences.push_back(2);
+    allocator.beginFrame();
+    CHECK(allocator.currentRegion() == 1);
+    CHECK(!allocator.stats().waited);
+    CHECK(fences.waits.size() == 1);
+    CHECK(fences.removed == std::vector<int>({ 1, 2 }));
+    allocator.endFrame();
+    CHECK(allocator.totalWaits() == 1);
+
+    // release() drops the fences still out there (frames 2, 3 and 4), once each
+    allocator.release();
+    std::vector<int> removed = fences.removed;
+    std::sort(removed.begin(), removed.end());
+    CHECK(removed == std::vector<int>({ 1, 2, 3, 4, 5 }));
+    allocator.release();
+    CHECK(fences.removed.size() == 5);
+}
+
+int main() {
+    testAlignment();
+    testTail();
+    testWrapAndWait();
+
+    if (failures) {
+        std::printf("ERROR: %d check(s) failed\n", failures);
+        return 1;
+    }
+    std::printf("ring allocator: alignment, region tails, wrap-around and fence waits behave\n");
+    return 0;
+}